@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "typegen.h"
+
+/*
+    Small helpers shared by the benchmarks. Keeping these tiny on
+    purpose: a benchmark should read top to bottom like a test.
+*/
+
+class Stopwatch {
+    using clock = std::chrono::steady_clock;
+
+    clock::time_point _start;
+
+    public:
+
+    Stopwatch() : _start(clock::now()) { }
+
+    void reset() { _start = clock::now(); }
+
+    // seconds since construction or the last reset
+    double elapsed() const {
+        return std::chrono::duration<double>(clock::now() - _start).count();
+    }
+};
+
+/*
+    Samples ranks in [0, n) where rank k is drawn with probability
+    proportional to 1 / (k + 1)^s. Uses an inverted CDF so each draw is
+    one Typegen::unit call and a binary search.
+*/
+class ZipfDistribution {
+    std::vector<double> _cdf;
+
+    public:
+
+    ZipfDistribution(size_t n, double s) : _cdf(n) {
+        double sum = 0;
+        for(size_t k = 0; k < n; k++) {
+            sum += 1.0 / std::pow(static_cast<double>(k + 1), s);
+            _cdf[k] = sum;
+        }
+        for(double & p : _cdf) {
+            p /= sum;
+        }
+    }
+
+    size_t operator()(Typegen & t) const {
+        double u = t.unit<double>();
+        auto it = std::upper_bound(_cdf.begin(), _cdf.end(), u);
+        if(it == _cdf.end()) {
+            --it;
+        }
+        return static_cast<size_t>(it - _cdf.begin());
+    }
+};
+
+// prints "label: value unit" aligned in a column
+inline void report(std::string const & label, double value, std::string const & unit, int precision = 2) {
+    std::cout << "  " << std::left << std::setw(36) << label << std::right
+              << std::setw(12) << std::fixed << std::setprecision(precision) << value
+              << " " << unit << std::endl;
+}
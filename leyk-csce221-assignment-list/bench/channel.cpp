@@ -0,0 +1,72 @@
+#include "bench.h"
+#include "Channel.h"
+
+#include <cstdint>
+#include <memory>
+
+/*
+    Cost of a hop through a coroutine pipeline: N_STAGES forwarding
+    coroutines connected by Channels, all sharing one thread through an
+    Executor. Reports the time per message per stage for a few channel
+    capacities, including the unbuffered rendezvous.
+*/
+
+constexpr size_t N_STAGES = 1000;
+constexpr uint64_t N_MESSAGES = 1 << 12;
+
+static Executor::Task produce(Channel<uint64_t> & out) {
+    for(uint64_t i = 0; i < N_MESSAGES; i++) {
+        co_await out.push(i);
+    }
+    out.close();
+}
+
+static Executor::Task forward(Channel<uint64_t> & in, Channel<uint64_t> & out) {
+    while(std::optional<uint64_t> value = co_await in.pop()) {
+        co_await out.push(*value + 1);
+    }
+    out.close();
+}
+
+static Executor::Task consume(Channel<uint64_t> & in, uint64_t & checksum) {
+    while(std::optional<uint64_t> value = co_await in.pop()) {
+        checksum += *value;
+    }
+}
+
+int main() {
+    std::cout << "Channel: " << N_MESSAGES << " messages through " << N_STAGES
+              << " coroutine stages on one thread" << std::endl;
+
+    for(size_t capacity : { size_t(0), size_t(1), size_t(16), Channel<uint64_t>::UNBOUNDED }) {
+        Executor executor;
+        std::vector<std::unique_ptr<Channel<uint64_t>>> channels;
+        for(size_t s = 0; s <= N_STAGES; s++) {
+            channels.emplace_back(new Channel<uint64_t>(executor, capacity));
+        }
+
+        uint64_t checksum = 0;
+        executor.spawn(produce(*channels.front()));
+        for(size_t s = 0; s < N_STAGES; s++) {
+            executor.spawn(forward(*channels[s], *channels[s + 1]));
+        }
+        executor.spawn(consume(*channels.back(), checksum));
+
+        Stopwatch sw;
+        size_t resumptions = executor.run();
+        double seconds = sw.elapsed();
+
+        if(checksum != N_MESSAGES * (N_MESSAGES - 1) / 2 + N_MESSAGES * N_STAGES) {
+            std::cerr << "wrong result" << std::endl;
+            return 1;
+        }
+
+        std::cout << std::endl << "capacity "
+                  << (capacity == Channel<uint64_t>::UNBOUNDED ? std::string("unbounded") : std::to_string(capacity))
+                  << std::endl;
+        report("time per message per stage", 1e9 * seconds / (N_MESSAGES * N_STAGES), "ns");
+        report("resumptions per message per stage", double(resumptions) / (N_MESSAGES * N_STAGES), "");
+    }
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include "bench.h"
+#include "LRUCache.h"
+
+#include <cstdint>
+
+/*
+    Replays a Zipf-distributed key trace through a look-aside LRUCache:
+    every access is a get, and every miss is followed by a put of the
+    "loaded" value. Reports throughput and hit rate for a few cache sizes.
+*/
+
+constexpr size_t N_KEYS = 1 << 20;
+constexpr size_t N_ACCESSES = 1 << 22;
+constexpr double ZIPF_EXPONENT = 0.99;
+
+int main() {
+    Typegen t;
+    ZipfDistribution zipf(N_KEYS, ZIPF_EXPONENT);
+
+    // Ranks are scattered over the key space so popular keys don't share buckets
+    std::vector<uint64_t> keys(N_KEYS);
+    t.fill(keys.begin(), keys.end());
+
+    std::vector<uint64_t> trace(N_ACCESSES);
+    for(uint64_t & key : trace) {
+        key = keys[zipf(t)];
+    }
+
+    std::cout << "LRUCache: " << N_ACCESSES << " accesses over " << N_KEYS
+              << " keys, zipf s = " << ZIPF_EXPONENT << std::endl;
+
+    for(size_t capacity : { N_KEYS / 1000, N_KEYS / 100, N_KEYS / 10 }) {
+        LRUCache<uint64_t, uint64_t> cache(capacity);
+        uint64_t checksum = 0;
+
+        Stopwatch sw;
+        for(uint64_t key : trace) {
+            if(uint64_t * value = cache.get(key)) {
+                checksum += *value;
+            } else {
+                cache.put(key, key ^ 0x5555);
+            }
+        }
+        double seconds = sw.elapsed();
+
+        std::cout << std::endl << "capacity " << capacity << " (checksum " << checksum << ")" << std::endl;
+        report("time per access", 1e9 * seconds / N_ACCESSES, "ns");
+        report("hit rate", 100.0 * cache.hits() / N_ACCESSES, "%");
+        report("evictions", static_cast<double>(cache.evictions()), "", 0);
+    }
+
+    return 0;
+}
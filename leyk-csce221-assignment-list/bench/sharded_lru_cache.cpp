@@ -0,0 +1,101 @@
+#include "bench.h"
+#include "ShardedLRUCache.h"
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+/*
+    Throughput of a read-heavy Zipf workload as threads are added, for
+    a single mutex around one LRUCache and for ShardedLRUCache with exact
+    and buffered reads. Misses are followed by a put, like a look-aside
+    cache in front of a slower store.
+*/
+
+constexpr size_t N_KEYS = 1 << 18;
+constexpr size_t CAPACITY = N_KEYS / 8;
+constexpr size_t N_ACCESSES_PER_THREAD = 1 << 20;
+constexpr double ZIPF_EXPONENT = 0.99;
+
+class LockedLRUCache {
+    std::mutex _lock;
+    LRUCache<uint64_t, uint64_t> _cache;
+
+    public:
+
+    LockedLRUCache(size_t capacity) : _cache(capacity) { }
+
+    std::optional<uint64_t> get(uint64_t key) {
+        std::lock_guard<std::mutex> guard(_lock);
+        if(uint64_t * value = _cache.get(key)) {
+            return *value;
+        }
+        return std::nullopt;
+    }
+
+    void put(uint64_t key, uint64_t value) {
+        std::lock_guard<std::mutex> guard(_lock);
+        _cache.put(key, value);
+    }
+};
+
+template<typename Cache>
+double replay(Cache & cache, std::vector<std::vector<uint64_t>> const & traces, size_t n_threads) {
+    std::vector<std::thread> threads;
+    Stopwatch sw;
+    for(size_t tid = 0; tid < n_threads; tid++) {
+        threads.emplace_back([&cache, &trace = traces[tid]]() {
+            for(uint64_t key : trace) {
+                if(!cache.get(key)) {
+                    cache.put(key, key ^ 0x5555);
+                }
+            }
+        });
+    }
+    for(std::thread & thread : threads) {
+        thread.join();
+    }
+    double seconds = sw.elapsed();
+    return n_threads * N_ACCESSES_PER_THREAD / seconds / 1e6;
+}
+
+int main() {
+    Typegen t;
+    ZipfDistribution zipf(N_KEYS, ZIPF_EXPONENT);
+
+    std::vector<uint64_t> keys(N_KEYS);
+    t.fill(keys.begin(), keys.end());
+
+    size_t max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    std::vector<std::vector<uint64_t>> traces(std::max<size_t>(max_threads, 8));
+    for(auto & trace : traces) {
+        trace.resize(N_ACCESSES_PER_THREAD);
+        for(uint64_t & key : trace) {
+            key = keys[zipf(t)];
+        }
+    }
+
+    std::cout << "LRU caches: " << N_ACCESSES_PER_THREAD << " accesses per thread, "
+              << N_KEYS << " keys, capacity " << CAPACITY << ", "
+              << max_threads << " hardware threads" << std::endl;
+
+    for(size_t n_threads = 1; n_threads <= traces.size(); n_threads *= 2) {
+        std::cout << std::endl << n_threads << " thread(s)" << std::endl;
+
+        {
+            LockedLRUCache cache(CAPACITY);
+            report("single mutex", replay(cache, traces, n_threads), "Mops/s");
+        }
+        {
+            ShardedLRUCache<uint64_t, uint64_t> cache(CAPACITY, 64, false);
+            report("sharded, exact reads", replay(cache, traces, n_threads), "Mops/s");
+        }
+        {
+            ShardedLRUCache<uint64_t, uint64_t> cache(CAPACITY, 64, true);
+            report("sharded, buffered reads", replay(cache, traces, n_threads), "Mops/s");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include "bench.h"
+#include "BinarySearchTree.h"
+#include "SkipList.h"
+
+#include <cstdint>
+#include <numeric>
+#include <thread>
+
+/*
+    SkipList against the BinarySearchTree assignment: insert and find on
+    random and on sorted keys, where the unbalanced tree degenerates into a
+    list. The sorted run is kept small since the tree's insert recurses
+    once per level. Finally, insert_concurrent throughput as writer
+    threads are added.
+*/
+
+constexpr size_t N_RANDOM = 1 << 18;
+constexpr size_t N_SORTED = 1 << 13;
+constexpr size_t N_CONCURRENT = 1 << 20;
+
+template <typename Insert, typename Find>
+void measure(std::string const & name, std::vector<uint64_t> const & keys, Insert insert, Find find) {
+    Stopwatch sw;
+    for(uint64_t key : keys) {
+        insert(key);
+    }
+    double insert_seconds = sw.elapsed();
+
+    uint64_t checksum = 0;
+    sw.reset();
+    for(uint64_t key : keys) {
+        checksum += find(key);
+    }
+    double find_seconds = sw.elapsed();
+
+    if(checksum != std::accumulate(keys.begin(), keys.end(), uint64_t(0))) {
+        std::cerr << name << ": wrong result" << std::endl;
+    }
+    report(name + " insert", 1e9 * insert_seconds / keys.size(), "ns/op");
+    report(name + " find", 1e9 * find_seconds / keys.size(), "ns/op");
+}
+
+void compare(std::string const & label, std::vector<uint64_t> const & keys) {
+    std::cout << std::endl << label << ", " << keys.size() << " keys" << std::endl;
+    {
+        BinarySearchTree<uint64_t, uint64_t> tree;
+        measure("BinarySearchTree", keys,
+            [&](uint64_t key) { tree.insert({ key, key }); },
+            [&](uint64_t key) { return tree.find(key); });
+    }
+    {
+        SkipList<uint64_t, uint64_t> list;
+        measure("SkipList", keys,
+            [&](uint64_t key) { list.insert({ key, key }); },
+            [&](uint64_t key) { return list.find(key)->second; });
+    }
+}
+
+int main() {
+    Typegen t;
+
+    std::vector<uint64_t> random(N_RANDOM);
+    t.fill(random.begin(), random.end());
+
+    std::vector<uint64_t> sorted(N_SORTED);
+    std::iota(sorted.begin(), sorted.end(), 0);
+
+    std::cout << "Ordered maps: BinarySearchTree vs SkipList" << std::endl;
+    compare("random keys", random);
+    compare("sorted keys", sorted);
+
+    std::vector<uint64_t> keys(N_CONCURRENT);
+    t.fill(keys.begin(), keys.end());
+
+    size_t max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    std::cout << std::endl << "SkipList::insert_concurrent, " << N_CONCURRENT << " keys, "
+              << max_threads << " hardware threads" << std::endl;
+    for(size_t n_threads = 1; n_threads <= std::max<size_t>(max_threads, 4); n_threads *= 2) {
+        SkipList<uint64_t, uint64_t> list;
+        std::vector<std::thread> threads;
+        Stopwatch sw;
+        for(size_t tid = 0; tid < n_threads; tid++) {
+            threads.emplace_back([&, tid]() {
+                for(size_t i = tid; i < keys.size(); i += n_threads) {
+                    list.insert_concurrent({ keys[i], keys[i] });
+                }
+            });
+        }
+        for(std::thread & thread : threads) {
+            thread.join();
+        }
+        double seconds = sw.elapsed();
+        report(std::to_string(n_threads) + " thread(s)", N_CONCURRENT / seconds / 1e6, "Mops/s");
+    }
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include "bench.h"
+#include "TaskScheduler.h"
+
+#include <cstdint>
+#include <thread>
+
+/*
+    Scaling of a recursive divide-and-conquer workload on the
+    work-stealing TaskScheduler: a top-down merge sort which forks both
+    halves and merges sequentially, plus a fine-grained recursive fib
+    that stresses the fork/join overhead itself.
+*/
+
+constexpr size_t N_ELEMENTS = 1 << 22;
+constexpr size_t SORT_CUTOFF = 1 << 12;
+constexpr uint64_t FIB_N = 30;
+constexpr uint64_t FIB_CUTOFF = 12;
+
+static void merge_sort(uint64_t * first, uint64_t * last, uint64_t * scratch) {
+    size_t n = last - first;
+    if(n <= SORT_CUTOFF) {
+        std::sort(first, last);
+        return;
+    }
+    uint64_t * mid = first + n / 2;
+    TaskScheduler::fork_join(
+        [&]() { merge_sort(first, mid, scratch); },
+        [&]() { merge_sort(mid, last, scratch + n / 2); }
+    );
+    std::merge(first, mid, mid, last, scratch);
+    std::copy(scratch, scratch + n, first);
+}
+
+static uint64_t fib(uint64_t n) {
+    if(n < FIB_CUTOFF) {
+        return n < 2 ? n : fib(n - 1) + fib(n - 2);
+    }
+    uint64_t a = 0, b = 0;
+    TaskScheduler::fork_join([&]() { a = fib(n - 1); }, [&]() { b = fib(n - 2); });
+    return a + b;
+}
+
+int main() {
+    Typegen t;
+    std::vector<uint64_t> input(N_ELEMENTS);
+    t.fill(input.begin(), input.end());
+
+    std::vector<uint64_t> expected = input;
+    Stopwatch sw;
+    std::sort(expected.begin(), expected.end());
+    double sort_baseline = sw.elapsed();
+
+    sw.reset();
+    uint64_t fib_expected = fib(FIB_N);
+    double fib_baseline = sw.elapsed();
+
+    size_t max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    std::cout << "TaskScheduler: merge sort of " << N_ELEMENTS << " integers, fib(" << FIB_N
+              << "), " << max_threads << " hardware threads" << std::endl << std::endl;
+    report("std::sort", 1e3 * sort_baseline, "ms");
+    report("sequential fib", 1e3 * fib_baseline, "ms");
+
+    for(size_t n_threads = 1; n_threads <= std::max<size_t>(max_threads, 4); n_threads *= 2) {
+        TaskScheduler pool(n_threads);
+        std::cout << std::endl << n_threads << " worker(s)" << std::endl;
+
+        std::vector<uint64_t> data = input;
+        std::vector<uint64_t> scratch(N_ELEMENTS);
+        sw.reset();
+        pool.run([&]() { merge_sort(data.data(), data.data() + data.size(), scratch.data()); });
+        double sort_seconds = sw.elapsed();
+
+        uint64_t fib_result = 0;
+        sw.reset();
+        pool.run([&]() { fib_result = fib(FIB_N); });
+        double fib_seconds = sw.elapsed();
+
+        if(data != expected || fib_result != fib_expected) {
+            std::cerr << "wrong result" << std::endl;
+            return 1;
+        }
+
+        report("parallel merge sort", 1e3 * sort_seconds, "ms");
+        report("  speedup over std::sort", sort_baseline / sort_seconds, "x");
+        report("parallel fib", 1e3 * fib_seconds, "ms");
+        report("  speedup over sequential", fib_baseline / fib_seconds, "x");
+    }
+
+    return 0;
+}
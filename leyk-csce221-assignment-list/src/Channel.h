@@ -0,0 +1,184 @@
+#pragma once
+
+#include <coroutine> // std::coroutine_handle
+#include <cstddef>   // size_t
+#include <cstdint>   // SIZE_MAX
+#include <optional>  // std::optional
+#include <utility>   // std::move
+
+#include "Executor.h"
+#include "Queue.h"
+
+/*
+    Coroutine channel over a Queue.
+
+    co_await channel.push(value) and co_await channel.pop() complete at once
+    when the buffer has room or data; otherwise the coroutine suspends on the
+    channel instead of blocking its thread. A push that meets a waiting pop
+    (or the reverse) hands the value straight across and schedules the
+    sleeping side on the executor.
+
+    capacity bounds how many values may sit in the buffer; pushes beyond it
+    wait for a pop. A capacity of 0 makes every push wait for a matching pop.
+
+    After close(), pending and future pushes fail, and pops drain what is
+    buffered and then return std::nullopt. The channel is not thread-safe;
+    all coroutines using it belong to one Executor.
+*/
+template <typename T>
+class Channel {
+    public:
+
+    using value_type = T;
+    using size_type = size_t;
+
+    static constexpr size_type UNBOUNDED = SIZE_MAX;
+
+    class PopAwaiter;
+    class PushAwaiter;
+
+    private:
+
+    Executor & _executor;
+    Queue<T> _buffer;
+    size_type _capacity;
+    bool _closed;
+
+    // coroutines suspended in pop() and push(), in arrival order
+    Queue<PopAwaiter *> _pops;
+    Queue<PushAwaiter *> _pushes;
+
+    // moves the longest waiting push into the buffer and wakes it
+    void _admit_push() {
+        PushAwaiter * waiter = _pushes.front();
+        _pushes.pop();
+        _buffer.push(std::move(waiter->_value));
+        waiter->_ok = true;
+        _executor.schedule(waiter->_handle);
+    }
+
+    public:
+
+    class PopAwaiter {
+        friend class Channel;
+
+        Channel & _channel;
+        std::optional<T> _value;
+        std::coroutine_handle<> _handle;
+
+        explicit PopAwaiter(Channel & channel) : _channel(channel) { }
+
+        public:
+
+        bool await_ready() {
+            _value = _channel.try_pop();
+            return _value || _channel._closed;
+        }
+        void await_suspend(std::coroutine_handle<> handle) {
+            _handle = handle;
+            _channel._pops.push(this);
+        }
+        std::optional<T> await_resume() { return std::move(_value); }
+    };
+
+    class PushAwaiter {
+        friend class Channel;
+
+        Channel & _channel;
+        T _value;
+        bool _ok;
+        std::coroutine_handle<> _handle;
+
+        PushAwaiter(Channel & channel, T && value) : _channel(channel), _value(std::move(value)), _ok(false) { }
+
+        public:
+
+        bool await_ready() {
+            if(_channel._closed) {
+                return true;
+            }
+            _ok = _channel.try_push(std::move(_value));
+            return _ok;
+        }
+        void await_suspend(std::coroutine_handle<> handle) {
+            _handle = handle;
+            _channel._pushes.push(this);
+        }
+        // false if the channel was closed before the value was accepted
+        bool await_resume() { return _ok; }
+    };
+
+    explicit Channel(Executor & executor, size_type capacity = UNBOUNDED)
+        : _executor(executor), _capacity(capacity), _closed(false) { }
+
+    Channel(const Channel &) = delete;
+    Channel & operator=(const Channel &) = delete;
+
+    PopAwaiter pop() { return PopAwaiter(*this); }
+    PushAwaiter push(const T & value) { return PushAwaiter(*this, T(value)); }
+    PushAwaiter push(T && value) { return PushAwaiter(*this, std::move(value)); }
+
+    /*
+        Non-suspending push, usable outside a coroutine. Returns false, leaving
+        value untouched, if the channel is closed or full.
+    */
+    bool try_push(T && value) {
+        if(_closed) {
+            return false;
+        }
+        if(!_pops.empty()) {
+            PopAwaiter * waiter = _pops.front();
+            _pops.pop();
+            waiter->_value = std::move(value);
+            _executor.schedule(waiter->_handle);
+            return true;
+        }
+        if(_buffer.size() >= _capacity) {
+            return false;
+        }
+        _buffer.push(std::move(value));
+        return true;
+    }
+    bool try_push(const T & value) {
+        T copy(value);
+        return try_push(std::move(copy));
+    }
+
+    // non-suspending pop, std::nullopt if nothing is buffered or waiting to be pushed
+    std::optional<T> try_pop() {
+        if(!_buffer.empty()) {
+            std::optional<T> value(std::move(_buffer.front()));
+            _buffer.pop();
+            if(!_pushes.empty()) {
+                _admit_push();
+            }
+            return value;
+        }
+        if(!_pushes.empty()) {
+            // unbuffered hand-off from a waiting push
+            _admit_push();
+            std::optional<T> value(std::move(_buffer.front()));
+            _buffer.pop();
+            return value;
+        }
+        return std::nullopt;
+    }
+
+    // fails every waiting push and wakes every waiting pop with std::nullopt
+    void close() {
+        _closed = true;
+        while(!_pushes.empty()) {
+            _executor.schedule(_pushes.front()->_handle);
+            _pushes.pop();
+        }
+        while(!_pops.empty()) {
+            _executor.schedule(_pops.front()->_handle);
+            _pops.pop();
+        }
+    }
+
+    bool closed() const { return _closed; }
+    bool empty() const { return _buffer.empty(); }
+    size_type size() const { return _buffer.size(); }
+    size_type capacity() const { return _capacity; }
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#if __cplusplus < 202002L
+#error "Executor.h needs C++20 coroutines (-std=c++20)"
+#endif
+
+#include <coroutine> // std::coroutine_handle, std::suspend_always
+#include <cstddef>   // size_t
+#include <exception> // std::terminate
+#include <utility>   // std::exchange
+
+#include "List.h"
+#include "Queue.h"
+
+/*
+    Minimal single-threaded executor for coroutine tasks.
+
+    A coroutine returning Executor::Task starts suspended; spawn() hands it to
+    the executor, which resumes it from run(). Whatever wakes a suspended
+    coroutine (a Channel, for one) calls schedule() instead of resuming it
+    inline, so wake-ups never nest and the stack stays flat no matter how
+    many stages a pipeline has.
+
+    Finished tasks free their own frames. Tasks still suspended when the
+    executor is destroyed are destroyed with it. Tasks must not throw.
+*/
+class Executor {
+    public:
+
+    using size_type = size_t;
+
+    class Task;
+
+    private:
+
+    Queue<std::coroutine_handle<>> _ready;
+    // every spawned task that has not finished yet
+    List<std::coroutine_handle<>> _tasks;
+
+    public:
+
+    class Task {
+        public:
+
+        struct promise_type {
+            Executor * executor = nullptr;
+            List<std::coroutine_handle<>>::iterator registration;
+
+            // unregisters and frees the frame once the coroutine body returns
+            struct FinalAwaiter {
+                bool await_ready() noexcept { return false; }
+                void await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                    promise_type & promise = handle.promise();
+                    promise.executor->_tasks.erase(promise.registration);
+                    handle.destroy();
+                }
+                void await_resume() noexcept { }
+            };
+
+            Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return { }; }
+            FinalAwaiter final_suspend() noexcept { return { }; }
+            void return_void() { }
+            void unhandled_exception() { std::terminate(); }
+        };
+
+        Task(Task && other) noexcept : _handle(std::exchange(other._handle, nullptr)) { }
+        Task(const Task &) = delete;
+        Task & operator=(const Task &) = delete;
+        Task & operator=(Task &&) = delete;
+
+        // a task that was never spawned still owns its frame
+        ~Task() {
+            if(_handle) {
+                _handle.destroy();
+            }
+        }
+
+        private:
+
+        friend class Executor;
+
+        std::coroutine_handle<promise_type> _handle;
+
+        explicit Task(std::coroutine_handle<promise_type> handle) : _handle(handle) { }
+    };
+
+    Executor() = default;
+    Executor(const Executor &) = delete;
+    Executor & operator=(const Executor &) = delete;
+
+    ~Executor() {
+        for(std::coroutine_handle<> handle : _tasks) {
+            handle.destroy();
+        }
+    }
+
+    // takes ownership of task and queues it to start on the next run
+    void spawn(Task task) {
+        std::coroutine_handle<Task::promise_type> handle = std::exchange(task._handle, nullptr);
+        _tasks.push_back(handle);
+        handle.promise().executor = this;
+        handle.promise().registration = --_tasks.end();
+        schedule(handle);
+    }
+
+    // queues a suspended coroutine to be resumed
+    void schedule(std::coroutine_handle<> handle) { _ready.push(handle); }
+
+    // resumes one ready coroutine, returns false if none was ready
+    bool run_one() {
+        if(_ready.empty()) {
+            return false;
+        }
+        std::coroutine_handle<> handle = _ready.front();
+        _ready.pop();
+        handle.resume();
+        return true;
+    }
+
+    // resumes coroutines until none is ready and returns how many resumptions ran
+    size_type run() {
+        size_type n = 0;
+        while(run_one()) {
+            n++;
+        }
+        return n;
+    }
+
+    // spawned tasks that have not finished, whether ready or suspended
+    size_type pending() const { return _tasks.size(); }
+};
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <cstddef>    // size_t
+#include <functional> // std::hash, std::function
+#include <stdexcept>  // std::invalid_argument
+#include <utility>    // std::pair
+
+#include "List.h"
+#include "UnorderedMap.h"
+
+/*
+    Least-recently-used cache.
+
+    Entries live in a List ordered from most to least recently used. An
+    UnorderedMap indexes the list nodes by key so a lookup is one hash probe,
+    and a hit splices its node to the front without copying or allocating.
+    When a put would exceed the capacity, the entry at the back of the list is
+    handed to the eviction callback (if any) and removed.
+
+    The capacity must be nonzero; the constructor throws std::invalid_argument
+    otherwise, since a put would have nothing to evict.
+*/
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename Pred = std::equal_to<Key>>
+class LRUCache {
+    public:
+
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using size_type = size_t;
+    using reference = value_type &;
+    using const_reference = const value_type &;
+
+    private:
+
+    using list_type = List<value_type>;
+
+    public:
+
+    using iterator = typename list_type::iterator;
+    using const_iterator = typename list_type::const_iterator;
+    using eviction_callback = std::function<void(const key_type &, mapped_type &)>;
+
+    private:
+
+    list_type _entries;
+    UnorderedMap<Key, iterator, Hash, Pred> _index;
+    size_type _capacity;
+    eviction_callback _on_evict;
+
+    size_type _hits;
+    size_type _misses;
+    size_type _evictions;
+
+    // removes the least recently used entry
+    void _evict() {
+        iterator victim = --_entries.end();
+        if(_on_evict) {
+            _on_evict(victim->first, victim->second);
+        }
+        _index.erase(victim->first);
+        _entries.erase(victim);
+        _evictions++;
+    }
+
+    public:
+
+    // the index never holds more than capacity keys, so size its buckets to match
+    explicit LRUCache(size_type capacity, eviction_callback on_evict = eviction_callback { },
+                const Hash & hash = Hash { }, const Pred & equal = Pred { })
+        : _entries()
+        , _index(capacity, hash, equal)
+        , _capacity(capacity)
+        , _on_evict(std::move(on_evict))
+        , _hits(0)
+        , _misses(0)
+        , _evictions(0)
+    {
+        if(capacity == 0) {
+            throw std::invalid_argument("LRUCache capacity must be nonzero");
+        }
+    }
+
+    // the index stores iterators into _entries, so copies would alias the source
+    LRUCache(const LRUCache &) = delete;
+    LRUCache & operator=(const LRUCache &) = delete;
+
+    /*
+        Looks up key. On a hit the entry becomes the most recently used and an
+        iterator to it is returned; on a miss end() is returned.
+    */
+    iterator find(const Key & key) {
+        auto it = _index.find(key);
+        if(it == _index.end()) {
+            _misses++;
+            return end();
+        }
+        _hits++;
+        touch(it->second);
+        return it->second;
+    }
+
+    // looks up key without updating the recency order or the hit/miss counters
+    iterator peek(const Key & key) { return peek_hashed(key, _index.hash_function()(key)); }
+
+    /*
+        peek, put and erase for a key the caller has already hashed with
+        Hash, as ShardedLRUCache does to pick the shard; code must be
+        Hash()(key). The key is not hashed again.
+    */
+    iterator peek_hashed(const Key & key, size_type code) {
+        auto it = _index.find_hashed(key, code);
+        if(it == _index.end()) {
+            return end();
+        }
+        return it->second;
+    }
+
+    // makes the entry at it the most recently used
+    void touch(iterator it) { _entries.splice(_entries.begin(), _entries, it); }
+
+    // returns a pointer to the cached value or nullptr on a miss
+    T * get(const Key & key) {
+        iterator it = find(key);
+        if(it == end()) {
+            return nullptr;
+        }
+        return &(it->second);
+    }
+
+    /*
+        Inserts or assigns value for key and makes it the most recently used
+        entry, evicting the least recently used entry if the cache is full.
+        Returns an iterator to the entry and whether a new entry was inserted.
+        Does not count as a hit or a miss.
+    */
+    std::pair<iterator, bool> put(const Key & key, T value) {
+        return put_hashed(key, _index.hash_function()(key), std::move(value));
+    }
+
+    // hashes key neither for the lookup nor for the insertion
+    std::pair<iterator, bool> put_hashed(const Key & key, size_type code, T value) {
+        auto it = _index.find_hashed(key, code);
+        if(it != _index.end()) {
+            it->second->second = std::move(value);
+            touch(it->second);
+            return std::make_pair(it->second, false);
+        }
+
+        if(_entries.size() >= _capacity) {
+            _evict();
+        }
+
+        _entries.push_front(value_type(key, std::move(value)));
+        _index.try_emplace_hashed(key, code, _entries.begin());
+        return std::make_pair(_entries.begin(), true);
+    }
+
+    // removes key without invoking the eviction callback, returns 0 or 1
+    size_type erase(const Key & key) { return erase_hashed(key, _index.hash_function()(key)); }
+
+    size_type erase_hashed(const Key & key, size_type code) {
+        auto it = _index.find_hashed(key, code);
+        if(it == _index.end()) {
+            return 0;
+        }
+        _entries.erase(it->second);
+        _index.erase(it);
+        return 1;
+    }
+
+    void clear() noexcept {
+        _index.clear();
+        _entries.clear();
+    }
+
+    size_type size() const noexcept { return _entries.size(); }
+    size_type capacity() const noexcept { return _capacity; }
+    bool empty() const noexcept { return _entries.empty(); }
+
+    // iterates from most to least recently used without touching entries
+    iterator begin() noexcept { return _entries.begin(); }
+    iterator end() noexcept { return _entries.end(); }
+    const_iterator cbegin() const noexcept { return _entries.cbegin(); }
+    const_iterator cend() const noexcept { return _entries.cend(); }
+
+    size_type hits() const noexcept { return _hits; }
+    size_type misses() const noexcept { return _misses; }
+    size_type evictions() const noexcept { return _evictions; }
+
+    void reset_stats() noexcept {
+        _hits = 0;
+        _misses = 0;
+        _evictions = 0;
+    }
+};
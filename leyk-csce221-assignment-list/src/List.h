@@ -351,6 +351,26 @@ public:
         return iterator(copy);
     }
 
+    void splice( const_iterator pos, List& other, const_iterator it ) {
+        // Relinks the node at it (owned by other) so that it sits before pos.
+        // No elements are copied or moved and no memory is allocated, so
+        // iterators to the moved element stay valid and now refer into this list.
+        Node* node = it.node;
+        if(node == pos.node || node->next == pos.node) {
+            return;
+        }
+        // unlink from other
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+        // link in before pos
+        node->next = pos.node;
+        node->prev = pos.node->prev;
+        pos.node->prev->next = node;
+        pos.node->prev = node;
+        other._size--;
+        _size++;
+    }
+
     void push_back( const T& value ) {
         // TODO
         Node* node = new Node(value);
@@ -397,15 +417,19 @@ public:
       for the const_iterator methods provided above.
     */
     iterator insert( iterator pos, const T & value) { 
-        return insert((const_iterator &) (pos), value);
+        return insert(const_iterator(pos.node), value);
     }
 
     iterator insert( iterator pos, T && value ) {
-        return insert((const_iterator &) (pos), std::move(value));
+        return insert(const_iterator(pos.node), std::move(value));
     }
 
     iterator erase( iterator pos ) {
-        return erase((const_iterator&)(pos));
+        return erase(const_iterator(pos.node));
+    }
+
+    void splice( iterator pos, List& other, iterator it ) {
+        splice(const_iterator(pos.node), other, const_iterator(it.node));
     }
 };
 
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <atomic>       // std::atomic
+#include <cstddef>      // size_t
+#include <cstdint>      // uint64_t
+#include <functional>   // std::hash
+#include <memory>       // std::unique_ptr
+#include <mutex>        // std::unique_lock
+#include <optional>     // std::optional
+#include <shared_mutex> // std::shared_mutex, std::shared_lock
+#include <vector>       // std::vector
+
+#include "LRUCache.h"
+
+/*
+    Thread-safe LRU cache split into independently locked shards.
+
+    Each key is routed to one shard by its (mixed) hash, and every shard is a
+    plain LRUCache holding capacity / n_shards entries behind its own
+    std::shared_mutex. Threads touching different shards never contend. Keys
+    are hashed once: the shard's cache gets the same code through its
+    *_hashed members.
+
+    Reads come in two flavours, chosen at construction:
+
+    - Exact: a get takes the shard's exclusive lock and moves the hit to the
+      front immediately, so each shard is a true LRU.
+    - Buffered: a get only takes the shard's shared lock, so hits on the same
+      shard run concurrently. Instead of relinking the node the reader appends
+      it to a fixed-size recency buffer with a single atomic increment. The
+      buffer is replayed in order the next time the shard is locked
+      exclusively (any put or erase, or a reader finding the buffer full).
+      If the buffer is full the recency update is dropped, which is what
+      bounds the reader's work; eviction order is then approximately LRU.
+
+    Every exclusive section drains the buffer before it modifies the shard, so
+    buffered iterators can never refer to an erased entry.
+
+    The eviction callback runs while the evicting shard is locked and must not
+    call back into the cache.
+*/
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename Pred = std::equal_to<Key>>
+class ShardedLRUCache {
+    public:
+
+    using key_type = Key;
+    using mapped_type = T;
+    using size_type = size_t;
+    using hasher = Hash;
+    using eviction_callback = typename LRUCache<Key, T, Hash, Pred>::eviction_callback;
+
+    static constexpr size_type DEFAULT_SHARDS = 16;
+    static constexpr size_type READ_BUFFER_SIZE = 64;
+
+    private:
+
+    using cache_type = LRUCache<Key, T, Hash, Pred>;
+    using iterator = typename cache_type::iterator;
+
+    struct alignas(64) Shard {
+        std::shared_mutex lock;
+        cache_type cache;
+
+        // hits recorded by readers holding the shared lock
+        iterator reads[READ_BUFFER_SIZE];
+        std::atomic<size_type> n_reads;
+
+        std::atomic<size_type> hits;
+        std::atomic<size_type> misses;
+
+        Shard(size_type capacity, eviction_callback const & on_evict, const Hash & hash, const Pred & equal)
+            : cache(capacity, on_evict, hash, equal), n_reads(0), hits(0), misses(0) { }
+
+        // replays buffered hits, caller must hold the exclusive lock
+        void drain() {
+            size_type n = n_reads.load(std::memory_order_relaxed);
+            if(n > READ_BUFFER_SIZE) {
+                n = READ_BUFFER_SIZE;
+            }
+            for(size_type i = 0; i < n; i++) {
+                cache.touch(reads[i]);
+            }
+            n_reads.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    // shards are heap allocated individually since they hold a mutex
+    std::vector<std::unique_ptr<Shard>> _shards;
+    size_type _n_shards;
+    size_type _shard_bits;
+    size_type _capacity;
+    bool _buffered_reads;
+    Hash _hash;
+
+    // the shard of the key hashing to code; fibonacci hashing spreads weak hash codes over the shard index
+    Shard & _shard(size_type code) const {
+        uint64_t mixed = static_cast<uint64_t>(code) * 0x9E3779B97F4A7C15ull;
+        return *_shards[_shard_bits == 0 ? 0 : mixed >> (64 - _shard_bits)];
+    }
+
+    std::optional<T> _get_exact(Shard & shard, const Key & key, size_type code) {
+        std::unique_lock<std::shared_mutex> guard(shard.lock);
+        shard.drain();
+        iterator it = shard.cache.peek_hashed(key, code);
+        if(it == shard.cache.end()) {
+            shard.misses.fetch_add(1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+        shard.hits.fetch_add(1, std::memory_order_relaxed);
+        shard.cache.touch(it);
+        return it->second;
+    }
+
+    std::optional<T> _get_buffered(Shard & shard, const Key & key, size_type code) {
+        bool full = false;
+        std::optional<T> value;
+        {
+            std::shared_lock<std::shared_mutex> guard(shard.lock);
+            iterator it = shard.cache.peek_hashed(key, code);
+            if(it == shard.cache.end()) {
+                shard.misses.fetch_add(1, std::memory_order_relaxed);
+                return std::nullopt;
+            }
+            shard.hits.fetch_add(1, std::memory_order_relaxed);
+            value = it->second;
+
+            size_type slot = shard.n_reads.fetch_add(1, std::memory_order_relaxed);
+            if(slot < READ_BUFFER_SIZE) {
+                shard.reads[slot] = it;
+            }
+            full = slot + 1 >= READ_BUFFER_SIZE;
+        }
+
+        // whoever notices the full buffer drains it, unless a writer is already about to
+        if(full) {
+            std::unique_lock<std::shared_mutex> guard(shard.lock, std::try_to_lock);
+            if(guard.owns_lock()) {
+                shard.drain();
+            }
+        }
+        return value;
+    }
+
+    public:
+
+    /*
+        Creates a cache holding about capacity entries spread over n_shards
+        shards (rounded up to a power of two). Each shard holds at least
+        one entry.
+    */
+    explicit ShardedLRUCache(size_type capacity, size_type n_shards = DEFAULT_SHARDS,
+                bool buffered_reads = true, eviction_callback on_evict = eviction_callback { },
+                const Hash & hash = Hash { }, const Pred & equal = Pred { })
+        : _n_shards(1)
+        , _shard_bits(0)
+        , _capacity(0)
+        , _buffered_reads(buffered_reads)
+        , _hash(hash)
+    {
+        while(_n_shards < n_shards) {
+            _n_shards <<= 1;
+            _shard_bits++;
+        }
+
+        size_type per_shard = (capacity + _n_shards - 1) / _n_shards;
+        if(per_shard == 0) {
+            per_shard = 1;
+        }
+        _capacity = per_shard * _n_shards;
+
+        _shards.reserve(_n_shards);
+        for(size_type i = 0; i < _n_shards; i++) {
+            _shards.emplace_back(new Shard(per_shard, on_evict, hash, equal));
+        }
+    }
+
+    ShardedLRUCache(const ShardedLRUCache &) = delete;
+    ShardedLRUCache & operator=(const ShardedLRUCache &) = delete;
+
+    // returns a copy of the cached value, or nothing on a miss
+    std::optional<T> get(const Key & key) {
+        size_type code = _hash(key);
+        Shard & shard = _shard(code);
+        return _buffered_reads ? _get_buffered(shard, key, code) : _get_exact(shard, key, code);
+    }
+
+    // inserts or assigns value for key, returns true if a new entry was inserted
+    bool put(const Key & key, T value) {
+        size_type code = _hash(key);
+        Shard & shard = _shard(code);
+        std::unique_lock<std::shared_mutex> guard(shard.lock);
+        shard.drain();
+        return shard.cache.put_hashed(key, code, std::move(value)).second;
+    }
+
+    // removes key without invoking the eviction callback, returns 0 or 1
+    size_type erase(const Key & key) {
+        size_type code = _hash(key);
+        Shard & shard = _shard(code);
+        std::unique_lock<std::shared_mutex> guard(shard.lock);
+        shard.drain();
+        return shard.cache.erase_hashed(key, code);
+    }
+
+    void clear() {
+        for(size_type i = 0; i < _n_shards; i++) {
+            std::unique_lock<std::shared_mutex> guard(_shards[i]->lock);
+            _shards[i]->drain();
+            _shards[i]->cache.clear();
+        }
+    }
+
+    /*
+        The aggregate accessors below lock one shard at a time, so under
+        concurrent modification they are a sum of per-shard snapshots.
+    */
+
+    size_type size() const {
+        size_type n = 0;
+        for(size_type i = 0; i < _n_shards; i++) {
+            std::shared_lock<std::shared_mutex> guard(_shards[i]->lock);
+            n += _shards[i]->cache.size();
+        }
+        return n;
+    }
+
+    size_type hits() const {
+        size_type n = 0;
+        for(size_type i = 0; i < _n_shards; i++) {
+            n += _shards[i]->hits.load(std::memory_order_relaxed);
+        }
+        return n;
+    }
+
+    size_type misses() const {
+        size_type n = 0;
+        for(size_type i = 0; i < _n_shards; i++) {
+            n += _shards[i]->misses.load(std::memory_order_relaxed);
+        }
+        return n;
+    }
+
+    size_type evictions() const {
+        size_type n = 0;
+        for(size_type i = 0; i < _n_shards; i++) {
+            std::shared_lock<std::shared_mutex> guard(_shards[i]->lock);
+            n += _shards[i]->cache.evictions();
+        }
+        return n;
+    }
+
+    size_type capacity() const noexcept { return _capacity; }
+    size_type shard_count() const noexcept { return _n_shards; }
+    bool buffered_reads() const noexcept { return _buffered_reads; }
+};
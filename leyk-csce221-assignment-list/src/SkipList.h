@@ -0,0 +1,438 @@
+#pragma once
+
+#include <atomic>      // std::atomic
+#include <cstddef>     // size_t, ptrdiff_t
+#include <cstdint>     // uint64_t, uintptr_t
+#include <functional>  // std::less
+#include <iterator>    // std::forward_iterator_tag
+#include <new>         // ::operator new, placement new
+#include <type_traits> // std::enable_if_t, std::is_convertible
+#include <utility>     // std::pair, std::move
+
+/*
+    Ordered map as a skip list.
+
+    Every node sits on the level 0 list and, with probability 1/4 per level,
+    on each list above it, so a search skips ahead on the sparse upper levels
+    and drops down as it closes in on the key. Insert, find and erase take
+    expected O(log n) regardless of the insertion order; a sorted run of
+    inserts does not degrade the structure the way it does a plain
+    BinarySearchTree.
+
+    Each node's tower of next pointers is allocated with the node, so a node
+    is one allocation and a level 0 walk touches one cache line per element.
+
+    Concurrency: find, contains, lower_bound, upper_bound, iteration and
+    insert_concurrent are lock-free and may run from any number of threads at
+    once. insert_concurrent links a new node bottom-up with one CAS per level,
+    retrying only the level that lost a race. Everything else (insert, erase,
+    clear, assignment) mutates without atomic read-modify-writes and needs
+    exclusive access, like any other container. Nodes are only freed by
+    erase, clear and the destructor, so readers never see freed memory.
+
+    Unlike BinarySearchTree::insert, inserting an existing key leaves the
+    stored value untouched and reports the existing element, as std::map does.
+*/
+template <typename K, typename V, typename Compare = std::less<K>>
+class SkipList {
+    public:
+
+    using key_type        = K;
+    using mapped_type     = V;
+    using value_type      = std::pair<const K, V>;
+    using key_compare     = Compare;
+    using size_type       = size_t;
+    using difference_type = ptrdiff_t;
+    using reference       = value_type &;
+    using const_reference = const value_type &;
+    using pointer         = value_type *;
+    using const_pointer   = const value_type *;
+
+    // 4^12 = 16M elements before the top level stops thinning out
+    static constexpr int MAX_HEIGHT = 12;
+
+    private:
+
+    struct Node;
+    using link = std::atomic<Node *>;
+
+    // the tower of next pointers is laid out right behind the node
+    struct Node {
+        value_type data;
+        int height;
+
+        template <typename... Args>
+        explicit Node(int height, Args &&... args) : data(std::forward<Args>(args)...), height(height) {
+            for(int level = 0; level < height; level++) {
+                new (&next(level)) link(nullptr);
+            }
+        }
+
+        link & next(int level) { return tower()[level]; }
+        const link & next(int level) const { return const_cast<Node *>(this)->tower()[level]; }
+
+        const K & key() const { return data.first; }
+
+        // bytes from the start of the node to its tower, rounded up so the tower is aligned
+        static constexpr size_t offset() { return (sizeof(Node) + alignof(link) - 1) / alignof(link) * alignof(link); }
+
+        link * tower() { return reinterpret_cast<link *>(reinterpret_cast<char *>(this) + offset()); }
+    };
+
+    template <typename pointer_type, typename reference_type>
+    class basic_iterator {
+        public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = std::pair<const K, V>;
+        using difference_type   = ptrdiff_t;
+        using pointer           = pointer_type;
+        using reference         = reference_type;
+        private:
+        friend class SkipList;
+
+        Node * node;
+
+        explicit basic_iterator(Node * ptr) noexcept : node{ptr} {}
+
+        public:
+        basic_iterator() : node{nullptr} {}
+
+        // iterator converts to const_iterator
+        template <typename P, typename R, typename = std::enable_if_t<std::is_convertible<P, pointer_type>::value>>
+        basic_iterator(const basic_iterator<P, R> & other) noexcept : node{other.node} {}
+
+        reference operator*() const { return node->data; }
+        pointer operator->() const { return &(node->data); }
+
+        basic_iterator & operator++() {
+            node = node->next(0).load(std::memory_order_acquire);
+            return *this;
+        }
+        basic_iterator operator++(int) {
+            basic_iterator copy = *this;
+            ++(*this);
+            return copy;
+        }
+
+        template <typename P, typename R>
+        bool operator==(const basic_iterator<P, R> & other) const noexcept { return node == other.node; }
+        template <typename P, typename R>
+        bool operator!=(const basic_iterator<P, R> & other) const noexcept { return node != other.node; }
+
+        template <typename, typename> friend class basic_iterator;
+    };
+
+    public:
+
+    using iterator       = basic_iterator<pointer, reference>;
+    using const_iterator = basic_iterator<const_pointer, const_reference>;
+
+    private:
+
+    // the head tower; _head[level] is the first node on that level
+    link _head[MAX_HEIGHT];
+    std::atomic<int> _height;
+    std::atomic<size_type> _size;
+    key_compare _comp;
+
+    // next pointer of node at level, where nullptr stands for the head
+    link & _next(Node * node, int level) { return node ? node->next(level) : _head[level]; }
+    const link & _next(const Node * node, int level) const { return node ? node->next(level) : _head[level]; }
+
+    bool _less(const K & a, const K & b) const { return _comp(a, b); }
+    bool _equal(const K & a, const Node * node) const { return node && !_comp(a, node->key()) && !_comp(node->key(), a); }
+
+    static int _random_height() {
+        // per-thread xorshift64 so concurrent inserters never share state
+        static thread_local uint64_t state = 0x9E3779B97F4A7C15ull ^ reinterpret_cast<uintptr_t>(&state);
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        int height = 1;
+        uint64_t bits = state;
+        while(height < MAX_HEIGHT && (bits & 3) == 0) {
+            height++;
+            bits >>= 2;
+        }
+        return height;
+    }
+
+    template <typename... Args>
+    static Node * _make_node(int height, Args &&... args) {
+        static_assert(alignof(Node) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "SkipList nodes use the default operator new");
+        void * memory = ::operator new(Node::offset() + height * sizeof(link));
+        return new (memory) Node(height, std::forward<Args>(args)...);
+    }
+
+    static void _free_node(Node * node) {
+        node->~Node();
+        ::operator delete(node);
+    }
+
+    // last node before key on level, starting the walk from pred
+    Node * _find_pred(Node * pred, const K & key, int level) const {
+        Node * next = _next(pred, level).load(std::memory_order_acquire);
+        while(next && _less(next->key(), key)) {
+            pred = next;
+            next = next->next(level).load(std::memory_order_acquire);
+        }
+        return pred;
+    }
+
+    // fills preds[level] with the last node before key on every level, returns the candidate
+    Node * _find_splice(const K & key, Node ** preds) const {
+        Node * pred = nullptr;
+        for(int level = MAX_HEIGHT - 1; level >= 0; level--) {
+            if(level < _height.load(std::memory_order_relaxed)) {
+                pred = _find_pred(pred, key, level);
+            }
+            preds[level] = pred;
+        }
+        return _next(pred, 0).load(std::memory_order_acquire);
+    }
+
+    // first node whose key is not less than key
+    Node * _lower_bound(const K & key) const {
+        Node * pred = nullptr;
+        for(int level = _height.load(std::memory_order_acquire) - 1; level >= 0; level--) {
+            pred = _find_pred(pred, key, level);
+        }
+        return _next(pred, 0).load(std::memory_order_acquire);
+    }
+
+    void _raise_height(int height) {
+        int current = _height.load(std::memory_order_relaxed);
+        while(current < height && !_height.compare_exchange_weak(current, height, std::memory_order_release)) { }
+    }
+
+    // single-threaded insert of a node built from args, or the existing node with key
+    template <typename... Args>
+    std::pair<iterator, bool> _insert(const K & key, Args &&... args) {
+        Node * preds[MAX_HEIGHT];
+        Node * candidate = _find_splice(key, preds);
+        if(_equal(key, candidate)) {
+            return {iterator(candidate), false};
+        }
+
+        int height = _random_height();
+        Node * node = _make_node(height, std::forward<Args>(args)...);
+        for(int level = 0; level < height; level++) {
+            link & prev = _next(preds[level], level);
+            node->next(level).store(prev.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            prev.store(node, std::memory_order_release);
+        }
+        _raise_height(height);
+        _size.fetch_add(1, std::memory_order_relaxed);
+        return {iterator(node), true};
+    }
+
+    // lock-free insert; safe against other concurrent inserts and readers
+    template <typename... Args>
+    std::pair<iterator, bool> _insert_concurrent(const K & key, Args &&... args) {
+        Node * preds[MAX_HEIGHT];
+        Node * candidate = _find_splice(key, preds);
+        if(_equal(key, candidate)) {
+            return {iterator(candidate), false};
+        }
+
+        int height = _random_height();
+        Node * node = _make_node(height, std::forward<Args>(args)...);
+        _raise_height(height);
+
+        // level 0 decides whether the key is new; a lost race may reveal an equal key
+        while(true) {
+            Node * succ = _next(preds[0], 0).load(std::memory_order_acquire);
+            if(succ && _less(succ->key(), key)) {
+                preds[0] = _find_pred(preds[0], key, 0);
+                continue;
+            }
+            if(_equal(key, succ)) {
+                _free_node(node);
+                return {iterator(succ), false};
+            }
+            node->next(0).store(succ, std::memory_order_relaxed);
+            if(_next(preds[0], 0).compare_exchange_weak(succ, node, std::memory_order_release, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        _size.fetch_add(1, std::memory_order_relaxed);
+
+        // the upper levels are only shortcuts, link them one at a time
+        for(int level = 1; level < height; level++) {
+            while(true) {
+                preds[level] = _find_pred(preds[level], key, level);
+                Node * succ = _next(preds[level], level).load(std::memory_order_acquire);
+                node->next(level).store(succ, std::memory_order_relaxed);
+                if(_next(preds[level], level).compare_exchange_weak(succ, node, std::memory_order_release, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+        }
+        return {iterator(node), true};
+    }
+
+    // appends copies of other's nodes in order, keeping their heights
+    void _copy_from(const SkipList & other) {
+        Node * last[MAX_HEIGHT] = {};
+        for(const Node * src = other._head[0].load(std::memory_order_acquire); src;
+                src = src->next(0).load(std::memory_order_acquire)) {
+            Node * node = _make_node(src->height, src->data);
+            for(int level = 0; level < src->height; level++) {
+                _next(last[level], level).store(node, std::memory_order_relaxed);
+                last[level] = node;
+            }
+        }
+        _height.store(other._height.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        _size.store(other._size.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    // takes other's nodes and leaves it empty
+    void _steal(SkipList & other) {
+        for(int level = 0; level < MAX_HEIGHT; level++) {
+            _head[level].store(other._head[level].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            other._head[level].store(nullptr, std::memory_order_relaxed);
+        }
+        _height.store(other._height.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        _size.store(other._size.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other._height.store(1, std::memory_order_relaxed);
+        other._size.store(0, std::memory_order_relaxed);
+    }
+
+    public:
+
+    explicit SkipList(const Compare & comp = Compare { }) : _height(1), _size(0), _comp(comp) {
+        for(link & head : _head) {
+            head.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    SkipList(const SkipList & other) : SkipList(other._comp) { _copy_from(other); }
+
+    SkipList(SkipList && other) : SkipList(other._comp) { _steal(other); }
+
+    ~SkipList() { clear(); }
+
+    SkipList & operator=(const SkipList & other) {
+        if(this != &other) {
+            clear();
+            _comp = other._comp;
+            _copy_from(other);
+        }
+        return *this;
+    }
+
+    SkipList & operator=(SkipList && other) {
+        if(this != &other) {
+            clear();
+            _comp = std::move(other._comp);
+            _steal(other);
+        }
+        return *this;
+    }
+
+    iterator begin() noexcept { return iterator(_head[0].load(std::memory_order_acquire)); }
+    const_iterator begin() const noexcept { return const_iterator(_head[0].load(std::memory_order_acquire)); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    iterator end() noexcept { return iterator(nullptr); }
+    const_iterator end() const noexcept { return const_iterator(nullptr); }
+    const_iterator cend() const noexcept { return end(); }
+
+    // exact unless insert_concurrent calls are in flight
+    size_type size() const noexcept { return _size.load(std::memory_order_relaxed); }
+    bool empty() const noexcept { return size() == 0; }
+
+    key_compare key_comp() const { return _comp; }
+
+    iterator find(const K & key) {
+        Node * node = _lower_bound(key);
+        return _equal(key, node) ? iterator(node) : end();
+    }
+    const_iterator find(const K & key) const { return const_cast<SkipList *>(this)->find(key); }
+
+    bool contains(const K & key) const { return find(key) != end(); }
+
+    // first element whose key is not less than key
+    iterator lower_bound(const K & key) { return iterator(_lower_bound(key)); }
+    const_iterator lower_bound(const K & key) const { return const_iterator(_lower_bound(key)); }
+
+    // first element whose key is greater than key
+    iterator upper_bound(const K & key) {
+        iterator it = lower_bound(key);
+        if(it != end() && !_less(key, it->first)) {
+            ++it;
+        }
+        return it;
+    }
+    const_iterator upper_bound(const K & key) const { return const_cast<SkipList *>(this)->upper_bound(key); }
+
+    /*
+        Range scan: calls visit(element) for every key in [low, high), in
+        order, and returns how many elements were visited.
+    */
+    template <typename Visit>
+    size_type scan(const K & low, const K & high, Visit visit) const {
+        size_type n = 0;
+        for(const_iterator it = lower_bound(low); it != end() && _less(it->first, high); ++it, ++n) {
+            visit(*it);
+        }
+        return n;
+    }
+
+    /*
+        Inserts value if its key is not present. Returns an iterator to the
+        element with that key and whether the insertion took place.
+    */
+    std::pair<iterator, bool> insert(const value_type & value) { return _insert(value.first, value); }
+    std::pair<iterator, bool> insert(value_type && value) { return _insert(value.first, std::move(value)); }
+
+    // same as insert, but may be called concurrently with itself and with readers
+    std::pair<iterator, bool> insert_concurrent(const value_type & value) {
+        return _insert_concurrent(value.first, value);
+    }
+    std::pair<iterator, bool> insert_concurrent(value_type && value) {
+        return _insert_concurrent(value.first, std::move(value));
+    }
+
+    // returns the value for key, default-inserting it first if needed
+    V & operator[](const K & key) { return _insert(key, key, V()).first->second; }
+
+    // removes key if present and returns the number of elements removed
+    size_type erase(const K & key) {
+        Node * preds[MAX_HEIGHT];
+        Node * node = _find_splice(key, preds);
+        if(!_equal(key, node)) {
+            return 0;
+        }
+        for(int level = 0; level < node->height; level++) {
+            _next(preds[level], level).store(node->next(level).load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        while(_height.load(std::memory_order_relaxed) > 1 && !_head[_height.load(std::memory_order_relaxed) - 1].load(std::memory_order_relaxed)) {
+            _height.fetch_sub(1, std::memory_order_relaxed);
+        }
+        _free_node(node);
+        _size.fetch_sub(1, std::memory_order_relaxed);
+        return 1;
+    }
+
+    // removes the element at pos and returns an iterator to the one after it
+    iterator erase(const_iterator pos) {
+        iterator next(pos.node->next(0).load(std::memory_order_relaxed));
+        erase(pos->first);
+        return next;
+    }
+
+    void clear() {
+        Node * node = _head[0].load(std::memory_order_relaxed);
+        while(node) {
+            Node * next = node->next(0).load(std::memory_order_relaxed);
+            _free_node(node);
+            node = next;
+        }
+        for(link & head : _head) {
+            head.store(nullptr, std::memory_order_relaxed);
+        }
+        _height.store(1, std::memory_order_relaxed);
+        _size.store(0, std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,290 @@
+#pragma once
+
+#include <atomic>             // std::atomic
+#include <chrono>             // std::chrono::milliseconds
+#include <condition_variable> // std::condition_variable
+#include <cstddef>            // size_t
+#include <cstdint>            // uint64_t
+#include <functional>         // std::ref
+#include <memory>             // std::unique_ptr
+#include <mutex>              // std::mutex, std::unique_lock
+#include <thread>             // std::thread
+#include <vector>             // std::vector
+
+#include "Queue.h"
+#include "WorkStealingDeque.h"
+
+/*
+    Work-stealing thread pool for fork/join parallelism.
+
+    Every worker owns a WorkStealingDeque of tasks. fork_join(f, g) pushes g
+    onto the calling worker's deque, runs f inline and then pops g back; only
+    if an idle worker stole g in the meantime does the caller have to wait,
+    and it keeps running other tasks while it does. Recursive divide and
+    conquer therefore spreads itself over the pool with one push and one pop
+    per split in the common, unstolen case.
+
+    Work from outside the pool enters through run(), which places a root task
+    on a shared Queue and blocks until it completes. Idle workers steal from
+    random victims, then check the shared queue, then sleep.
+
+    Tasks must not throw.
+*/
+class TaskScheduler {
+    public:
+
+    using size_type = size_t;
+
+    private:
+
+    struct Task {
+        void (*execute)(Task *);
+        std::atomic<bool> done;
+
+        explicit Task(void (*execute)(Task *)) : execute(execute), done(false) { }
+
+        void run() {
+            execute(this);
+            done.store(true, std::memory_order_release);
+        }
+    };
+
+    template <typename F>
+    struct ClosureTask : Task {
+        F & f;
+
+        explicit ClosureTask(F & f) : Task(&ClosureTask::invoke), f(f) { }
+
+        static void invoke(Task * task) { static_cast<ClosureTask *>(task)->f(); }
+    };
+
+    struct Worker {
+        WorkStealingDeque<Task *> deque;
+        uint64_t rng;
+
+        explicit Worker(uint64_t seed) : deque(), rng(seed) { }
+    };
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::vector<std::thread> _threads;
+
+    // root tasks submitted from outside the pool
+    std::mutex _lock;
+    std::condition_variable _wake;
+    Queue<Task *> _injected;
+    std::atomic<size_type> _n_injected;
+    std::atomic<size_type> _n_sleeping;
+    bool _stop;
+
+    // the worker running on this thread, and the pool it belongs to
+    static inline thread_local Worker * _current = nullptr;
+    static inline thread_local TaskScheduler * _current_pool = nullptr;
+
+    static uint64_t _next_random(uint64_t & state) {
+        // xorshift64, only used to pick steal victims
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    // finds a task from a random victim or the shared queue, nullptr if there is none
+    Task * _find_work(Worker & self) {
+        size_type n = _workers.size();
+        size_type start = _next_random(self.rng) % n;
+        Task * task = nullptr;
+        for(size_type i = 0; i < n; i++) {
+            Worker & victim = *_workers[(start + i) % n];
+            if(&victim != &self && victim.deque.steal(task)) {
+                return task;
+            }
+        }
+
+        if(_n_injected.load(std::memory_order_acquire) > 0) {
+            std::unique_lock<std::mutex> guard(_lock);
+            if(!_injected.empty()) {
+                task = _injected.front();
+                _injected.pop();
+                _n_injected.fetch_sub(1, std::memory_order_relaxed);
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    // runs one task from this worker's deque or elsewhere, returns false if none was found
+    bool _run_one(Worker & self) {
+        Task * task = nullptr;
+        if(!self.deque.pop(task)) {
+            task = _find_work(self);
+        }
+        if(!task) {
+            return false;
+        }
+        task->run();
+        return true;
+    }
+
+    // wakes a sleeping worker when new work becomes stealable
+    void _notify() {
+        if(_n_sleeping.load(std::memory_order_acquire) > 0) {
+            std::unique_lock<std::mutex> guard(_lock);
+            _wake.notify_one();
+        }
+    }
+
+    void _worker_loop(Worker & self) {
+        _current = &self;
+        _current_pool = this;
+
+        size_type idle_spins = 0;
+        while(true) {
+            if(_run_one(self)) {
+                idle_spins = 0;
+                continue;
+            }
+            if(++idle_spins < 64) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // nothing to do for a while; sleep until work is injected or forked
+            std::unique_lock<std::mutex> guard(_lock);
+            if(_stop) {
+                break;
+            }
+            _n_sleeping.fetch_add(1, std::memory_order_acq_rel);
+            _wake.wait_for(guard, std::chrono::milliseconds(1), [this]() {
+                return _stop || !_injected.empty();
+            });
+            _n_sleeping.fetch_sub(1, std::memory_order_acq_rel);
+            idle_spins = 0;
+        }
+
+        _current = nullptr;
+        _current_pool = nullptr;
+    }
+
+    // keeps the calling worker busy until task has finished
+    void _wait_for(Worker & self, Task & task) {
+        while(!task.done.load(std::memory_order_acquire)) {
+            if(!_run_one(self)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    public:
+
+    // starts n_threads workers, defaulting to one per hardware thread
+    explicit TaskScheduler(size_type n_threads = std::thread::hardware_concurrency())
+        : _n_injected(0), _n_sleeping(0), _stop(false)
+    {
+        if(n_threads == 0) {
+            n_threads = 1;
+        }
+        for(size_type i = 0; i < n_threads; i++) {
+            _workers.emplace_back(new Worker(0x9E3779B97F4A7C15ull * (i + 1)));
+        }
+        for(size_type i = 0; i < n_threads; i++) {
+            _threads.emplace_back(&TaskScheduler::_worker_loop, this, std::ref(*_workers[i]));
+        }
+    }
+
+    ~TaskScheduler() {
+        {
+            std::unique_lock<std::mutex> guard(_lock);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for(std::thread & thread : _threads) {
+            thread.join();
+        }
+    }
+
+    TaskScheduler(const TaskScheduler &) = delete;
+    TaskScheduler & operator=(const TaskScheduler &) = delete;
+
+    size_type size() const noexcept { return _workers.size(); }
+
+    /*
+        Runs f() on one of the workers and blocks until it returns. f may call
+        fork_join to spread work over the pool. Called from inside the pool
+        (e.g. nested), f simply runs inline.
+    */
+    template <typename F>
+    void run(F && f) {
+        if(_current_pool == this) {
+            f();
+            return;
+        }
+
+        ClosureTask<F> task(f);
+        {
+            std::unique_lock<std::mutex> guard(_lock);
+            _injected.push(&task);
+            _n_injected.fetch_add(1, std::memory_order_release);
+        }
+        _wake.notify_one();
+
+        while(!task.done.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+
+    /*
+        Runs f() and g() potentially in parallel and returns once both have
+        finished. g is offered to thieves while the caller runs f. Outside a
+        worker thread both simply run in order.
+    */
+    template <typename F, typename G>
+    static void fork_join(F && f, G && g) {
+        Worker * self = _current;
+        if(!self) {
+            f();
+            g();
+            return;
+        }
+
+        TaskScheduler & pool = *_current_pool;
+        ClosureTask<G> forked(g);
+        self->deque.push(&forked);
+        pool._notify();
+
+        f();
+
+        Task * task = nullptr;
+        if(self->deque.pop(task)) {
+            if(task == &forked) {
+                // nobody stole g, run it inline
+                forked.run();
+                return;
+            }
+            // g was stolen, so this task belongs to an enclosing frame; run it while g finishes
+            task->run();
+        }
+        pool._wait_for(*self, forked);
+    }
+
+    /*
+        Calls body(i) for every i in [begin, end), splitting the range in half
+        with fork_join until pieces are at most grain long.
+    */
+    template <typename Body>
+    static void parallel_for(size_type begin, size_type end, size_type grain, Body const & body) {
+        if(grain == 0) {
+            grain = 1;
+        }
+        if(end - begin <= grain) {
+            for(size_type i = begin; i < end; i++) {
+                body(i);
+            }
+            return;
+        }
+        size_type mid = begin + (end - begin) / 2;
+        fork_join(
+            [&]() { parallel_for(begin, mid, grain, body); },
+            [&]() { parallel_for(mid, end, grain, body); }
+        );
+    }
+};
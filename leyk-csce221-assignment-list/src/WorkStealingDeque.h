@@ -0,0 +1,160 @@
+#pragma once
+
+#include <atomic>      // std::atomic, std::atomic_thread_fence
+#include <cstddef>     // size_t
+#include <cstdint>     // int64_t
+#include <memory>      // std::unique_ptr
+#include <type_traits> // std::is_trivially_copyable
+#include <vector>      // std::vector
+
+/*
+    Chase-Lev work-stealing deque.
+
+    One owner thread pushes and pops at the bottom (LIFO, so it works on the
+    freshest and cache-hottest item) while any number of thieves steal from
+    the top (FIFO, so they take the oldest and typically largest piece of
+    work). Only a pop racing a steal for the last element needs a CAS; every
+    other operation is a handful of loads and stores.
+
+    The ring buffer doubles when full. Thieves may still be reading the old
+    buffer, so retired buffers are kept until the deque is destroyed; with
+    doubling they never add up to more than the live buffer.
+
+    T is copied in and out of atomic slots, so it must be trivially copyable
+    (in practice a pointer to a task). Memory orderings follow Le, Pop, Cohen
+    and Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory
+    Models" (PPoPP 2013).
+*/
+template <typename T>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque stores T in atomic slots");
+
+    public:
+
+    using value_type = T;
+    using size_type = size_t;
+
+    static constexpr size_type DEFAULT_CAPACITY = 64;
+
+    private:
+
+    struct Buffer {
+        int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+
+        explicit Buffer(int64_t capacity) : mask(capacity - 1), slots(new std::atomic<T>[capacity]) { }
+
+        int64_t capacity() const { return mask + 1; }
+        T get(int64_t i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T value) { slots[i & mask].store(value, std::memory_order_relaxed); }
+
+        // copies the live range [top, bottom) into a buffer twice the size
+        Buffer * grow(int64_t top, int64_t bottom) const {
+            Buffer * bigger = new Buffer(2 * capacity());
+            for(int64_t i = top; i < bottom; i++) {
+                bigger->put(i, get(i));
+            }
+            return bigger;
+        }
+    };
+
+    // top and bottom are written by different threads, keep them on separate lines
+    alignas(64) std::atomic<int64_t> _top;
+    alignas(64) std::atomic<int64_t> _bottom;
+    alignas(64) std::atomic<Buffer *> _buffer;
+
+    // owned by the owner thread
+    std::vector<std::unique_ptr<Buffer>> _retired;
+
+    public:
+
+    // capacity is rounded up to a power of two
+    explicit WorkStealingDeque(size_type capacity = DEFAULT_CAPACITY) : _top(0), _bottom(0) {
+        int64_t cap = 1;
+        while(cap < static_cast<int64_t>(capacity)) {
+            cap <<= 1;
+        }
+        _buffer.store(new Buffer(cap), std::memory_order_relaxed);
+    }
+
+    ~WorkStealingDeque() { delete _buffer.load(std::memory_order_relaxed); }
+
+    WorkStealingDeque(const WorkStealingDeque &) = delete;
+    WorkStealingDeque & operator=(const WorkStealingDeque &) = delete;
+
+    // owner only: adds value at the bottom
+    void push(T value) {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_acquire);
+        Buffer * buf = _buffer.load(std::memory_order_relaxed);
+
+        if(b - t > buf->capacity() - 1) {
+            Buffer * bigger = buf->grow(t, b);
+            _retired.emplace_back(buf);
+            _buffer.store(bigger, std::memory_order_release);
+            buf = bigger;
+        }
+
+        buf->put(b, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        _bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // owner only: removes the bottom value into out, returns false if empty
+    bool pop(T & out) {
+        int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+        Buffer * buf = _buffer.load(std::memory_order_relaxed);
+        _bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = _top.load(std::memory_order_relaxed);
+
+        if(t > b) {
+            // already empty, undo the reservation
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        out = buf->get(b);
+        if(t == b) {
+            // last element, race the thieves for it
+            bool won = _top.compare_exchange_strong(t, t + 1,
+                std::memory_order_seq_cst, std::memory_order_relaxed);
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // any thread: removes the top value into out, returns false if empty or lost a race
+    bool steal(T & out) {
+        int64_t t = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = _bottom.load(std::memory_order_acquire);
+
+        if(t >= b) {
+            return false;
+        }
+
+        Buffer * buf = _buffer.load(std::memory_order_acquire);
+        T value = buf->get(t);
+        if(!_top.compare_exchange_strong(t, t + 1,
+                std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;
+        }
+        out = value;
+        return true;
+    }
+
+    // approximate when other threads are pushing or stealing
+    size_type size() const noexcept {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_type>(b - t) : 0;
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+
+    size_type capacity() const noexcept {
+        return static_cast<size_type>(_buffer.load(std::memory_order_relaxed)->capacity());
+    }
+};
@@ -0,0 +1,129 @@
+#include "executable.h"
+#include "Channel.h"
+
+#include <memory>
+#include <vector>
+
+// Coroutines are free functions; lambda coroutines would dangle their captures
+static Executor::Task produce(Channel<int> & out, int begin, int end, std::vector<bool> & accepted) {
+    for (int i = begin; i < end; i++) {
+        accepted.push_back(co_await out.push(i));
+    }
+}
+
+static Executor::Task forward(Channel<int> & in, Channel<int> & out) {
+    while (std::optional<int> value = co_await in.pop()) {
+        co_await out.push(*value + 1);
+    }
+    out.close();
+}
+
+static Executor::Task consume(Channel<int> & in, std::vector<int> & received) {
+    while (std::optional<int> value = co_await in.pop()) {
+        received.push_back(*value);
+    }
+}
+
+TEST(channel) {
+    Typegen t;
+
+    // Values cross a chain of stages in order, for any buffer capacity
+    for (size_t i = 0; i < TEST_ITER; i++) {
+        const size_t n_stages = t.range<size_t>(1, 64);
+        const size_t capacity = t.range<size_t>(0, 4);
+        const int n_values = t.range<int>(0, 256);
+
+        Executor executor;
+        std::vector<std::unique_ptr<Channel<int>>> channels;
+        for (size_t s = 0; s <= n_stages; s++) {
+            channels.emplace_back(new Channel<int>(executor, capacity));
+        }
+
+        std::vector<int> received;
+        std::vector<bool> accepted;
+        executor.spawn(consume(*channels.back(), received));
+        for (size_t s = 0; s < n_stages; s++) {
+            executor.spawn(forward(*channels[s], *channels[s + 1]));
+        }
+        executor.spawn(produce(*channels.front(), 0, n_values, accepted));
+
+        executor.run();
+        // the producer is done; every stage and the consumer wait on an empty channel
+        ASSERT_EQ(n_stages + 1, executor.pending());
+
+        channels.front()->close();
+        executor.run();
+        ASSERT_EQ(0ULL, executor.pending());
+
+        ASSERT_EQ(static_cast<size_t>(n_values), received.size());
+        for (int v = 0; v < n_values; v++) {
+            ASSERT_EQ(v + static_cast<int>(n_stages), received[v]);
+        }
+        ASSERT_EQ(static_cast<size_t>(n_values), accepted.size());
+    }
+
+    // A bounded channel parks the producer until there is room
+    {
+        Executor executor;
+        Channel<int> channel(executor, 2);
+        std::vector<bool> accepted;
+
+        executor.spawn(produce(channel, 0, 5, accepted));
+        executor.run();
+        ASSERT_EQ(2ULL, channel.size());
+        ASSERT_EQ(2ULL, accepted.size());
+        ASSERT_EQ(1ULL, executor.pending());
+
+        ASSERT_EQ(0, *channel.try_pop());
+        ASSERT_EQ(2ULL, channel.size());
+        executor.run();
+        ASSERT_EQ(3ULL, accepted.size());
+
+        // the parked push fails once the channel closes; later pushes fail at once
+        channel.close();
+        executor.run();
+        ASSERT_EQ(0ULL, executor.pending());
+        ASSERT_EQ(5ULL, accepted.size());
+        ASSERT_TRUE(accepted[2]);
+        ASSERT_FALSE(accepted[3]);
+        ASSERT_FALSE(accepted[4]);
+
+        // buffered values drain after close
+        ASSERT_EQ(1, *channel.try_pop());
+        ASSERT_EQ(2, *channel.try_pop());
+        ASSERT_FALSE(channel.try_pop().has_value());
+        ASSERT_FALSE(channel.try_push(9));
+    }
+
+    // try_push from outside feeds a suspended consumer directly
+    {
+        Executor executor;
+        Channel<int> channel(executor, 0);
+        std::vector<int> received;
+
+        executor.spawn(consume(channel, received));
+        executor.run();
+        ASSERT_TRUE(channel.empty());
+        ASSERT_TRUE(channel.try_push(7));
+        ASSERT_FALSE(channel.try_push(8));
+        executor.run();
+        ASSERT_EQ(1ULL, received.size());
+        ASSERT_EQ(7, received[0]);
+    }
+
+    // Suspended tasks are freed with their executor
+    {
+        Memhook mh;
+        {
+            Executor executor;
+            Channel<int> channel(executor);
+            std::vector<int> received;
+            for (size_t i = 0; i < 100; i++) {
+                executor.spawn(consume(channel, received));
+            }
+            executor.run();
+            ASSERT_EQ(100ULL, executor.pending());
+        }
+        ASSERT_EQ(mh.n_allocs(), mh.n_frees());
+    }
+}
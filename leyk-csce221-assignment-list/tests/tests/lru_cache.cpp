@@ -0,0 +1,107 @@
+#include "executable.h"
+#include "LRUCache.h"
+
+#include <algorithm>
+#include <list>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+TEST(lru_cache) {
+    Typegen t;
+
+    for (size_t i = 0; i < TEST_ITER; i++) {
+        const size_t capacity = t.range<size_t>(1, 64);
+        const size_t n_keys = t.range<size_t>(1, 4 * capacity + 1);
+        const size_t n_ops = t.range(0x999ULL);
+
+        std::vector<int> evicted;
+        std::vector<int> evicted_values;
+        LRUCache<int, int> cache(capacity, [&](const int & key, int & value) {
+            evicted.push_back(key);
+            evicted_values.push_back(-value);
+        });
+
+        // Reference model, most recently used at the front
+        std::list<int> gt;
+        std::vector<int> gt_evicted;
+        size_t gt_hits = 0, gt_misses = 0;
+
+        for (size_t op = 0; op < n_ops; op++) {
+            int key = t.range<int>(0, static_cast<int>(n_keys));
+            auto gt_it = std::find(gt.begin(), gt.end(), key);
+
+            if (t.get<bool>()) {
+                int * value = nullptr;
+                {
+                    // A hit only relinks the node, a miss does nothing
+                    Memhook mh;
+                    value = cache.get(key);
+                    ASSERT_EQ(0ULL, mh.n_allocs());
+                    ASSERT_EQ(0ULL, mh.n_frees());
+                }
+
+                if (gt_it == gt.end()) {
+                    gt_misses++;
+                    ASSERT_TRUE(value == nullptr);
+                } else {
+                    gt_hits++;
+                    ASSERT_TRUE(value != nullptr);
+                    ASSERT_EQ(-key, *value);
+                    gt.splice(gt.begin(), gt, gt_it);
+                }
+            } else {
+                auto [it, inserted] = cache.put(key, -key);
+                ASSERT_EQ(gt_it == gt.end(), inserted);
+                ASSERT_EQ(key, it->first);
+
+                if (gt_it != gt.end()) {
+                    gt.splice(gt.begin(), gt, gt_it);
+                } else {
+                    if (gt.size() == capacity) {
+                        gt_evicted.push_back(gt.back());
+                        gt.pop_back();
+                    }
+                    gt.push_front(key);
+                }
+            }
+
+            ASSERT_EQ(gt.size(), cache.size());
+        }
+
+        ASSERT_EQ(gt_hits, cache.hits());
+        ASSERT_EQ(gt_misses, cache.misses());
+        ASSERT_EQ(gt_evicted.size(), cache.evictions());
+        ASSERT_TRUE(gt_evicted == evicted);
+        ASSERT_TRUE(gt_evicted == evicted_values);
+
+        // Iteration walks from most to least recently used
+        auto it = cache.begin();
+        for (int key : gt) {
+            ASSERT_EQ(key, (it++)->first);
+        }
+        ASSERT_TRUE(it == cache.end());
+
+        // Explicit erasure does not count as an eviction
+        if (!gt.empty()) {
+            ASSERT_EQ(1ULL, cache.erase(gt.front()));
+            ASSERT_EQ(0ULL, cache.erase(gt.front()));
+            ASSERT_EQ(gt_evicted.size(), cache.evictions());
+        }
+
+        cache.clear();
+        ASSERT_TRUE(cache.empty());
+        ASSERT_TRUE(cache.get(0) == nullptr);
+    }
+
+    // A cache that can hold nothing is refused outright
+    {
+        bool refused = false;
+        try {
+            LRUCache<int, int> cache(0);
+        } catch (const std::invalid_argument &) {
+            refused = true;
+        }
+        ASSERT_TRUE(refused);
+    }
+}
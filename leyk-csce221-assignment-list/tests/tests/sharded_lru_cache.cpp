@@ -0,0 +1,129 @@
+#include "executable.h"
+#include "ShardedLRUCache.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// counts the keys it hashes
+struct counting_int_hash {
+    static size_t calls;
+
+    size_t operator()(int key) const {
+        calls++;
+        return std::hash<int> {}(key);
+    }
+};
+
+size_t counting_int_hash::calls = 0;
+
+// so the index walks its buckets by the stored codes instead of hashing the nodes again
+template <>
+struct cache_hash_code<counting_int_hash> : std::true_type { };
+
+TEST(sharded_lru_cache) {
+    Typegen t;
+
+    // The key picking the shard is hashed once, not again inside the shard
+    for (bool buffered : { false, true }) {
+        ShardedLRUCache<int, int, counting_int_hash> cache(1024, 4, buffered);
+        auto hashes = [&](auto && op) {
+            size_t calls = counting_int_hash::calls;
+            op();
+            return counting_int_hash::calls - calls;
+        };
+        for (int key = 0; key < 100; key++) {
+            ASSERT_EQ(1ULL, hashes([&] { ASSERT_TRUE(cache.put(key, key)); }));
+            ASSERT_EQ(1ULL, hashes([&] { ASSERT_FALSE(cache.put(key, -key)); }));
+            ASSERT_EQ(1ULL, hashes([&] { ASSERT_EQ(-key, cache.get(key).value_or(0)); }));
+            ASSERT_EQ(1ULL, hashes([&] { ASSERT_FALSE(cache.get(key + 1000).has_value()); }));
+        }
+        for (int key = 0; key < 100; key++) {
+            ASSERT_EQ(1ULL, hashes([&] { ASSERT_EQ(1ULL, cache.erase(key)); }));
+        }
+    }
+
+    // A single exact shard behaves like a plain LRUCache
+    for (size_t i = 0; i < TEST_ITER; i++) {
+        const size_t capacity = t.range<size_t>(1, 64);
+        const size_t n_keys = t.range<size_t>(1, 4 * capacity + 1);
+        const size_t n_ops = t.range(0x999ULL);
+
+        std::vector<int> evicted, gt_evicted;
+        ShardedLRUCache<int, int> cache(capacity, 1, false, [&](const int & key, int &) {
+            evicted.push_back(key);
+        });
+        LRUCache<int, int> gt(capacity, [&](const int & key, int &) {
+            gt_evicted.push_back(key);
+        });
+
+        ASSERT_EQ(capacity, cache.capacity());
+
+        for (size_t op = 0; op < n_ops; op++) {
+            int key = t.range<int>(0, static_cast<int>(n_keys));
+
+            if (t.get<bool>()) {
+                std::optional<int> value = cache.get(key);
+                int * gt_value = gt.get(key);
+
+                ASSERT_EQ(gt_value != nullptr, value.has_value());
+                if (gt_value) {
+                    ASSERT_EQ(*gt_value, *value);
+                }
+            } else {
+                int value = t.get<int>();
+                ASSERT_EQ(gt.put(key, value).second, cache.put(key, value));
+            }
+
+            ASSERT_EQ(gt.size(), cache.size());
+        }
+
+        ASSERT_EQ(gt.hits(), cache.hits());
+        ASSERT_EQ(gt.misses(), cache.misses());
+        ASSERT_EQ(gt.evictions(), cache.evictions());
+        ASSERT_TRUE(gt_evicted == evicted);
+    }
+
+    // Concurrent readers and writers never observe a torn or foreign value
+    for (bool buffered : { false, true }) {
+        const size_t n_threads = 4;
+        const size_t n_ops = 0x4000;
+        const int n_keys = 512;
+
+        ShardedLRUCache<int, int> cache(128, 8, buffered);
+        std::atomic<size_t> bad_values { 0 };
+        std::atomic<size_t> n_gets { 0 };
+
+        std::vector<std::thread> threads;
+        for (size_t tid = 0; tid < n_threads; tid++) {
+            threads.emplace_back([&, tid]() {
+                Typegen tt(tid + 1);
+                for (size_t op = 0; op < n_ops; op++) {
+                    int key = tt.range<int>(0, n_keys);
+                    if (tt.get<bool>(0.8)) {
+                        n_gets++;
+                        std::optional<int> value = cache.get(key);
+                        if (value && *value != 7 * key) {
+                            bad_values++;
+                        }
+                    } else if (tt.get<bool>(0.9)) {
+                        cache.put(key, 7 * key);
+                    } else {
+                        cache.erase(key);
+                    }
+                }
+            });
+        }
+
+        for (std::thread & thread : threads) {
+            thread.join();
+        }
+
+        ASSERT_EQ(0ULL, bad_values.load());
+        ASSERT_EQ(n_gets.load(), cache.hits() + cache.misses());
+        ASSERT_TRUE(cache.size() <= cache.capacity());
+
+        cache.clear();
+        ASSERT_EQ(0ULL, cache.size());
+    }
+}
@@ -0,0 +1,177 @@
+#include "executable.h"
+#include "SkipList.h"
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <thread>
+#include <vector>
+
+TEST(skip_list) {
+    Typegen t;
+
+    // Random inserts, erases and lookups agree with std::map
+    for (size_t i = 0; i < TEST_ITER; i++) {
+        const size_t n_ops = t.range(0x999ULL);
+        const int n_keys = t.range<int>(1, 512);
+
+        SkipList<int, int> sl;
+        std::map<int, int> gt;
+
+        for (size_t op = 0; op < n_ops; op++) {
+            int key = t.range<int>(0, n_keys);
+            switch (t.range<int>(0, 3)) {
+            case 0: {
+                int value = t.get<int>();
+                auto result = sl.insert({ key, value });
+                auto gt_result = gt.insert({ key, value });
+                ASSERT_EQ(gt_result.second, result.second);
+                ASSERT_EQ(gt_result.first->second, result.first->second);
+                break;
+            }
+            case 1:
+                ASSERT_EQ(gt.erase(key), sl.erase(key));
+                break;
+            default: {
+                auto it = sl.find(key);
+                auto gt_it = gt.find(key);
+                ASSERT_EQ(gt_it != gt.end(), it != sl.end());
+                if (gt_it != gt.end()) {
+                    ASSERT_EQ(gt_it->second, it->second);
+                }
+                ASSERT_EQ(gt.count(key) == 1, sl.contains(key));
+            }
+            }
+            ASSERT_EQ(gt.size(), sl.size());
+        }
+
+        // Iteration is ordered
+        auto gt_it = gt.begin();
+        for (auto const & element : sl) {
+            ASSERT_EQ(gt_it->first, element.first);
+            ASSERT_EQ(gt_it->second, element.second);
+            ++gt_it;
+        }
+        ASSERT_TRUE(gt_it == gt.end());
+
+        // Bounds and range scans
+        for (size_t q = 0; q < 16; q++) {
+            int low = t.range<int>(-1, n_keys + 1);
+            int high = t.range<int>(low, n_keys + 2);
+
+            auto lb = sl.lower_bound(low);
+            auto gt_lb = gt.lower_bound(low);
+            ASSERT_EQ(gt_lb == gt.end(), lb == sl.end());
+            if (gt_lb != gt.end()) {
+                ASSERT_EQ(gt_lb->first, lb->first);
+            }
+
+            auto ub = sl.upper_bound(low);
+            auto gt_ub = gt.upper_bound(low);
+            ASSERT_EQ(gt_ub == gt.end(), ub == sl.end());
+            if (gt_ub != gt.end()) {
+                ASSERT_EQ(gt_ub->first, ub->first);
+            }
+
+            std::vector<int> scanned, gt_scanned;
+            size_t n = sl.scan(low, high, [&](std::pair<const int, int> const & element) {
+                scanned.push_back(element.first);
+            });
+            for (auto it = gt.lower_bound(low); it != gt.lower_bound(high); ++it) {
+                gt_scanned.push_back(it->first);
+            }
+            ASSERT_EQ(gt_scanned.size(), n);
+            ASSERT_TRUE(gt_scanned == scanned);
+        }
+    }
+
+    // Sorted inserts, copies and moves
+    {
+        const int n = 0x4000;
+        SkipList<int, int, std::greater<int>> sl;
+        for (int key = 0; key < n; key++) {
+            ASSERT_TRUE(sl.insert({ key, 2 * key }).second);
+        }
+        ASSERT_EQ(static_cast<size_t>(n), sl.size());
+        ASSERT_EQ(n - 1, sl.begin()->first);
+
+        SkipList<int, int, std::greater<int>> copy(sl);
+        ASSERT_EQ(sl.size(), copy.size());
+        ASSERT_TRUE(std::equal(sl.begin(), sl.end(), copy.begin()));
+
+        sl[7] = -1;
+        ASSERT_EQ(14, copy.find(7)->second);
+        ASSERT_EQ(-1, sl.find(7)->second);
+
+        SkipList<int, int, std::greater<int>> moved(std::move(copy));
+        ASSERT_EQ(0ULL, copy.size());
+        ASSERT_TRUE(copy.begin() == copy.end());
+        ASSERT_EQ(static_cast<size_t>(n), moved.size());
+
+        copy = moved;
+        ASSERT_EQ(moved.size(), copy.size());
+        moved = std::move(sl);
+        ASSERT_EQ(-1, moved.find(7)->second);
+
+        for (auto it = moved.cbegin(); it != moved.cend();) {
+            it = moved.erase(it);
+        }
+        ASSERT_TRUE(moved.empty());
+    }
+
+    // Concurrent inserts of overlapping key ranges alongside readers
+    {
+        const size_t n_writers = 4;
+        const int n_keys = 0x2000;
+
+        SkipList<int, int> sl;
+        std::atomic<size_t> n_inserted { 0 };
+        std::atomic<size_t> bad_values { 0 };
+        std::atomic<bool> writing { true };
+
+        std::thread reader([&]() {
+            Typegen tt(99);
+            while (writing.load()) {
+                auto it = sl.find(tt.range<int>(0, n_keys));
+                if (it != sl.end() && it->second != 3 * it->first) {
+                    bad_values++;
+                }
+                int last = -1;
+                for (auto const & element : sl) {
+                    if (element.first <= last) {
+                        bad_values++;
+                    }
+                    last = element.first;
+                }
+            }
+        });
+
+        std::vector<std::thread> writers;
+        for (size_t tid = 0; tid < n_writers; tid++) {
+            writers.emplace_back([&, tid]() {
+                Typegen tt(tid + 1);
+                for (int j = 0; j < n_keys; j++) {
+                    int key = tt.range<int>(0, n_keys);
+                    if (sl.insert_concurrent({ key, 3 * key }).second) {
+                        n_inserted++;
+                    }
+                }
+            });
+        }
+        for (std::thread & writer : writers) {
+            writer.join();
+        }
+        writing.store(false);
+        reader.join();
+
+        ASSERT_EQ(0ULL, bad_values.load());
+        ASSERT_EQ(n_inserted.load(), sl.size());
+        ASSERT_EQ(static_cast<size_t>(std::distance(sl.begin(), sl.end())), sl.size());
+        int last = -1;
+        for (auto const & element : sl) {
+            ASSERT_LT(last, element.first);
+            ASSERT_EQ(3 * element.first, element.second);
+            last = element.first;
+        }
+    }
+}
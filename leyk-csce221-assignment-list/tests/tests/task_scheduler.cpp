@@ -0,0 +1,50 @@
+#include "executable.h"
+#include "TaskScheduler.h"
+
+#include <numeric>
+#include <vector>
+
+static uint64_t fib(uint64_t n) {
+    if (n < 2) {
+        return n;
+    }
+    uint64_t a = 0, b = 0;
+    TaskScheduler::fork_join([&]() { a = fib(n - 1); }, [&]() { b = fib(n - 2); });
+    return a + b;
+}
+
+TEST(task_scheduler) {
+    Typegen t;
+
+    // Results match the sequential computation for any pool size
+    for (size_t n_threads : { 1, 2, 4 }) {
+        TaskScheduler pool(n_threads);
+        ASSERT_EQ(n_threads, pool.size());
+
+        uint64_t result = 0;
+        pool.run([&]() { result = fib(20); });
+        ASSERT_EQ(6765ULL, result);
+
+        for (size_t i = 0; i < TEST_ITER / 10; i++) {
+            const size_t n = t.range(0x9999ULL);
+            std::vector<uint64_t> values(n);
+            t.fill(values.begin(), values.end());
+
+            std::vector<uint64_t> squares(n);
+            pool.run([&]() {
+                TaskScheduler::parallel_for(0, n, t.range<size_t>(1, 256), [&](size_t k) {
+                    squares[k] = values[k] * values[k];
+                });
+            });
+
+            for (size_t k = 0; k < n; k++) {
+                ASSERT_EQ(values[k] * values[k], squares[k]);
+            }
+        }
+    }
+
+    // Outside the pool fork_join runs both halves in order
+    std::vector<int> order;
+    TaskScheduler::fork_join([&]() { order.push_back(1); }, [&]() { order.push_back(2); });
+    ASSERT_TRUE((order == std::vector<int> { 1, 2 }));
+}
@@ -0,0 +1,90 @@
+#include "executable.h"
+#include "WorkStealingDeque.h"
+
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <vector>
+
+TEST(work_stealing_deque) {
+    Typegen t;
+
+    // Owner pops from the bottom, thieves take from the top
+    for (size_t i = 0; i < TEST_ITER; i++) {
+        WorkStealingDeque<int> dq(t.range<size_t>(1, 8));
+        std::deque<int> gt;
+
+        const size_t n_ops = t.range(0x999ULL);
+        for (size_t op = 0; op < n_ops; op++) {
+            int value = 0;
+            switch (t.range(3)) {
+                case 0:
+                    value = t.get<int>();
+                    dq.push(value);
+                    gt.push_back(value);
+                    break;
+                case 1:
+                    ASSERT_EQ(!gt.empty(), dq.pop(value));
+                    if (!gt.empty()) {
+                        ASSERT_EQ(gt.back(), value);
+                        gt.pop_back();
+                    }
+                    break;
+                default:
+                    ASSERT_EQ(!gt.empty(), dq.steal(value));
+                    if (!gt.empty()) {
+                        ASSERT_EQ(gt.front(), value);
+                        gt.pop_front();
+                    }
+                    break;
+            }
+            ASSERT_EQ(gt.size(), dq.size());
+            ASSERT_TRUE(dq.capacity() >= dq.size());
+        }
+    }
+
+    // Every pushed item is taken exactly once under contention
+    {
+        const size_t n_items = 0x20000;
+        const size_t n_thieves = 3;
+
+        WorkStealingDeque<size_t> dq(4);
+        std::vector<std::atomic<unsigned>> taken(n_items);
+        std::atomic<bool> done { false };
+
+        std::vector<std::thread> thieves;
+        for (size_t tid = 0; tid < n_thieves; tid++) {
+            thieves.emplace_back([&]() {
+                size_t item;
+                while (!done.load() || !dq.empty()) {
+                    if (dq.steal(item)) {
+                        taken[item]++;
+                    }
+                }
+            });
+        }
+
+        size_t item;
+        for (size_t k = 0; k < n_items; k++) {
+            dq.push(k);
+            // pop roughly every third push so pops race steals
+            if (k % 3 == 0 && dq.pop(item)) {
+                taken[item]++;
+            }
+        }
+        while (dq.pop(item)) {
+            taken[item]++;
+        }
+        done = true;
+
+        for (std::thread & thief : thieves) {
+            thief.join();
+        }
+
+        size_t bad = 0;
+        for (auto & count : taken) {
+            bad += count.load() != 1;
+        }
+        ASSERT_EQ(0ULL, bad);
+    }
+}
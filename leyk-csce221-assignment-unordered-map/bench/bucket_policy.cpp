@@ -0,0 +1,103 @@
+#include "bench.h"
+#include "UnorderedMap.h"
+
+#include <cstdint>
+#include <numeric>
+
+/*
+    Compares the ways UnorderedMap can turn a hash code into a bucket: the
+    hardware % it used to do, prime bucket counts reduced with fastmod, and
+    power-of-two bucket counts reduced with a mask after mixing. Latency is
+    measured by chasing keys, each lookup's value being the next key, so
+    lookups can't overlap; throughput looks up independent keys.
+*/
+
+constexpr size_t N_REDUCTIONS = 1 << 24;
+constexpr size_t N_LOOKUPS = 1 << 22;
+
+// the pre-fastmod policy: prime bucket counts and a division per lookup
+class modulo_buckets {
+    size_t _bucket_count;
+
+    public:
+
+    explicit modulo_buckets(size_t bucket_count) : _bucket_count(next_greater_prime(bucket_count)) { }
+
+    static size_t bucket_count_for(size_t n) { return next_greater_prime(n); }
+
+    size_t bucket_count() const { return _bucket_count; }
+
+    size_t operator()(size_t code) const { return code % _bucket_count; }
+};
+
+template <typename Policy>
+void measure_reduce(std::string const & name, std::vector<size_t> const & codes) {
+    Policy range_hash(1 << 20);
+    size_t checksum = 0;
+    Stopwatch sw;
+    for(size_t code : codes) {
+        checksum += range_hash(code);
+    }
+    double seconds = sw.elapsed();
+    report(name + " reduce", 1e9 * seconds / codes.size(), "ns/op");
+    if(checksum == 1) {
+        std::cout << std::endl;
+    }
+}
+
+template <typename Policy>
+void measure_lookups(std::string const & name, size_t n_keys, Typegen & t) {
+    std::vector<uint64_t> keys(n_keys);
+    t.fill_unique(keys.begin(), keys.end());
+
+    // each key maps to the next one in a random cycle through all keys
+    std::vector<size_t> order(n_keys);
+    std::iota(order.begin(), order.end(), 0);
+    t.shuffle(order.begin(), order.end());
+    using Map = UnorderedMap<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                             std::allocator<std::pair<const uint64_t, uint64_t>>, Policy>;
+    Map map(1);
+    map.max_load_factor(1);
+    for(size_t i = 0; i < n_keys; i++) {
+        map.insert({ keys[order[i]], keys[order[(i + 1) % n_keys]] });
+    }
+
+    uint64_t key = keys[order[0]];
+    Stopwatch sw;
+    for(size_t i = 0; i < N_LOOKUPS; i++) {
+        key = map.find(key)->second;
+    }
+    double latency_seconds = sw.elapsed();
+
+    uint64_t checksum = key;
+    sw.reset();
+    for(size_t i = 0; i < N_LOOKUPS; i++) {
+        checksum += map.find(keys[i % n_keys])->second;
+    }
+    double throughput_seconds = sw.elapsed();
+
+    report(name + " find latency", 1e9 * latency_seconds / N_LOOKUPS, "ns/op");
+    report(name + " find throughput", 1e9 * throughput_seconds / N_LOOKUPS, "ns/op");
+    if(checksum == 1) {
+        std::cout << std::endl;
+    }
+}
+
+int main() {
+    Typegen t;
+
+    std::vector<size_t> codes(N_REDUCTIONS);
+    t.fill(codes.begin(), codes.end());
+
+    std::cout << "Bucket policies" << std::endl << std::endl;
+    measure_reduce<modulo_buckets>("modulo", codes);
+    measure_reduce<prime_buckets>("fastmod", codes);
+    measure_reduce<power_of_two_buckets>("mix and mask", codes);
+
+    for(size_t n_keys : { 1ul << 10, 1ul << 20 }) {
+        std::cout << std::endl << "UnorderedMap, " << n_keys << " uint64_t keys" << std::endl;
+        measure_lookups<modulo_buckets>("modulo", n_keys, t);
+        measure_lookups<prime_buckets>("fastmod", n_keys, t);
+        measure_lookups<power_of_two_buckets>("mix and mask", n_keys, t);
+    }
+}
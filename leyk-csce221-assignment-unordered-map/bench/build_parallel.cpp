@@ -0,0 +1,46 @@
+#include "bench.h"
+#include "UnorderedMap.h"
+
+#include <cstdint>
+#include <thread>
+
+/*
+    Building a map from a vector of pairs: inserting them one by one, as
+    the reference, against build_parallel on growing thread counts. The
+    keys are random, with about one pair in eight repeating a key.
+*/
+
+constexpr size_t N_PAIRS = 1 << 22;
+constexpr size_t MAX_THREADS = 8;
+
+using Map = UnorderedMap<uint64_t, uint64_t>;
+
+int main() {
+    Typegen t;
+    std::vector<std::pair<uint64_t, uint64_t>> pairs(N_PAIRS);
+    for(size_t i = 0; i < N_PAIRS; i++) {
+        pairs[i] = { t.range(N_PAIRS * 4), i };
+    }
+
+    Stopwatch sw;
+    Map reference(N_PAIRS);
+    for(auto const & pair : pairs) {
+        reference.insert(pair);
+    }
+    double insert_seconds = sw.elapsed();
+
+    std::cout << "Building a map of " << N_PAIRS << " pairs, "
+              << std::thread::hardware_concurrency() << " hardware threads" << std::endl << std::endl;
+    report("insert loop", 1e3 * insert_seconds, "ms");
+    for(size_t n_threads = 1; n_threads <= MAX_THREADS; n_threads *= 2) {
+        sw.reset();
+        Map map = Map::build_parallel(pairs.begin(), pairs.end(), n_threads);
+        double seconds = sw.elapsed();
+        report("build_parallel, " + std::to_string(n_threads) + " threads", 1e3 * seconds, "ms");
+        if(map.size() != reference.size()) {
+            std::cout << "sizes differ" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
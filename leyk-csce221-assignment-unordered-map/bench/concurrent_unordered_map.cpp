@@ -0,0 +1,118 @@
+#include "bench.h"
+#include "ConcurrentUnorderedMap.h"
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+/*
+    Throughput of a shared lookup table as threads are added, for one
+    mutex around an UnorderedMap and for ConcurrentUnorderedMap, at
+    several read/write mixes. Writes are insert_or_assign on a Zipf
+    distributed key, like the occasional update of a hot entry.
+*/
+
+constexpr size_t N_KEYS = 1 << 16;
+constexpr size_t N_OPS_PER_THREAD = 1 << 20;
+constexpr size_t N_SHARDS = 64;
+constexpr double ZIPF_EXPONENT = 0.99;
+
+class LockedUnorderedMap {
+    std::mutex _lock;
+    UnorderedMap<uint64_t, uint64_t> _map;
+
+    public:
+
+    LockedUnorderedMap() : _map(N_KEYS) { _map.max_load_factor(1); }
+
+    std::optional<uint64_t> find(uint64_t key) {
+        std::lock_guard<std::mutex> guard(_lock);
+        auto it = _map.find(key);
+        if(it == _map.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    void insert_or_assign(uint64_t key, uint64_t value) {
+        std::lock_guard<std::mutex> guard(_lock);
+        _map[key] = value;
+    }
+};
+
+struct Op {
+    uint64_t key;
+    bool write;
+};
+
+template <typename Map>
+double replay(std::vector<uint64_t> const & keys, std::vector<std::vector<Op>> const & traces, size_t n_threads) {
+    Map map;
+    for(uint64_t key : keys) {
+        map.insert_or_assign(key, key);
+    }
+
+    std::vector<std::thread> threads;
+    Stopwatch sw;
+    for(size_t tid = 0; tid < n_threads; tid++) {
+        threads.emplace_back([&map, &trace = traces[tid]]() {
+            uint64_t sum = 0;
+            for(Op const & op : trace) {
+                if(op.write) {
+                    map.insert_or_assign(op.key, op.key ^ 0x5555);
+                } else if(std::optional<uint64_t> value = map.find(op.key)) {
+                    sum += *value;
+                }
+            }
+            // keeps the lookups from being optimized away
+            if(sum == 42) {
+                std::cout << "";
+            }
+        });
+    }
+    for(std::thread & thread : threads) {
+        thread.join();
+    }
+    double seconds = sw.elapsed();
+    return n_threads * N_OPS_PER_THREAD / seconds / 1e6;
+}
+
+// a sharded map sized like the locked one
+struct ShardedMap : ConcurrentUnorderedMap<uint64_t, uint64_t> {
+    ShardedMap() : ConcurrentUnorderedMap(N_KEYS, N_SHARDS) { }
+};
+
+int main() {
+    Typegen t;
+    ZipfDistribution zipf(N_KEYS, ZIPF_EXPONENT);
+
+    std::vector<uint64_t> keys(N_KEYS);
+    t.fill_unique(keys.begin(), keys.end());
+
+    size_t max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    size_t n_traces = std::max<size_t>(max_threads, 8);
+
+    std::cout << "Shared maps: " << N_OPS_PER_THREAD << " operations per thread, "
+              << N_KEYS << " keys, " << N_SHARDS << " shards, "
+              << max_threads << " hardware threads" << std::endl;
+
+    for(double write_ratio : { 0.01, 0.1, 0.5 }) {
+        std::vector<std::vector<Op>> traces(n_traces);
+        for(auto & trace : traces) {
+            trace.resize(N_OPS_PER_THREAD);
+            for(Op & op : trace) {
+                op = { keys[zipf(t)], t.get<bool>(write_ratio) };
+            }
+        }
+
+        std::cout << std::endl << static_cast<int>(100 * write_ratio) << "% writes" << std::endl;
+        for(size_t n_threads = 1; n_threads <= n_traces; n_threads *= 2) {
+            std::string threads = std::to_string(n_threads) + " thread(s), ";
+            report(threads + "single mutex", replay<LockedUnorderedMap>(keys, traces, n_threads), "Mops/s");
+            report(threads + "sharded", replay<ShardedMap>(keys, traces, n_threads), "Mops/s");
+        }
+    }
+
+    return 0;
+}
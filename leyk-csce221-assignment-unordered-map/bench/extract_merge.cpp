@@ -0,0 +1,65 @@
+#include "bench.h"
+#include "UnorderedMap.h"
+#include "hash_functions.h"
+
+#include <cstdint>
+
+/*
+    Promoting a staging map into the live one, as a periodic table swap
+    does: copying each element over and erasing it from the staging map,
+    against merge, which relinks the nodes. Half the staged keys are new
+    to the live map.
+*/
+
+constexpr size_t N_LIVE = 1 << 19;
+constexpr size_t N_STAGED = 1 << 18;
+constexpr size_t N_ROUNDS = 8;
+
+using Map = UnorderedMap<std::string, uint64_t, fnv1a_hash>;
+
+int main() {
+    Typegen t;
+    std::vector<std::string> keys = animal_keys(N_LIVE + N_STAGED / 2, t);
+
+    double copy_seconds = 0;
+    double merge_seconds = 0;
+    uint64_t copy_size = 0;
+    uint64_t merge_size = 0;
+    for(size_t round = 0; round < N_ROUNDS; round++) {
+        Map live(2 * keys.size()), staging(N_STAGED);
+        live.max_load_factor(1);
+        staging.max_load_factor(1);
+        for(size_t i = 0; i < N_LIVE; i++) {
+            live.insert({ keys[i], i });
+        }
+        for(size_t i = 0; i < N_STAGED; i++) {
+            staging.insert({ keys[N_LIVE - N_STAGED / 2 + i], i });
+        }
+        Map live_copy(live), staging_copy(staging);
+
+        Stopwatch sw;
+        for(auto it = staging.begin(); it != staging.end();) {
+            if(live.insert(*it).second) {
+                it = staging.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        copy_seconds += sw.elapsed();
+        copy_size += live.size() + staging.size();
+
+        sw.reset();
+        live_copy.merge(staging_copy);
+        merge_seconds += sw.elapsed();
+        merge_size += live_copy.size() + staging_copy.size();
+    }
+
+    std::cout << "Promoting " << N_STAGED << " staged keys into " << N_LIVE << " live ones" << std::endl << std::endl;
+    report("insert + erase", 1e3 * copy_seconds / N_ROUNDS, "ms");
+    report("merge", 1e3 * merge_seconds / N_ROUNDS, "ms");
+    if(copy_size != merge_size) {
+        std::cout << "results differ" << std::endl;
+        return 1;
+    }
+    return 0;
+}
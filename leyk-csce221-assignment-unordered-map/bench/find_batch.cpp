@@ -0,0 +1,65 @@
+#include "bench.h"
+#include "UnorderedMap.h"
+
+#include <cstdint>
+
+/*
+    The probe side of a hash join: looking up a long run of random keys,
+    half of them present, in a map far larger than the last-level cache,
+    with find on one key at a time and with find_batch.
+*/
+
+constexpr size_t N_KEYS = 1 << 23;
+constexpr size_t N_PROBES = 1 << 23;
+
+using Map = UnorderedMap<uint64_t, uint64_t>;
+
+int main() {
+    Typegen t;
+
+    std::vector<uint64_t> keys(2 * N_KEYS);
+    t.fill_unique(keys.begin(), keys.end());
+
+    Map map(N_KEYS);
+    map.max_load_factor(1);
+    for(size_t i = 0; i < N_KEYS; i++) {
+        map.insert({ keys[i], i });
+    }
+
+    // the second half of keys never made it into the map
+    std::vector<uint64_t> probes(N_PROBES);
+    for(uint64_t & probe : probes) {
+        probe = keys[t.range(keys.size())];
+    }
+
+    std::cout << "UnorderedMap probes, " << N_KEYS << " uint64_t keys, " << N_PROBES << " lookups" << std::endl << std::endl;
+
+    Stopwatch sw;
+    uint64_t sum = 0;
+    for(uint64_t probe : probes) {
+        auto it = map.find(probe);
+        if(it != map.end()) {
+            sum += it->second;
+        }
+    }
+    double find_seconds = sw.elapsed();
+
+    std::vector<Map::iterator> found(N_PROBES);
+    sw.reset();
+    map.find_batch(probes.data(), probes.size(), found.data());
+    uint64_t batch_sum = 0;
+    for(Map::iterator it : found) {
+        if(it != map.end()) {
+            batch_sum += it->second;
+        }
+    }
+    double batch_seconds = sw.elapsed();
+
+    report("find", 1e9 * find_seconds / N_PROBES, "ns/lookup");
+    report("find_batch", 1e9 * batch_seconds / N_PROBES, "ns/lookup");
+    if(sum != batch_sum) {
+        std::cout << "results differ" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "bench.h"
+#include "FlatUnorderedMap.h"
+#include "UnorderedMap.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+/*
+    Builds a map from scratch, then looks up every key that is present and
+    as many that are not. UnorderedMap grows at load factor 1 like
+    std::unordered_map, so the three maps differ only in layout.
+*/
+
+constexpr size_t N_KEYS = 1 << 19;
+
+template <typename Map, typename Key>
+void measure(std::string const & name, std::vector<Key> const & keys, std::vector<Key> const & misses, Map & map) {
+    Stopwatch sw;
+    for(Key const & key : keys) {
+        map.insert({ key, 1 });
+    }
+    double insert_seconds = sw.elapsed();
+
+    size_t found = 0;
+    sw.reset();
+    for(Key const & key : keys) {
+        found += map.find(key) != map.end();
+    }
+    double hit_seconds = sw.elapsed();
+
+    sw.reset();
+    for(Key const & key : misses) {
+        found += map.find(key) != map.end();
+    }
+    double miss_seconds = sw.elapsed();
+
+    if(found != keys.size()) {
+        std::cout << "  " << name << " lost keys" << std::endl;
+    }
+    report(name + " insert", 1e9 * insert_seconds / keys.size(), "ns/op");
+    report(name + " find hit", 1e9 * hit_seconds / keys.size(), "ns/op");
+    report(name + " find miss", 1e9 * miss_seconds / misses.size(), "ns/op");
+}
+
+template <typename Key>
+void compare(std::string const & label, std::vector<Key> const & keys, std::vector<Key> const & misses) {
+    std::cout << std::endl << label << ", " << keys.size() << " keys" << std::endl;
+    {
+        std::unordered_map<Key, uint64_t> map;
+        measure("std::unordered_map", keys, misses, map);
+    }
+    {
+        UnorderedMap<Key, uint64_t> map(1);
+        map.max_load_factor(1);
+        measure("UnorderedMap", keys, misses, map);
+    }
+    {
+        FlatUnorderedMap<Key, uint64_t> map;
+        measure("FlatUnorderedMap", keys, misses, map);
+    }
+}
+
+int main() {
+    Typegen t;
+
+    std::vector<uint64_t> integers(2 * N_KEYS);
+    t.fill_unique(integers.begin(), integers.end());
+    std::vector<uint64_t> integer_misses(integers.begin() + N_KEYS, integers.end());
+    integers.resize(N_KEYS);
+
+    std::vector<std::string> animals = animal_keys(2 * N_KEYS, t);
+    std::vector<std::string> animal_misses(animals.begin() + animals.size() / 2, animals.end());
+    animals.resize(animals.size() / 2);
+
+    std::cout << "Hash maps: node-based vs flat" << std::endl;
+    compare("uint64_t keys", integers, integer_misses);
+    compare("\"Adjective Animal\" keys", animals, animal_misses);
+}
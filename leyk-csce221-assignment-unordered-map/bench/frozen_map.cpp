@@ -0,0 +1,75 @@
+#include "bench.h"
+#include "FrozenMap.h"
+#include "hash_functions.h"
+
+#include <cstdint>
+
+/*
+    Startup and lookups for a static table of "Adjective Animal" keys:
+    building an UnorderedMap from the key list, as every process start
+    does today, against opening a FrozenMap file written once beforehand.
+*/
+
+constexpr size_t N_KEYS = 1 << 20;
+constexpr size_t N_LOOKUPS = 1 << 22;
+
+const std::string PATH = "build/animals.frozen";
+
+int main() {
+    Typegen t;
+    std::vector<std::string> keys = animal_keys(N_KEYS, t);
+
+    Stopwatch sw;
+    UnorderedMap<std::string, uint64_t, fnv1a_hash> map(keys.size());
+    map.max_load_factor(1);
+    for(size_t i = 0; i < keys.size(); i++) {
+        map.insert({ keys[i], i });
+    }
+    double build_seconds = sw.elapsed();
+
+    sw.reset();
+    if(!freeze(map, PATH)) {
+        std::cout << "could not write " << PATH << std::endl;
+        return 1;
+    }
+    double freeze_seconds = sw.elapsed();
+
+    sw.reset();
+    FrozenMap<std::string, uint64_t> frozen(PATH);
+    double open_seconds = sw.elapsed();
+    if(!frozen.is_open()) {
+        std::cout << "could not open " << PATH << std::endl;
+        return 1;
+    }
+
+    std::vector<const std::string *> lookups(N_LOOKUPS);
+    for(const std::string *& key : lookups) {
+        key = &keys[t.range(keys.size())];
+    }
+
+    sw.reset();
+    uint64_t sum = 0;
+    for(const std::string * key : lookups) {
+        sum += map.find(*key)->second;
+    }
+    double map_seconds = sw.elapsed();
+
+    sw.reset();
+    uint64_t frozen_sum = 0;
+    for(const std::string * key : lookups) {
+        frozen_sum += *frozen.find(*key);
+    }
+    double frozen_seconds = sw.elapsed();
+
+    std::cout << "Static tables, " << keys.size() << " keys" << std::endl << std::endl;
+    report("UnorderedMap build", 1e3 * build_seconds, "ms");
+    report("freeze to file", 1e3 * freeze_seconds, "ms");
+    report("FrozenMap open", 1e3 * open_seconds, "ms", 4);
+    report("UnorderedMap find", 1e9 * map_seconds / N_LOOKUPS, "ns/lookup");
+    report("FrozenMap find", 1e9 * frozen_seconds / N_LOOKUPS, "ns/lookup");
+    if(sum != frozen_sum) {
+        std::cout << "results differ" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include "bench.h"
+#include "UnorderedMap.h"
+
+#include <cstdint>
+
+/*
+    Per-insert latency while a map grows from empty, with rehashing done
+    at once and incrementally. A rehash at once relinks the whole table in
+    one insert, which only shows at the far end of the tail; moving a few
+    buckets per insert instead costs every insert made during a rehash a
+    little, so the lower percentiles and the total get somewhat worse.
+*/
+
+constexpr size_t N_KEYS = 1 << 23;
+
+void measure(std::string const & name, std::vector<uint64_t> const & keys, bool incremental) {
+    UnorderedMap<uint64_t, uint64_t> map(1);
+    map.max_load_factor(1);
+    map.incremental_rehash(incremental);
+
+    std::vector<double> latencies(keys.size());
+    Stopwatch total;
+    for(size_t i = 0; i < keys.size(); i++) {
+        Stopwatch sw;
+        map.insert({ keys[i], keys[i] });
+        latencies[i] = 1e9 * sw.elapsed();
+    }
+    double total_seconds = total.elapsed();
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) { return latencies[static_cast<size_t>(p * (latencies.size() - 1))]; };
+
+    std::cout << std::endl << name << std::endl;
+    report("total", 1e9 * total_seconds / keys.size(), "ns/insert");
+    report("p50", percentile(0.5), "ns");
+    report("p99", percentile(0.99), "ns");
+    report("p99.9", percentile(0.999), "ns");
+    report("p99.99", percentile(0.9999), "ns");
+    report("p99.999", percentile(0.99999), "ns");
+    report("max", latencies.back() / 1e6, "ms");
+}
+
+int main() {
+    Typegen t;
+
+    std::vector<uint64_t> keys(N_KEYS);
+    t.fill_unique(keys.begin(), keys.end());
+
+    std::cout << "UnorderedMap insert latency, " << N_KEYS << " uint64_t keys, max load factor 1" << std::endl;
+    measure("rehash at once", keys, false);
+    measure("incremental rehash", keys, true);
+}
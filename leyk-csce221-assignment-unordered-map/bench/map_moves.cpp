@@ -0,0 +1,43 @@
+#include "bench.h"
+#include "UnorderedMap.h"
+
+#include <cstdint>
+#include <type_traits>
+
+/*
+    Growing a std::vector of maps. The vector relocates its maps on every
+    reallocation, moving them only when the move constructor is noexcept
+    and copying every node otherwise.
+*/
+
+constexpr size_t N_MAPS = 1 << 14;
+constexpr size_t N_KEYS = 64;
+constexpr size_t N_ROUNDS = 8;
+
+using Map = UnorderedMap<uint64_t, uint64_t>;
+
+int main() {
+    double seconds = 0;
+    uint64_t sum = 0;
+    for(size_t round = 0; round < N_ROUNDS; round++) {
+        Stopwatch sw;
+        std::vector<Map> maps;
+        for(size_t i = 0; i < N_MAPS; i++) {
+            maps.emplace_back(N_KEYS);
+            for(uint64_t k = 0; k < N_KEYS; k++) {
+                maps.back().insert({ k, i });
+            }
+        }
+        seconds += sw.elapsed();
+        sum += maps.back().find(0)->second;
+    }
+
+    std::cout << "Filling a std::vector with " << N_MAPS << " maps of " << N_KEYS << " keys" << std::endl;
+    std::cout << "  move constructor noexcept: " << std::is_nothrow_move_constructible<Map>::value << std::endl << std::endl;
+    report("push_back and fill", 1e3 * seconds / N_ROUNDS, "ms");
+    if(sum != N_ROUNDS * (N_MAPS - 1)) {
+        std::cout << "wrong result" << std::endl;
+        return 1;
+    }
+    return 0;
+}
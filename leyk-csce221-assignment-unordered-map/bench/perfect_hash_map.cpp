@@ -0,0 +1,78 @@
+#include "bench.h"
+#include "PerfectHashMap.h"
+#include "UnorderedMap.h"
+#include "hash_functions.h"
+
+#include <cstdint>
+
+/*
+    Lookups in a static table of "Adjective Animal" keys: the chained
+    UnorderedMap against a PerfectHashMap built from it, which probes
+    exactly one slot per lookup.
+*/
+
+constexpr size_t N_KEYS = 1 << 20;
+constexpr size_t N_LOOKUPS = 1 << 22;
+
+int main() {
+    Typegen t;
+    std::vector<std::string> keys = animal_keys(N_KEYS, t);
+
+    Stopwatch sw;
+    UnorderedMap<std::string, uint64_t, fnv1a_hash> map(keys.size());
+    map.max_load_factor(1);
+    for(size_t i = 0; i < keys.size(); i++) {
+        map.insert({ keys[i], i });
+    }
+    double map_build_seconds = sw.elapsed();
+
+    sw.reset();
+    PerfectHashMap<std::string, uint64_t, fnv1a_hash> perfect;
+    if(!perfect.build(map.cbegin(), map.cend())) {
+        std::cout << "could not build the perfect hash" << std::endl;
+        return 1;
+    }
+    double perfect_build_seconds = sw.elapsed();
+
+    // every key is found, in a slot of its own
+    std::vector<bool> seen(perfect.size(), false);
+    for(const std::string & key : keys) {
+        size_t slot = perfect.index(key);
+        if(perfect.find(key) == nullptr || seen[slot]) {
+            std::cout << "not a perfect hash" << std::endl;
+            return 1;
+        }
+        seen[slot] = true;
+    }
+
+    std::vector<const std::string *> lookups(N_LOOKUPS);
+    for(const std::string *& key : lookups) {
+        key = &keys[t.range(keys.size())];
+    }
+
+    sw.reset();
+    uint64_t sum = 0;
+    for(const std::string * key : lookups) {
+        sum += map.find(*key)->second;
+    }
+    double map_seconds = sw.elapsed();
+
+    sw.reset();
+    uint64_t perfect_sum = 0;
+    for(const std::string * key : lookups) {
+        perfect_sum += *perfect.find(*key);
+    }
+    double perfect_seconds = sw.elapsed();
+
+    std::cout << "Static tables, " << keys.size() << " keys" << std::endl << std::endl;
+    report("UnorderedMap build", 1e3 * map_build_seconds, "ms");
+    report("PerfectHashMap build", 1e3 * perfect_build_seconds, "ms");
+    report("PerfectHashMap hash size", perfect.bits_per_key(), "bits/key");
+    report("UnorderedMap find", 1e9 * map_seconds / N_LOOKUPS, "ns/lookup");
+    report("PerfectHashMap find", 1e9 * perfect_seconds / N_LOOKUPS, "ns/lookup");
+    if(sum != perfect_sum) {
+        std::cout << "results differ" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include "bench.h"
+#include "PoolAllocator.h"
+#include "UnorderedMap.h"
+
+#include <cstdint>
+
+/*
+    UnorderedMap with the default allocator against PoolAllocator: filling
+    a map, churning it with erase + insert pairs, and tearing it down,
+    both with clear() and with the erase(begin()) loop clear() used to be.
+*/
+
+constexpr size_t N_KEYS = 1 << 20;
+
+template <typename Map>
+void measure(std::string const & name, std::vector<uint64_t> const & keys) {
+    Map map(1);
+    map.max_load_factor(1);
+
+    Stopwatch sw;
+    for(uint64_t key : keys) {
+        map.insert({ key, key });
+    }
+    double insert_seconds = sw.elapsed();
+
+    // erases each key and puts it back, so every insert can reuse a freed node
+    sw.reset();
+    for(uint64_t key : keys) {
+        map.erase(key);
+        map.insert({ key, key });
+    }
+    double churn_seconds = sw.elapsed();
+
+    // both teardowns start from a fresh copy, so they walk the same memory layout
+    Map cleared(map);
+    sw.reset();
+    cleared.clear();
+    double clear_seconds = sw.elapsed();
+
+    Map erased(map);
+    sw.reset();
+    while(!erased.empty()) {
+        erased.erase(erased.begin());
+    }
+    double erase_seconds = sw.elapsed();
+
+    report(name + " insert", 1e9 * insert_seconds / keys.size(), "ns/op");
+    report(name + " erase + insert", 1e9 * churn_seconds / keys.size(), "ns/op");
+    report(name + " clear", 1e9 * clear_seconds / keys.size(), "ns/element");
+    report(name + " erase(begin()) loop", 1e9 * erase_seconds / keys.size(), "ns/element");
+}
+
+int main() {
+    Typegen t;
+
+    std::vector<uint64_t> keys(N_KEYS);
+    t.fill_unique(keys.begin(), keys.end());
+
+    using Pair = std::pair<const uint64_t, uint64_t>;
+
+    std::cout << "UnorderedMap allocators, " << N_KEYS << " uint64_t keys" << std::endl << std::endl;
+    measure<UnorderedMap<uint64_t, uint64_t>>("std::allocator", keys);
+    measure<UnorderedMap<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, PoolAllocator<Pair>>>("PoolAllocator", keys);
+}
@@ -0,0 +1,127 @@
+#include "bench.h"
+#include "ConcurrentUnorderedMap.h"
+#include "ReadMostlyMap.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+/*
+    Read throughput of a routing-style table while one writer publishes a
+    small batch of updates every millisecond, for ConcurrentUnorderedMap
+    (shared locks) and ReadMostlyMap (lock-free snapshots), as reader
+    threads are added.
+*/
+
+constexpr size_t N_KEYS = 1 << 16;
+constexpr size_t N_READS_PER_THREAD = 1 << 21;
+constexpr size_t BATCH_SIZE = 64;
+constexpr auto WRITE_INTERVAL = std::chrono::milliseconds(1);
+
+struct SnapshotTable {
+    ReadMostlyMap<uint64_t, uint64_t> map { N_KEYS };
+
+    // each thread keeps its own handle
+    struct Reader {
+        ReadMostlyMap<uint64_t, uint64_t>::Reader reader;
+        std::optional<uint64_t> find(uint64_t key) { return reader.find(key); }
+    };
+
+    Reader reader() { return Reader { map.reader() }; }
+
+    void write(std::vector<uint64_t> const & keys, uint64_t value) {
+        map.update([&](ReadMostlyMap<uint64_t, uint64_t>::Batch & batch) {
+            for(uint64_t key : keys) {
+                batch.insert_or_assign(key, value);
+            }
+        });
+    }
+};
+
+struct ShardedTable {
+    ConcurrentUnorderedMap<uint64_t, uint64_t> map { N_KEYS, 64 };
+
+    struct Reader {
+        ConcurrentUnorderedMap<uint64_t, uint64_t> & map;
+        std::optional<uint64_t> find(uint64_t key) { return map.find(key); }
+    };
+
+    Reader reader() { return Reader { map }; }
+
+    void write(std::vector<uint64_t> const & keys, uint64_t value) {
+        for(uint64_t key : keys) {
+            map.insert_or_assign(key, value);
+        }
+    }
+};
+
+template <typename Table>
+double replay(std::vector<uint64_t> const & keys, std::vector<std::vector<uint64_t>> const & traces, size_t n_threads) {
+    Table table;
+    table.write(keys, 0);
+
+    std::atomic<bool> done { false };
+    std::thread writer([&]() {
+        Typegen t(1);
+        std::vector<uint64_t> batch(BATCH_SIZE);
+        for(uint64_t value = 1; !done; value++) {
+            for(uint64_t & key : batch) {
+                key = keys[t.range(keys.size())];
+            }
+            table.write(batch, value);
+            std::this_thread::sleep_for(WRITE_INTERVAL);
+        }
+    });
+
+    std::vector<std::thread> threads;
+    Stopwatch sw;
+    for(size_t tid = 0; tid < n_threads; tid++) {
+        threads.emplace_back([&table, &trace = traces[tid]]() {
+            auto reader = table.reader();
+            uint64_t sum = 0;
+            for(uint64_t key : trace) {
+                sum += reader.find(key).value_or(0);
+            }
+            // keeps the lookups from being optimized away
+            if(sum == 42) {
+                std::cout << "";
+            }
+        });
+    }
+    for(std::thread & thread : threads) {
+        thread.join();
+    }
+    double seconds = sw.elapsed();
+    done = true;
+    writer.join();
+    return n_threads * N_READS_PER_THREAD / seconds / 1e6;
+}
+
+int main() {
+    Typegen t;
+
+    std::vector<uint64_t> keys(N_KEYS);
+    t.fill_unique(keys.begin(), keys.end());
+
+    size_t max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    std::vector<std::vector<uint64_t>> traces(std::max<size_t>(max_threads, 8));
+    for(auto & trace : traces) {
+        trace.resize(N_READS_PER_THREAD);
+        for(uint64_t & key : trace) {
+            key = keys[t.range(keys.size())];
+        }
+    }
+
+    std::cout << "Read-mostly tables: " << N_READS_PER_THREAD << " reads per thread, "
+              << N_KEYS << " keys, a batch of " << BATCH_SIZE << " writes every "
+              << WRITE_INTERVAL.count() << "ms, " << max_threads << " hardware threads" << std::endl;
+
+    for(size_t n_threads = 1; n_threads <= traces.size(); n_threads *= 2) {
+        std::cout << std::endl << n_threads << " reader thread(s)" << std::endl;
+        report("ConcurrentUnorderedMap", replay<ShardedTable>(keys, traces, n_threads), "Mops/s");
+        report("ReadMostlyMap", replay<SnapshotTable>(keys, traces, n_threads), "Mops/s");
+    }
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "bench.h"
+#include "FlatUnorderedMap.h"
+#include "RobinHoodMap.h"
+#include "UnorderedMap.h"
+
+#include <cstdint>
+
+/*
+    Fills each map with the same keys, RobinHoodMap to just under its 0.9
+    maximum load factor, then measures lookups of present and absent keys
+    and a churn phase that erases one key and inserts a new one per step,
+    which is where tombstones would pile up.
+    RobinHoodMap also reports the spread of its probe distances.
+*/
+
+constexpr size_t N_KEYS = 1 << 19;
+
+template <typename Map>
+void measure(std::string const & name, Map & map, std::vector<uint64_t> const & keys,
+             std::vector<uint64_t> const & misses) {
+    for(uint64_t key : keys) {
+        map.insert({ key, key });
+    }
+
+    size_t found = 0;
+    Stopwatch sw;
+    for(uint64_t key : keys) {
+        found += map.find(key) != map.end();
+    }
+    double hit_seconds = sw.elapsed();
+
+    sw.reset();
+    for(uint64_t key : misses) {
+        found += map.find(key) != map.end();
+    }
+    double miss_seconds = sw.elapsed();
+
+    // each miss key replaces a present key, keeping the size constant
+    sw.reset();
+    for(size_t i = 0; i < misses.size(); i++) {
+        map.erase(keys[i]);
+        map.insert({ misses[i], 0 });
+    }
+    double churn_seconds = sw.elapsed();
+
+    if(found != keys.size() || map.size() != keys.size()) {
+        std::cout << "  " << name << " lost keys" << std::endl;
+    }
+    report(name + " load factor", map.load_factor(), "");
+    report(name + " find hit", 1e9 * hit_seconds / keys.size(), "ns/op");
+    report(name + " find miss", 1e9 * miss_seconds / misses.size(), "ns/op");
+    report(name + " erase + insert", 1e9 * churn_seconds / misses.size(), "ns/op");
+}
+
+int main() {
+    Typegen t;
+
+    std::vector<uint64_t> keys(2 * N_KEYS);
+    t.fill_unique(keys.begin(), keys.end());
+    std::vector<uint64_t> misses(keys.begin() + N_KEYS, keys.end());
+    keys.resize(N_KEYS);
+
+    std::cout << "High load factor maps, " << N_KEYS << " uint64_t keys" << std::endl << std::endl;
+    {
+        UnorderedMap<uint64_t, uint64_t> map(1);
+        map.max_load_factor(1);
+        measure("UnorderedMap", map, keys, misses);
+    }
+    {
+        FlatUnorderedMap<uint64_t, uint64_t> map;
+        measure("FlatUnorderedMap", map, keys, misses);
+    }
+    {
+        // sized so the keys land just under the 0.9 limit
+        RobinHoodMap<uint64_t, uint64_t> map(static_cast<size_t>(N_KEYS / 0.9) + 1);
+        measure("RobinHoodMap", map, keys, misses);
+
+        std::vector<size_t> histogram = map.probe_histogram();
+        double mean = 0;
+        for(size_t k = 0; k < histogram.size(); k++) {
+            mean += static_cast<double>(k) * histogram[k];
+        }
+        mean /= map.size();
+        double variance = 0;
+        for(size_t k = 0; k < histogram.size(); k++) {
+            variance += (k - mean) * (k - mean) * histogram[k];
+        }
+        variance /= map.size();
+        report("RobinHoodMap mean probe distance", mean, "slots");
+        report("RobinHoodMap probe variance", variance, "slots^2");
+        report("RobinHoodMap longest probe distance", histogram.size() - 1, "slots", 0);
+    }
+}
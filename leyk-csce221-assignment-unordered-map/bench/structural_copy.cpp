@@ -0,0 +1,49 @@
+#include "bench.h"
+#include "UnorderedMap.h"
+
+#include <cstdint>
+
+/*
+    Copying a large map: the copy constructor and copy assignment, which
+    clone the chain node by node, against rebuilding the map with one
+    insert per element, which is what both used to do.
+*/
+
+constexpr size_t N_KEYS = 1 << 20;
+
+using Map = UnorderedMap<uint64_t, uint64_t>;
+
+int main() {
+    Typegen t;
+
+    std::vector<uint64_t> keys(N_KEYS);
+    t.fill_unique(keys.begin(), keys.end());
+
+    Map map(1);
+    map.max_load_factor(1);
+    for(uint64_t key : keys) {
+        map.insert({ key, key });
+    }
+
+    Stopwatch sw;
+    Map rebuilt(map.bucket_count());
+    rebuilt.max_load_factor(1);
+    for(auto const & pair : map) {
+        rebuilt.insert(pair);
+    }
+    double rebuild_seconds = sw.elapsed();
+
+    sw.reset();
+    Map copied(map);
+    double copy_seconds = sw.elapsed();
+
+    // copied already holds as many nodes as map, so assignment reuses all of them
+    sw.reset();
+    copied = map;
+    double assign_seconds = sw.elapsed();
+
+    std::cout << "UnorderedMap copies, " << N_KEYS << " uint64_t keys" << std::endl << std::endl;
+    report("insert loop", 1e9 * rebuild_seconds / keys.size(), "ns/element");
+    report("copy constructor", 1e9 * copy_seconds / keys.size(), "ns/element");
+    report("copy assignment", 1e9 * assign_seconds / keys.size(), "ns/element");
+}
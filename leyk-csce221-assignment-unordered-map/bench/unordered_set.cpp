@@ -0,0 +1,72 @@
+#include "bench.h"
+#include "UnorderedMap.h"
+#include "UnorderedSet.h"
+
+#include <cstdint>
+#include <memory>
+
+/*
+    A set of keys held as UnorderedSet, against the usual stand-in of an
+    UnorderedMap with a dummy bool value, which pads every node out to the
+    pair's alignment. Both run on the same engine, so only the node size
+    differs.
+*/
+
+constexpr size_t N_KEYS = 1 << 20;
+constexpr size_t N_ROUNDS = 4;
+
+// counts the bytes handed out, which for a node container is nodes and buckets
+size_t allocated_bytes = 0;
+
+template <typename T>
+struct counting_allocator : std::allocator<T> {
+    using value_type = T;
+    template <typename U>
+    struct rebind { using other = counting_allocator<U>; };
+
+    counting_allocator() = default;
+    template <typename U>
+    counting_allocator(const counting_allocator<U> &) noexcept { }
+
+    T * allocate(size_t n) {
+        allocated_bytes += n * sizeof(T);
+        return std::allocator<T>::allocate(n);
+    }
+};
+
+template <typename Set, typename Insert>
+void run(const std::string & label, Insert insert) {
+    double insert_seconds = 0, find_seconds = 0;
+    size_t bytes = 0;
+    uint64_t found = 0;
+    for(size_t round = 0; round < N_ROUNDS; round++) {
+        allocated_bytes = 0;
+        Stopwatch sw;
+        Set set(N_KEYS);
+        for(uint64_t k = 0; k < N_KEYS; k++) {
+            insert(set, k * 0x9E3779B97F4A7C15ull);
+        }
+        insert_seconds += sw.elapsed();
+        bytes = allocated_bytes;
+        sw.reset();
+        for(uint64_t k = 0; k < 2 * N_KEYS; k++) {
+            found += set.contains(k * 0x9E3779B97F4A7C15ull);
+        }
+        find_seconds += sw.elapsed();
+    }
+    if(found != N_ROUNDS * N_KEYS) {
+        std::cout << "wrong result" << std::endl;
+    }
+    report(label + " bytes per key", static_cast<double>(bytes) / N_KEYS, "B");
+    report(label + " insert", 1e3 * insert_seconds / N_ROUNDS, "ms");
+    report(label + " contains, half hits", 1e3 * find_seconds / N_ROUNDS, "ms");
+}
+
+int main() {
+    std::cout << N_KEYS << " uint64_t keys" << std::endl << std::endl;
+    run<UnorderedSet<uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, counting_allocator<uint64_t>>>(
+        "UnorderedSet", [](auto & set, uint64_t key) { set.insert(key); });
+    run<UnorderedMap<uint64_t, bool, std::hash<uint64_t>, std::equal_to<uint64_t>, counting_allocator<std::pair<const uint64_t, bool>>>>(
+        "UnorderedMap<K, bool>", [](auto & map, uint64_t key) { map.insert({ key, true }); });
+    return 0;
+}
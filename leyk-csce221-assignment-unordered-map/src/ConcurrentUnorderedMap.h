@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cstddef>      // size_t
+#include <cstdint>      // uint64_t
+#include <functional>   // std::hash, std::equal_to
+#include <memory>       // std::unique_ptr
+#include <mutex>        // std::unique_lock
+#include <optional>     // std::optional
+#include <shared_mutex> // std::shared_mutex, std::shared_lock
+#include <utility>      // std::move, std::forward
+#include <vector>       // std::vector
+
+#include "UnorderedMap.h"
+
+/*
+    Thread-safe hash map split into independently locked shards.
+
+    Each key is routed to a shard by the top bits of its (mixed) hash, and
+    every shard is a plain UnorderedMap behind its own std::shared_mutex.
+    Lookups take the shard's shared lock, so readers never block each
+    other; writers lock only the shard they modify. The top bits are used
+    so the shard index stays independent of the bucket index inside the
+    shard, which is taken from the whole hash code. Keys are hashed once:
+    the shard's map gets the same code through its *_hashed members.
+
+    Nothing hands out iterators or references into a shard, since they
+    would outlive the lock: find returns a copy of the value, and for_each
+    calls back while the shard is locked.
+*/
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename Pred = std::equal_to<Key>>
+class ConcurrentUnorderedMap {
+    public:
+
+    using key_type = Key;
+    using mapped_type = T;
+    using size_type = size_t;
+    using hasher = Hash;
+    using key_equal = Pred;
+
+    static constexpr size_type DEFAULT_SHARDS = 16;
+
+    private:
+
+    using map_type = UnorderedMap<Key, T, Hash, Pred>;
+
+    struct alignas(64) Shard {
+        std::shared_mutex lock;
+        map_type map;
+
+        Shard(size_type bucket_count, const Hash & hash, const Pred & equal) : map(bucket_count, hash, equal) {
+            // an UnorderedMap never rehashes by default
+            map.max_load_factor(1);
+        }
+    };
+
+    // shards are heap allocated individually since they hold a mutex
+    std::vector<std::unique_ptr<Shard>> _shards;
+    size_type _n_shards;
+    size_type _shard_bits;
+    Hash _hash;
+
+    // the shard of the key hashing to code; fibonacci hashing spreads weak hash codes over the shard index
+    Shard & _shard(size_type code) const {
+        uint64_t mixed = static_cast<uint64_t>(code) * 0x9E3779B97F4A7C15ull;
+        return *_shards[_shard_bits == 0 ? 0 : mixed >> (64 - _shard_bits)];
+    }
+
+    public:
+
+    /*
+        Creates a map of n_shards shards (rounded up to a power of two),
+        with room for about bucket_count elements between them before any
+        shard rehashes.
+    */
+    explicit ConcurrentUnorderedMap(size_type bucket_count = 0, size_type n_shards = DEFAULT_SHARDS,
+                const Hash & hash = Hash { }, const Pred & equal = Pred { })
+        : _n_shards(1)
+        , _shard_bits(0)
+        , _hash(hash)
+    {
+        while(_n_shards < n_shards) {
+            _n_shards <<= 1;
+            _shard_bits++;
+        }
+
+        size_type per_shard = (bucket_count + _n_shards - 1) / _n_shards;
+        _shards.reserve(_n_shards);
+        for(size_type i = 0; i < _n_shards; i++) {
+            _shards.emplace_back(new Shard(per_shard, hash, equal));
+        }
+    }
+
+    ConcurrentUnorderedMap(const ConcurrentUnorderedMap &) = delete;
+    ConcurrentUnorderedMap & operator=(const ConcurrentUnorderedMap &) = delete;
+
+    // returns a copy of the value mapped to key, or nothing
+    std::optional<T> find(const Key & key) const {
+        size_type code = _hash(key);
+        Shard & shard = _shard(code);
+        std::shared_lock<std::shared_mutex> guard(shard.lock);
+        const map_type & map = shard.map;
+        auto it = map.find_hashed(key, code);
+        if(it == map.cend()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    bool contains(const Key & key) const {
+        size_type code = _hash(key);
+        Shard & shard = _shard(code);
+        std::shared_lock<std::shared_mutex> guard(shard.lock);
+        return shard.map.contains_hashed(key, code);
+    }
+
+    // inserts or assigns value for key, returns true if a new element was inserted
+    bool insert_or_assign(const Key & key, T value) {
+        size_type code = _hash(key);
+        Shard & shard = _shard(code);
+        std::unique_lock<std::shared_mutex> guard(shard.lock);
+        // try_emplace only moves from value when it inserts
+        auto result = shard.map.try_emplace_hashed(key, code, std::move(value));
+        if(!result.second) {
+            result.first->second = std::move(value);
+        }
+        return result.second;
+    }
+
+    size_type erase(const Key & key) {
+        size_type code = _hash(key);
+        Shard & shard = _shard(code);
+        std::unique_lock<std::shared_mutex> guard(shard.lock);
+        return shard.map.erase_hashed(key, code);
+    }
+
+    /*
+        Returns a copy of the value mapped to key, first inserting make(key)
+        if there is none. A hit only takes the shared lock. On a miss make
+        runs under the shard's exclusive lock, so it is called at most once
+        per inserted key and must not call back into the map.
+    */
+    template <typename F>
+    T compute_if_absent(const Key & key, F && make) {
+        size_type code = _hash(key);
+        Shard & shard = _shard(code);
+        {
+            std::shared_lock<std::shared_mutex> guard(shard.lock);
+            const map_type & map = shard.map;
+            auto it = map.find_hashed(key, code);
+            if(it != map.cend()) {
+                return it->second;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> guard(shard.lock);
+        // another writer may have inserted key between the two locks
+        auto it = shard.map.find_hashed(key, code);
+        if(it == shard.map.end()) {
+            it = shard.map.try_emplace_hashed(key, code, std::forward<F>(make)(key)).first;
+        }
+        return it->second;
+    }
+
+    /*
+        Calls f(key, value) for every element, one shard at a time under
+        its shared lock. Each shard is seen in a consistent state, but
+        writes to shards not yet visited may show up while earlier ones
+        are already done. f must not call back into the map.
+    */
+    template <typename F>
+    void for_each(F && f) const {
+        for(size_type i = 0; i < _n_shards; i++) {
+            std::shared_lock<std::shared_mutex> guard(_shards[i]->lock);
+            const map_type & map = _shards[i]->map;
+            for(auto it = map.cbegin(); it != map.cend(); ++it) {
+                f(it->first, it->second);
+            }
+        }
+    }
+
+    void clear() {
+        for(size_type i = 0; i < _n_shards; i++) {
+            std::unique_lock<std::shared_mutex> guard(_shards[i]->lock);
+            _shards[i]->map.clear();
+        }
+    }
+
+    // locks one shard at a time, so under concurrent writes this is a sum of per-shard snapshots
+    size_type size() const {
+        size_type n = 0;
+        for(size_type i = 0; i < _n_shards; i++) {
+            std::shared_lock<std::shared_mutex> guard(_shards[i]->lock);
+            n += _shards[i]->map.size();
+        }
+        return n;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    size_type shard_count() const noexcept { return _n_shards; }
+};
@@ -0,0 +1,509 @@
+#pragma once
+
+#include <cstddef>    // size_t
+#include <cstdint>    // int8_t, uint8_t, uint32_t, uint64_t
+#include <cstring>    // std::memset, std::memcpy
+#include <functional> // std::hash, std::equal_to
+#include <iterator>   // std::forward_iterator_tag
+#include <memory>     // std::allocator
+#include <new>        // placement new
+#include <utility>    // std::pair, std::move
+
+#if defined(__SSE2__)
+#include <emmintrin.h> // _mm_set1_epi8, _mm_cmpeq_epi8, _mm_movemask_epi8
+#endif
+
+/*
+    Open-addressing hash map in the style of SwissTable.
+
+    Elements live directly in one array of slots; a parallel array holds one
+    control byte per slot: EMPTY, DELETED, or the low 7 bits of the element's
+    hash (its H2) when the slot is full. The slots are split into groups of
+    16 and a lookup probes whole groups, starting at the group picked by the
+    remaining hash bits (H1) and moving on quadratically. Inside a group one
+    SSE2 compare matches H2 against all 16 control bytes at once, so the keys
+    actually compared are nearly always equal ones, and a group with an EMPTY
+    byte ends the search.
+
+    Inserts allocate nothing until the table grows (at 7/8 full it doubles).
+    Erase only leaves a DELETED tombstone when the slot's group is full: a
+    group that still has an EMPTY byte has always had one, so no probe ever
+    went past it and the slot can simply become EMPTY again.
+
+    Unlike UnorderedMap, rehashing moves elements, so pointers and iterators
+    to elements are invalidated by any insert that grows the table. Slots
+    hold std::pair<Key, T> so that growing moves keys rather than copying
+    them; iterators view them as value_type, whose layout is the same.
+*/
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename Pred = std::equal_to<Key>>
+class FlatUnorderedMap {
+    public:
+
+    using key_type = Key;
+    using mapped_type = T;
+    using hasher = Hash;
+    using key_equal = Pred;
+    using value_type = std::pair<const key_type, mapped_type>;
+    using reference = value_type &;
+    using const_reference = const value_type &;
+    using pointer = value_type *;
+    using const_pointer = const value_type *;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    static constexpr size_type GROUP_WIDTH = 16;
+
+    private:
+
+    using ctrl_t = int8_t;
+    // what a slot really holds, so resizing moves keys rather than copy them
+    using slot_type = std::pair<key_type, mapped_type>;
+    static_assert(sizeof(slot_type) == sizeof(value_type) && alignof(slot_type) == alignof(value_type));
+
+    static constexpr ctrl_t EMPTY = -128;  // 0b10000000
+    static constexpr ctrl_t DELETED = -2;  // 0b11111110
+
+    static bool _is_full(ctrl_t c) { return c >= 0; }
+
+    // bitmask of the positions in a group that satisfy some test, lowest position first
+    struct BitMask {
+        static_assert(GROUP_WIDTH <= 32, "a group's positions must fit in the 32 mask bits");
+
+        uint32_t bits;
+
+        explicit operator bool() const { return bits != 0; }
+
+        // the lowest set position; bits must not be zero
+        size_type lowest() const {
+#if defined(__GNUC__)
+            return static_cast<size_type>(__builtin_ctz(bits));
+#else
+            // isolating the lowest bit and multiplying by a de Bruijn sequence puts its index in the top 5 bits
+            static constexpr uint8_t positions[32] = { 0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+                                                       31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9 };
+            return positions[static_cast<uint32_t>((bits & (~bits + 1)) * 0x077CB531u) >> 27];
+#endif
+        }
+        void clear_lowest() { bits &= bits - 1; }
+    };
+
+    // the 16 control bytes starting at ctrl
+    struct Group {
+#if defined(__SSE2__)
+        __m128i ctrl;
+
+        explicit Group(const ctrl_t * pos) : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pos))) { }
+
+        BitMask match(ctrl_t h2) const {
+            return BitMask { static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl))) };
+        }
+        BitMask match_empty() const { return match(EMPTY); }
+        // EMPTY and DELETED are the only negative bytes, so the sign bits are the mask
+        BitMask match_empty_or_deleted() const { return BitMask { static_cast<uint32_t>(_mm_movemask_epi8(ctrl)) }; }
+#else
+        // portable fallback with the same interface, one byte at a time
+        ctrl_t ctrl[GROUP_WIDTH];
+
+        explicit Group(const ctrl_t * pos) { std::memcpy(ctrl, pos, GROUP_WIDTH); }
+
+        BitMask match(ctrl_t h2) const {
+            uint32_t bits = 0;
+            for(size_type i = 0; i < GROUP_WIDTH; i++) {
+                bits |= static_cast<uint32_t>(ctrl[i] == h2) << i;
+            }
+            return BitMask { bits };
+        }
+        BitMask match_empty() const { return match(EMPTY); }
+        BitMask match_empty_or_deleted() const {
+            uint32_t bits = 0;
+            for(size_type i = 0; i < GROUP_WIDTH; i++) {
+                bits |= static_cast<uint32_t>(ctrl[i] < 0) << i;
+            }
+            return BitMask { bits };
+        }
+#endif
+    };
+
+    ctrl_t * _ctrl;
+    slot_type * _slots;
+    size_type _capacity;    // number of slots, zero or a power of two no smaller than GROUP_WIDTH
+    size_type _size;
+    size_type _growth_left; // inserts into EMPTY slots allowed before the table must grow
+
+    Hash _hash;
+    key_equal _equal;
+    std::allocator<slot_type> _alloc;
+
+    // slot index as the element the iterators hand out
+    value_type * _value(size_type index) const { return reinterpret_cast<value_type *>(_slots + index); }
+
+    // mixes the user's hash so weak ones (e.g. identity for integers) still spread over H1 and H2
+    size_type _mixed_hash(const Key & key) const {
+        uint64_t h = static_cast<uint64_t>(_hash(key)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_type>(h ^ (h >> 32));
+    }
+    static ctrl_t _h2(size_type hash) { return static_cast<ctrl_t>(hash & 0x7F); }
+    static size_type _h1(size_type hash) { return hash >> 7; }
+
+    size_type _group_mask() const { return _capacity / GROUP_WIDTH - 1; }
+
+    // a table of capacity slots may hold this many elements
+    static size_type _max_size_for(size_type capacity) { return capacity - capacity / 8; }
+
+    // index of the slot holding key, or _capacity if there is none
+    size_type _find_index(const Key & key, size_type hash) const {
+        if(_capacity == 0) {
+            return _capacity;
+        }
+        size_type group = _h1(hash) & _group_mask();
+        for(size_type step = 1; ; step++) {
+            Group g(_ctrl + group * GROUP_WIDTH);
+            for(BitMask m = g.match(_h2(hash)); m; m.clear_lowest()) {
+                size_type index = group * GROUP_WIDTH + m.lowest();
+                if(_equal(_slots[index].first, key)) {
+                    return index;
+                }
+            }
+            if(g.match_empty()) {
+                return _capacity;
+            }
+            group = (group + step) & _group_mask();
+        }
+    }
+
+    // first EMPTY or DELETED slot on hash's probe sequence
+    size_type _find_free(size_type hash) const {
+        size_type group = _h1(hash) & _group_mask();
+        for(size_type step = 1; ; step++) {
+            BitMask m = Group(_ctrl + group * GROUP_WIDTH).match_empty_or_deleted();
+            if(m) {
+                return group * GROUP_WIDTH + m.lowest();
+            }
+            group = (group + step) & _group_mask();
+        }
+    }
+
+    void _allocate(size_type capacity) {
+        _capacity = capacity;
+        _size = 0;
+        if(capacity == 0) {
+            _ctrl = nullptr;
+            _slots = nullptr;
+            _growth_left = 0;
+            return;
+        }
+        _ctrl = new ctrl_t[capacity];
+        std::memset(_ctrl, EMPTY, capacity);
+        _slots = _alloc.allocate(capacity);
+        _growth_left = _max_size_for(capacity);
+    }
+
+    void _deallocate() {
+        if(_capacity == 0) {
+            return;
+        }
+        delete[] _ctrl;
+        _alloc.deallocate(_slots, _capacity);
+    }
+
+    void _destroy_all() {
+        for(size_type i = 0; i < _capacity; i++) {
+            if(_is_full(_ctrl[i])) {
+                _slots[i].~slot_type();
+            }
+        }
+    }
+
+    // moves every element into a fresh table of new_capacity slots, dropping tombstones
+    void _resize(size_type new_capacity) {
+        ctrl_t * old_ctrl = _ctrl;
+        slot_type * old_slots = _slots;
+        size_type old_capacity = _capacity;
+        size_type size = _size;
+
+        _allocate(new_capacity);
+        for(size_type i = 0; i < old_capacity; i++) {
+            if(_is_full(old_ctrl[i])) {
+                size_type hash = _mixed_hash(old_slots[i].first);
+                size_type index = _find_free(hash);
+                new (_slots + index) slot_type(std::move(old_slots[i]));
+                _ctrl[index] = _h2(hash);
+                old_slots[i].~slot_type();
+            }
+        }
+        _size = size;
+        _growth_left -= size;
+
+        if(old_capacity) {
+            delete[] old_ctrl;
+            _alloc.deallocate(old_slots, old_capacity);
+        }
+    }
+
+    // smallest valid capacity holding n elements
+    static size_type _capacity_for(size_type n) {
+        if(n == 0) {
+            return 0;
+        }
+        size_type capacity = GROUP_WIDTH;
+        while(_max_size_for(capacity) < n) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    // makes room for one more element in an EMPTY slot
+    void _grow_for_insert() {
+        if(_capacity && _size <= _max_size_for(_capacity) / 2) {
+            // mostly tombstones: rebuild at the same size to reclaim them
+            _resize(_capacity);
+        } else {
+            _resize(_capacity ? 2 * _capacity : GROUP_WIDTH);
+        }
+    }
+
+    // the insert path shared by insert and operator[]: finds key or makes a slot built by make()
+    template <typename Make>
+    std::pair<size_type, bool> _find_or_insert(const Key & key, Make make) {
+        size_type hash = _mixed_hash(key);
+        size_type index = _find_index(key, hash);
+        if(index != _capacity) {
+            return { index, false };
+        }
+        if(_capacity == 0) {
+            _grow_for_insert();
+        }
+        index = _find_free(hash);
+        if(_growth_left == 0 && _ctrl[index] == EMPTY) {
+            _grow_for_insert();
+            index = _find_free(hash);
+        }
+        make(_slots + index);
+        if(_ctrl[index] == EMPTY) {
+            _growth_left--;
+        }
+        _ctrl[index] = _h2(hash);
+        _size++;
+        return { index, true };
+    }
+
+    void _erase_index(size_type index) {
+        _slots[index].~slot_type();
+        _size--;
+        size_type group_start = index & ~(GROUP_WIDTH - 1);
+        if(Group(_ctrl + group_start).match_empty()) {
+            _ctrl[index] = EMPTY;
+            _growth_left++;
+        } else {
+            _ctrl[index] = DELETED;
+        }
+    }
+
+    // copies other's control bytes and elements slot for slot
+    void _copy_from(const FlatUnorderedMap & other) {
+        _allocate(other._capacity);
+        if(_capacity == 0) {
+            return;
+        }
+        std::memcpy(_ctrl, other._ctrl, _capacity);
+        for(size_type i = 0; i < _capacity; i++) {
+            if(_is_full(_ctrl[i])) {
+                new (_slots + i) slot_type(other._slots[i]);
+            }
+        }
+        _size = other._size;
+        _growth_left = other._growth_left;
+    }
+
+    void _steal(FlatUnorderedMap & other) noexcept {
+        _ctrl = other._ctrl;
+        _slots = other._slots;
+        _capacity = other._capacity;
+        _size = other._size;
+        _growth_left = other._growth_left;
+        other._ctrl = nullptr;
+        other._slots = nullptr;
+        other._capacity = 0;
+        other._size = 0;
+        other._growth_left = 0;
+    }
+
+    public:
+
+    template <typename pointer_type, typename reference_type, typename _value_type>
+    class basic_iterator {
+        public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = _value_type;
+        using difference_type = ptrdiff_t;
+        using pointer = value_type *;
+        using reference = value_type &;
+
+        private:
+        friend class FlatUnorderedMap;
+
+        const ctrl_t * _ctrl;
+        const ctrl_t * _end;
+        value_type * _slot;
+
+        basic_iterator(const ctrl_t * ctrl, const ctrl_t * end, value_type * slot) noexcept
+            : _ctrl(ctrl), _end(end), _slot(slot) { }
+
+        // moves forward to the next full slot, or to the end
+        void _skip_free() {
+            while(_ctrl != _end && !_is_full(*_ctrl)) {
+                _ctrl++;
+                _slot++;
+            }
+        }
+
+        public:
+        basic_iterator() : _ctrl(nullptr), _end(nullptr), _slot(nullptr) { }
+
+        // iterator converts to const_iterator
+        operator basic_iterator<const_pointer, const_reference, const typename FlatUnorderedMap::value_type>() const {
+            return { _ctrl, _end, _slot };
+        }
+
+        reference operator*() const { return *_slot; }
+        pointer operator->() const { return _slot; }
+
+        basic_iterator & operator++() {
+            _ctrl++;
+            _slot++;
+            _skip_free();
+            return *this;
+        }
+        basic_iterator operator++(int) {
+            basic_iterator copy = *this;
+            ++(*this);
+            return copy;
+        }
+
+        bool operator==(const basic_iterator & other) const noexcept { return _ctrl == other._ctrl; }
+        bool operator!=(const basic_iterator & other) const noexcept { return _ctrl != other._ctrl; }
+    };
+
+    using iterator = basic_iterator<pointer, reference, value_type>;
+    using const_iterator = basic_iterator<const_pointer, const_reference, const value_type>;
+
+    private:
+
+    iterator _iterator_at(size_type index) const { return iterator(_ctrl + index, _ctrl + _capacity, _value(index)); }
+
+    public:
+
+    // room for bucket_count elements without growing
+    explicit FlatUnorderedMap(size_type bucket_count = 0, const Hash & hash = Hash { },
+                const key_equal & equal = key_equal { })
+        : _hash(hash), _equal(equal)
+    {
+        _allocate(_capacity_for(bucket_count));
+    }
+
+    FlatUnorderedMap(const FlatUnorderedMap & other) : _hash(other._hash), _equal(other._equal) { _copy_from(other); }
+
+    FlatUnorderedMap(FlatUnorderedMap && other) noexcept : _hash(other._hash), _equal(other._equal) { _steal(other); }
+
+    ~FlatUnorderedMap() {
+        _destroy_all();
+        _deallocate();
+    }
+
+    FlatUnorderedMap & operator=(const FlatUnorderedMap & other) {
+        if(this != &other) {
+            _destroy_all();
+            _deallocate();
+            _hash = other._hash;
+            _equal = other._equal;
+            _copy_from(other);
+        }
+        return *this;
+    }
+
+    FlatUnorderedMap & operator=(FlatUnorderedMap && other) noexcept {
+        if(this != &other) {
+            _destroy_all();
+            _deallocate();
+            _hash = std::move(other._hash);
+            _equal = std::move(other._equal);
+            _steal(other);
+        }
+        return *this;
+    }
+
+    // destroys every element but keeps the slots
+    void clear() noexcept {
+        _destroy_all();
+        if(_capacity) {
+            std::memset(_ctrl, EMPTY, _capacity);
+        }
+        _size = 0;
+        _growth_left = _max_size_for(_capacity);
+    }
+
+    size_type size() const noexcept { return _size; }
+    bool empty() const noexcept { return _size == 0; }
+
+    // every slot is a "bucket" holding at most one element
+    size_type bucket_count() const noexcept { return _capacity; }
+    float load_factor() const { return _capacity ? static_cast<float>(_size) / _capacity : 0.0f; }
+    float max_load_factor() const { return 7.0f / 8.0f; }
+
+    // makes room for count elements without growing
+    void reserve(size_type count) {
+        if(count > _max_size_for(_capacity)) {
+            _resize(_capacity_for(count));
+        }
+    }
+
+    iterator begin() {
+        iterator it = _iterator_at(0);
+        it._skip_free();
+        return it;
+    }
+    iterator end() { return _iterator_at(_capacity); }
+    const_iterator begin() const { return const_cast<FlatUnorderedMap *>(this)->begin(); }
+    const_iterator end() const { return const_cast<FlatUnorderedMap *>(this)->end(); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    iterator find(const Key & key) { return _iterator_at(_find_index(key, _mixed_hash(key))); }
+    const_iterator find(const Key & key) const { return const_cast<FlatUnorderedMap *>(this)->find(key); }
+
+    bool contains(const Key & key) const { return _find_index(key, _mixed_hash(key)) != _capacity; }
+
+    /*
+    Inserts value unless its key is present. Returns an iterator to the element
+    with that key and whether the insertion took place.
+    */
+    std::pair<iterator, bool> insert(const value_type & value) {
+        auto [index, inserted] = _find_or_insert(value.first, [&](slot_type * slot) { new (slot) slot_type(value); });
+        return { _iterator_at(index), inserted };
+    }
+    std::pair<iterator, bool> insert(value_type && value) {
+        auto [index, inserted] = _find_or_insert(value.first, [&](slot_type * slot) { new (slot) slot_type(std::move(value)); });
+        return { _iterator_at(index), inserted };
+    }
+
+    T & operator[](const Key & key) {
+        auto result = _find_or_insert(key, [&](slot_type * slot) { new (slot) slot_type(key, T()); });
+        return _slots[result.first].second;
+    }
+
+    // removes the element at pos and returns an iterator to the next one
+    iterator erase(iterator pos) {
+        _erase_index(static_cast<size_type>(pos._ctrl - _ctrl));
+        ++pos;
+        return pos;
+    }
+
+    size_type erase(const Key & key) {
+        size_type index = _find_index(key, _mixed_hash(key));
+        if(index == _capacity) {
+            return 0;
+        }
+        _erase_index(index);
+        return 1;
+    }
+};
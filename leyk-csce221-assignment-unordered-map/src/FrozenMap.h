@@ -0,0 +1,427 @@
+#pragma once
+
+#include <cstddef>     // size_t
+#include <cstdint>     // uint32_t, uint64_t
+#include <cstring>     // std::memcpy, std::memcmp
+#include <fstream>     // std::ifstream, std::ofstream
+#include <functional>  // std::hash, std::equal_to
+#include <limits>      // std::numeric_limits
+#include <memory>      // std::unique_ptr
+#include <optional>    // std::optional
+#include <ostream>     // std::ostream
+#include <string>      // std::string
+#include <string_view> // std::string_view
+#include <type_traits> // std::enable_if_t, std::is_trivially_copyable, std::has_unique_object_representations_v
+#include <utility>     // std::exchange, std::move
+#include <vector>      // std::vector
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>    // open
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // close
+#define FROZEN_MAP_MMAP 1
+#endif
+
+#include "UnorderedMap.h"
+#include "hash_functions.h"
+
+/*
+    How keys and values are laid out in a frozen map file, and read back.
+    Trivially copyable types are stored as their bytes and read back as
+    copies. Strings are stored as their characters and read back as views
+    into the file.
+
+    Keys are bytewise when their bytes are the whole value: equal keys have
+    equal bytes, so the codec's hash of the bytes and memcmp stand in for
+    the map's Hash and Pred, and the file does not depend on either.
+    Strings are, and so are trivially copyable types with unique object
+    representations. Others, such as floating point numbers or structs
+    with padding, are hashed with Hash and compared with Pred; see
+    frozen_code.
+*/
+template <typename T, typename = void>
+struct frozen_codec;
+
+template <typename T>
+struct frozen_codec<T, std::enable_if_t<std::is_trivially_copyable<T>::value>> {
+    using view_type = T;
+
+    static constexpr bool bytewise = std::has_unique_object_representations_v<T>;
+
+    static const char * data(const T & value) { return reinterpret_cast<const char *>(&value); }
+    static size_t size(const T &) { return sizeof(T); }
+    static bool valid_size(size_t size) { return size == sizeof(T); }
+
+    static view_type read(const char * bytes, size_t) {
+        T value;
+        std::memcpy(&value, bytes, sizeof(T));
+        return value;
+    }
+
+    // the FNV-1a of fnv1a_hash, over the value's bytes
+    static size_t hash(const T & value) {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for(size_t i = 0; i < sizeof(T); i++) {
+            hash ^= static_cast<unsigned char>(data(value)[i]);
+            hash *= 0x00000100000001B3ull;
+        }
+        return static_cast<size_t>(hash);
+    }
+};
+
+template <>
+struct frozen_codec<std::string> {
+    using view_type = std::string_view;
+
+    static constexpr bool bytewise = true;
+
+    static const char * data(const std::string & value) { return value.data(); }
+    static size_t size(const std::string & value) { return value.size(); }
+    static bool valid_size(size_t) { return true; }
+
+    static view_type read(const char * bytes, size_t size) { return view_type(bytes, size); }
+
+    static size_t hash(const std::string & value) { return fnv1a_hash {}(value); }
+};
+
+// the code stored for key: its codec hash when it is bytewise, hash's otherwise
+template <typename Key, typename Hash>
+uint64_t frozen_code(const Key & key, const Hash & hash) {
+    if constexpr (frozen_codec<Key>::bytewise) {
+        return frozen_codec<Key>::hash(key);
+    } else {
+        return hash(key);
+    }
+}
+
+/*
+    The frozen map file format. Every position in it is an offset from the
+    start of the file, so it can be mapped at any address, and numbers are
+    in the byte order of the machine that wrote it.
+
+        header    FrozenHeader
+        buckets   bucket_count + 1 uint64_t: bucket b holds entries
+                  [buckets[b], buckets[b + 1])
+        entries   size FrozenEntry, grouped by bucket
+        arena     each entry's key bytes followed by its value bytes,
+                  in entry order
+
+    bucket_count is a power of two at least size, and a key's bucket comes
+    from its frozen_code through power_of_two_buckets.
+*/
+struct FrozenHeader {
+    char magic[8];
+    uint64_t size;
+    uint64_t bucket_count;
+    uint64_t buckets_offset;
+    uint64_t entries_offset;
+    uint64_t arena_offset;
+    uint64_t file_size;
+    uint64_t reserved;
+
+    static constexpr char MAGIC[8] = { 'F', 'R', 'O', 'Z', 'E', 'N', 'M', '1' };
+};
+
+struct FrozenEntry {
+    uint64_t code;
+    uint64_t offset; // of the key, the value follows it
+    uint32_t key_size;
+    uint32_t value_size;
+};
+
+static_assert(sizeof(FrozenHeader) == 64, "frozen map headers are 64 bytes");
+static_assert(sizeof(FrozenEntry) == 24, "frozen map entries are 24 bytes");
+
+/*
+    Writes map to out in the frozen map format. Returns false if a key or
+    value is too large for the format or writing fails.
+*/
+template <typename Key, typename T, typename Hash, typename Pred, typename Allocator, typename BucketPolicy, typename Stats>
+bool freeze(const UnorderedMap<Key, T, Hash, Pred, Allocator, BucketPolicy, Stats> & map, std::ostream & out) {
+    using key_codec = frozen_codec<Key>;
+    using value_codec = frozen_codec<T>;
+
+    power_of_two_buckets range_hash(map.size());
+    size_t bucket_count = range_hash.bucket_count();
+
+    // counting sort of the elements by bucket
+    std::vector<uint64_t> codes;
+    std::vector<uint64_t> buckets(bucket_count + 1, 0);
+    codes.reserve(map.size());
+    for(auto it = map.cbegin(); it != map.cend(); ++it) {
+        if(key_codec::size(it->first) > std::numeric_limits<uint32_t>::max()
+            || value_codec::size(it->second) > std::numeric_limits<uint32_t>::max()) {
+            return false;
+        }
+        codes.push_back(frozen_code(it->first, map.hash_function()));
+        buckets[range_hash(codes.back()) + 1]++;
+    }
+    for(size_t b = 0; b < bucket_count; b++) {
+        buckets[b + 1] += buckets[b];
+    }
+    std::vector<const typename UnorderedMap<Key, T, Hash, Pred, Allocator, BucketPolicy, Stats>::value_type *> order(map.size());
+    std::vector<uint64_t> order_codes(map.size());
+    std::vector<uint64_t> next(buckets.begin(), buckets.end() - 1);
+    size_t i = 0;
+    for(auto it = map.cbegin(); it != map.cend(); ++it, i++) {
+        uint64_t slot = next[range_hash(codes[i])]++;
+        order[slot] = &*it;
+        order_codes[slot] = codes[i];
+    }
+
+    FrozenHeader header = { };
+    std::memcpy(header.magic, FrozenHeader::MAGIC, sizeof(header.magic));
+    header.size = map.size();
+    header.bucket_count = bucket_count;
+    header.buckets_offset = sizeof(FrozenHeader);
+    header.entries_offset = header.buckets_offset + buckets.size() * sizeof(uint64_t);
+    header.arena_offset = header.entries_offset + order.size() * sizeof(FrozenEntry);
+
+    std::vector<FrozenEntry> entries(order.size());
+    uint64_t offset = header.arena_offset;
+    for(size_t e = 0; e < order.size(); e++) {
+        entries[e].code = order_codes[e];
+        entries[e].offset = offset;
+        entries[e].key_size = static_cast<uint32_t>(key_codec::size(order[e]->first));
+        entries[e].value_size = static_cast<uint32_t>(value_codec::size(order[e]->second));
+        offset += uint64_t(entries[e].key_size) + entries[e].value_size;
+    }
+    header.file_size = offset;
+
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(buckets.data()), buckets.size() * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(FrozenEntry));
+    for(size_t e = 0; e < order.size(); e++) {
+        out.write(key_codec::data(order[e]->first), entries[e].key_size);
+        out.write(value_codec::data(order[e]->second), entries[e].value_size);
+    }
+    return out.good();
+}
+
+template <typename Key, typename T, typename Hash, typename Pred, typename Allocator, typename BucketPolicy, typename Stats>
+bool freeze(const UnorderedMap<Key, T, Hash, Pred, Allocator, BucketPolicy, Stats> & map, const std::string & path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    return out && freeze(map, out) && out.flush();
+}
+
+/*
+    Read-only map over a file written by freeze. Opening a file maps it
+    into memory and checks its header; nothing is parsed or copied, so
+    opening takes the same time for any size, pages are only read once a
+    lookup touches them, and processes mapping the same file share them.
+
+    Lookups hash the key with frozen_code, scan the entries of one bucket,
+    comparing stored codes first, and return the value as its codec reads
+    it: a copy for trivially copyable types, a std::string_view into the
+    file for strings, valid for as long as the FrozenMap is. Keys that are
+    not bytewise need the Hash and Pred the frozen map had.
+
+    A FrozenMap that failed to open is empty; is_open tells the two apart.
+*/
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename Pred = std::equal_to<Key>>
+class FrozenMap {
+    public:
+
+    using key_type = Key;
+    using mapped_type = T;
+    using size_type = size_t;
+    using key_view = typename frozen_codec<Key>::view_type;
+    using mapped_view = typename frozen_codec<T>::view_type;
+
+    private:
+
+    using key_codec = frozen_codec<Key>;
+    using value_codec = frozen_codec<T>;
+
+    const char * _data = nullptr;
+    size_type _length = 0;
+    // set when this map owns a mapping of _length bytes at _data
+    bool _mapped = false;
+    // holds the file when it could not be mapped
+    std::unique_ptr<char[]> _buffer;
+
+    FrozenHeader _header = { };
+    power_of_two_buckets _range_hash { 1 };
+
+    Hash _hash;
+    Pred _equal;
+
+    template <typename U>
+    U _load(uint64_t offset) const {
+        U value;
+        std::memcpy(&value, _data + offset, sizeof(U));
+        return value;
+    }
+
+    // checks the header against the file length and adopts the file, or leaves the map closed
+    bool _adopt(const char * data, size_type length) {
+        if(length < sizeof(FrozenHeader)) {
+            return false;
+        }
+        FrozenHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        bool valid = std::memcmp(header.magic, FrozenHeader::MAGIC, sizeof(header.magic)) == 0
+            && header.file_size == length
+            // bounds both counts before they are multiplied out below
+            && header.size <= length / sizeof(FrozenEntry) && header.bucket_count <= length / sizeof(uint64_t)
+            && header.bucket_count != 0 && (header.bucket_count & (header.bucket_count - 1)) == 0
+            && header.buckets_offset == sizeof(FrozenHeader)
+            && header.entries_offset == header.buckets_offset + (header.bucket_count + 1) * sizeof(uint64_t)
+            && header.arena_offset == header.entries_offset + header.size * sizeof(FrozenEntry)
+            && header.arena_offset <= length;
+        if(!valid) {
+            return false;
+        }
+        _data = data;
+        _length = length;
+        _header = header;
+        _range_hash = power_of_two_buckets(header.bucket_count);
+        return true;
+    }
+
+    // whether entry's bytes lie inside the file and fit the codecs
+    bool _in_bounds(const FrozenEntry & entry) const {
+        return entry.offset >= _header.arena_offset && entry.offset <= _length
+            && uint64_t(entry.key_size) + entry.value_size <= _length - entry.offset
+            && key_codec::valid_size(entry.key_size) && value_codec::valid_size(entry.value_size);
+    }
+
+    void _close() {
+#if defined(FROZEN_MAP_MMAP)
+        if(_mapped) {
+            munmap(const_cast<char *>(_data), _length);
+        }
+#endif
+        _buffer.reset();
+        _data = nullptr;
+        _length = 0;
+        _mapped = false;
+        _header = FrozenHeader { };
+    }
+
+    public:
+
+    FrozenMap() = default;
+
+    // maps the file at path, which freeze wrote
+    explicit FrozenMap(const std::string & path, const Hash & hash = Hash { }, const Pred & equal = Pred { })
+        : _hash(hash), _equal(equal) {
+#if defined(FROZEN_MAP_MMAP)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            return;
+        }
+        struct stat st;
+        void * data = MAP_FAILED;
+        if(fstat(fd, &st) == 0 && st.st_size > 0) {
+            data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        }
+        // the mapping stays valid once the descriptor is closed
+        ::close(fd);
+        if(data == MAP_FAILED) {
+            return;
+        }
+        if(_adopt(static_cast<const char *>(data), static_cast<size_type>(st.st_size))) {
+            _mapped = true;
+        } else {
+            munmap(data, static_cast<size_t>(st.st_size));
+        }
+#else
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if(!in) {
+            return;
+        }
+        size_type length = static_cast<size_type>(in.tellg());
+        _buffer.reset(new char[length]);
+        in.seekg(0);
+        if(!in.read(_buffer.get(), length) || !_adopt(_buffer.get(), length)) {
+            _buffer.reset();
+        }
+#endif
+    }
+
+    // reads a frozen map held in memory by the caller, which must outlive it
+    FrozenMap(const void * data, size_type length, const Hash & hash = Hash { }, const Pred & equal = Pred { })
+        : _hash(hash), _equal(equal) {
+        _adopt(static_cast<const char *>(data), length);
+    }
+
+    FrozenMap(const FrozenMap &) = delete;
+    FrozenMap & operator=(const FrozenMap &) = delete;
+
+    FrozenMap(FrozenMap && other) noexcept
+        : _data(std::exchange(other._data, nullptr)), _length(std::exchange(other._length, 0)),
+          _mapped(std::exchange(other._mapped, false)), _buffer(std::move(other._buffer)),
+          _header(std::exchange(other._header, FrozenHeader { })), _range_hash(other._range_hash),
+          _hash(std::move(other._hash)), _equal(std::move(other._equal)) { }
+
+    FrozenMap & operator=(FrozenMap && other) noexcept {
+        if(this != &other) {
+            _close();
+            _data = std::exchange(other._data, nullptr);
+            _length = std::exchange(other._length, 0);
+            _mapped = std::exchange(other._mapped, false);
+            _buffer = std::move(other._buffer);
+            _header = std::exchange(other._header, FrozenHeader { });
+            _range_hash = other._range_hash;
+            _hash = std::move(other._hash);
+            _equal = std::move(other._equal);
+        }
+        return *this;
+    }
+
+    ~FrozenMap() { _close(); }
+
+    bool is_open() const noexcept { return _data != nullptr; }
+
+    size_type size() const noexcept { return _header.size; }
+    bool empty() const noexcept { return _header.size == 0; }
+    size_type bucket_count() const noexcept { return _header.bucket_count; }
+
+    // the value mapped to key, or nothing if key is absent or its entry is damaged
+    std::optional<mapped_view> find(const Key & key) const {
+        if(!is_open()) {
+            return std::nullopt;
+        }
+        uint64_t code = frozen_code(key, _hash);
+        uint64_t bucket = _range_hash(code);
+        uint64_t first = _load<uint64_t>(_header.buckets_offset + bucket * sizeof(uint64_t));
+        uint64_t last = _load<uint64_t>(_header.buckets_offset + (bucket + 1) * sizeof(uint64_t));
+        if(first > last || last > _header.size) {
+            return std::nullopt;
+        }
+        const char * key_bytes = key_codec::data(key);
+        size_type key_size = key_codec::size(key);
+        for(uint64_t e = first; e < last; e++) {
+            FrozenEntry entry = _load<FrozenEntry>(_header.entries_offset + e * sizeof(FrozenEntry));
+            if(entry.code != code || entry.key_size != key_size || !_in_bounds(entry)) {
+                continue;
+            }
+            bool equal;
+            if constexpr (key_codec::bytewise) {
+                equal = std::memcmp(_data + entry.offset, key_bytes, key_size) == 0;
+            } else {
+                equal = _equal(key_codec::read(_data + entry.offset, entry.key_size), key);
+            }
+            if(equal) {
+                return value_codec::read(_data + entry.offset + entry.key_size, entry.value_size);
+            }
+        }
+        return std::nullopt;
+    }
+
+    bool contains(const Key & key) const { return find(key).has_value(); }
+
+    // calls f(key, value) with the codec views of every element, in file order
+    template <typename F>
+    void for_each(F && f) const {
+        for(uint64_t e = 0; e < size(); e++) {
+            FrozenEntry entry = _load<FrozenEntry>(_header.entries_offset + e * sizeof(FrozenEntry));
+            if(_in_bounds(entry)) {
+                f(key_codec::read(_data + entry.offset, entry.key_size),
+                  value_codec::read(_data + entry.offset + entry.key_size, entry.value_size));
+            }
+        }
+    }
+};
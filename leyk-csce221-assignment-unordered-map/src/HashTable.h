@@ -0,0 +1,1761 @@
+#pragma once
+
+#include <algorithm>  // std::max
+#include <cmath>      // std::ceil
+#include <cstddef>    // size_t
+#include <functional> // std::hash
+#include <ios>
+#include <limits>     // std::numeric_limits
+#include <memory>     // std::allocator, std::allocator_traits
+#include <optional>   // std::optional
+#include <thread>     // std::thread
+#include <tuple>      // std::forward_as_tuple
+#include <type_traits> // std::is_empty
+#include <utility>    // std::pair, std::piecewise_construct, std::in_place
+#include <vector>     // std::vector
+#include <iostream>
+
+#include "hash_traits.h"
+#include "map_stats.h"
+#include "primes.h"
+
+
+
+// picks the key out of a map's pairs
+struct select_first {
+    template <typename Pair>
+    const typename Pair::first_type & operator()(const Pair & pair) const noexcept { return pair.first; }
+};
+
+// a set's elements are their own keys
+struct identity_key {
+    template <typename T>
+    const T & operator()(const T & value) const noexcept { return value; }
+};
+
+/*
+    The chained hash table behind UnorderedMap, UnorderedSet and
+    UnorderedMultiMap. It stores Values, whose keys KeyOfValue picks out:
+    the first of a pair for the maps, the value itself for the set. With
+    UniqueKeys a key is stored at most once, and inserting a present key
+    fails; without, equal keys are kept next to each other in their bucket,
+    so equal_range walks them as one run of the chain.
+
+    Allocator provides the nodes and the bucket arrays, rebound to each; the
+    default makes one operator new call per node. BucketPolicy picks the
+    bucket counts and maps hash codes to buckets; see hash_traits.h. The
+    default keeps prime bucket counts. Stats decides what stats counts, if
+    anything; see map_stats.h.
+*/
+template <typename Key, typename Value, typename KeyOfValue, bool UniqueKeys, typename Hash, typename Pred,
+          typename Allocator, typename BucketPolicy, typename Stats>
+class HashTable {
+    public:
+
+    using key_type = Key;
+    using hasher = Hash;
+    using key_equal = Pred;
+    using allocator_type = Allocator;
+    using bucket_policy = BucketPolicy;
+    using stats_policy = Stats;
+    using value_type = Value;
+    using reference = value_type &;
+    using const_reference = const value_type &;
+    using pointer = value_type *;
+    using const_pointer = const value_type *;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    // old buckets holding nodes that each insert moves during an incremental rehash
+    static constexpr size_type INCREMENTAL_REHASH_STEP = 4;
+    // keys find_batch has in flight at once
+    static constexpr size_type FIND_BATCH_GROUP = 16;
+    // size of the shared empty table moved-from maps are left with, see _leave_empty
+    static constexpr size_type SHARED_EMPTY_BUCKETS = 8;
+    // bucket ranges build_parallel splits the table into per thread, so uneven ranges even out
+    static constexpr size_type BUILD_RANGES_PER_THREAD = 4;
+
+    // which of several pairs with equal keys build_parallel keeps
+    enum class duplicate_policy { keep_first, keep_last };
+
+    protected:
+
+    // a set's elements are its keys, which may not change in place
+    static constexpr bool _is_set = std::is_same<Key, Value>::value;
+
+    static const Key & _key(const Value & value) noexcept { return KeyOfValue { }(value); }
+
+    // the link every node has; _before_begin is one without a value
+    struct HashNodeBase {
+        HashNodeBase *next;
+
+        HashNodeBase(HashNodeBase *next = nullptr) : next{next} {}
+    };
+
+    // whether nodes keep their key's hash code, see hash_traits.h
+    static constexpr bool _cache_codes = cache_hash_code<Hash>::value;
+
+    // the stored hash code, or nothing (and no space, as an empty base) when not cached
+    template <bool Cached, typename = void>
+    struct HashCode {
+        size_type code;
+    };
+    template <typename Dummy>
+    struct HashCode<false, Dummy> { };
+
+    struct HashNode : HashNodeBase, HashCode<_cache_codes> {
+        value_type val;
+
+        // val is built in place from args
+        template <typename... Args>
+        explicit HashNode(std::in_place_t, Args &&... args) : HashNodeBase { nullptr }, val(std::forward<Args>(args)...) { }
+
+        HashNode * next_node() const { return static_cast<HashNode *>(this->next); }
+    };
+
+    using _alloc_traits = std::allocator_traits<Allocator>;
+    using _node_allocator = typename _alloc_traits::template rebind_alloc<HashNode>;
+    using _node_traits = typename _alloc_traits::template rebind_traits<HashNode>;
+    using _bucket_allocator = typename _alloc_traits::template rebind_alloc<HashNodeBase *>;
+    using _bucket_traits = typename _alloc_traits::template rebind_traits<HashNodeBase *>;
+
+    /*
+    All nodes form one singly linked list that starts after _before_begin, with
+    the nodes of each bucket next to each other. _buckets[b] points at the node
+    *before* the first node of bucket b (possibly _before_begin), or is nullptr
+    when b is empty, so a bucket's first node can be unlinked in O(1). A bucket
+    ends where the next node hashes elsewhere.
+
+    During an incremental rehash the previous bucket array is kept as
+    _old_buckets, whose buckets are moved to _buckets in index order. Old
+    buckets below _rehash_cursor have been moved, so a hash code belongs to
+    the old table exactly when its old bucket is at or past the cursor. The
+    chain then holds the buckets of both tables, told apart as slots: slot s
+    is _buckets[s] below _bucket_count, and old bucket s - _bucket_count
+    from there on. Outside a rehash slots and buckets are the same.
+    */
+    size_type _bucket_count;
+    HashNodeBase **_buckets;
+
+    HashNodeBase **_old_buckets = nullptr;
+    size_type _old_bucket_count = 0;
+    size_type _rehash_cursor = 0;
+
+    HashNodeBase _before_begin;
+    size_type _size;
+
+    Hash _hash;
+    key_equal _equal;
+
+    // inserts grow the table past this; unbounded unless the user opts in
+    float _max_load_factor;
+
+    // maps hash codes to buckets for the current bucket count
+    BucketPolicy _range_hash;
+    // and for _old_buckets, while a rehash is in progress
+    BucketPolicy _old_range_hash;
+
+    // whether growing moves the buckets over later inserts rather than at once
+    bool _incremental_rehash = false;
+
+    // what the map has done since it was built or its stats were reset; lookups count from const members too
+    mutable Stats _stats;
+
+    // allocates the nodes; bucket arrays come from a rebound copy
+    _node_allocator _node_alloc;
+
+    // the buckets of every moved-from map, never written to; an insert first gives the map its own
+    inline static HashNodeBase * _shared_empty_buckets[SHARED_EMPTY_BUCKETS] = { };
+
+    /*
+    The shared empty table, as large as BucketPolicy's smallest. That is
+    _shared_empty_buckets unless the policy's smallest table is larger, in
+    which case one is allocated on the first call and kept for good. The
+    constructor calls this first, so by the time any map is moved from,
+    the table exists and _leave_empty cannot throw.
+    */
+    static HashNodeBase ** _shared_empty() {
+        static HashNodeBase ** const buckets = BucketPolicy(0).bucket_count() <= SHARED_EMPTY_BUCKETS
+                                               ? _shared_empty_buckets
+                                               : new HashNodeBase * [BucketPolicy(0).bucket_count()]();
+        return buckets;
+    }
+
+    public:
+
+    template <typename pointer_type, typename reference_type, typename _value_type>
+    class basic_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = _value_type;
+        using difference_type = ptrdiff_t;
+        using pointer = value_type *;
+        using reference = value_type &;
+
+    private:
+        friend class HashTable;
+        using HashNode = typename HashTable::HashNode;
+
+        HashNode * _ptr;
+
+        explicit basic_iterator(HashNode *ptr) noexcept { 
+            // Creates an iterator to the key-value pair belonging to the HashNode pointed to by ptr.
+            _ptr = ptr;
+         }
+
+    public:
+        basic_iterator() { 
+            _ptr = nullptr;
+        };
+
+        basic_iterator(const basic_iterator &) = default;
+        basic_iterator(basic_iterator &&) = default;
+        ~basic_iterator() = default;
+        basic_iterator &operator=(const basic_iterator &) = default;
+        basic_iterator &operator=(basic_iterator &&) = default;
+        reference operator*() const { 
+            // return a reference to the key-value pair belonging to the _ptr owned by this iterator.
+            return _ptr->val;
+         }
+        pointer operator->() const { return &(_ptr->val); }
+        
+        basic_iterator &operator++() { 
+            // prefix increment
+            /*
+            Change the _ptr to be the next _ptr in the UnorderedMap, 
+            even if that node is in a different bucket.
+            Return a reference to the iterator after the change.
+            */
+            if(_ptr == nullptr) {
+                return *this;
+            }
+            // every node is on the one chain, so the next element is just the next node
+            _ptr = _ptr->next_node();
+            return *this;
+         }
+        // call prefix increment
+        basic_iterator operator++(int) { 
+            // postfix increment
+            // dont increment if next node is nullptr
+            if(_ptr == nullptr ) {
+                return *this;
+            }
+            basic_iterator copy = *this;
+            ++(*this);
+            return copy;
+        }
+        bool operator==(const basic_iterator &other) const noexcept { return _ptr == other._ptr; }
+        bool operator!=(const basic_iterator &other) const noexcept { return _ptr != other._ptr; }
+    };
+
+    using const_iterator = basic_iterator<const_pointer, const_reference, const value_type>;
+    using iterator = std::conditional_t<_is_set, const_iterator, basic_iterator<pointer, reference, value_type>>;
+
+    class local_iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::conditional_t<_is_set, const Value, Value>;
+            using difference_type = ptrdiff_t;
+            using pointer = value_type *;
+            using reference = value_type &;
+
+        private:
+            friend class HashTable;
+            using HashNode = typename HashTable::HashNode;
+
+            const HashTable * _map;
+            HashNode * _node;
+            size_type _bucket;
+
+            /*
+            Creates a local_iterator to the key-value pair belonging to the HashNode 
+            pointed to by ptr limited to the bucket bucket within map.
+            */
+            explicit local_iterator( const HashTable * map, HashNode * node, size_type bucket ) noexcept { 
+                _map = map;
+                _node = node;
+                _bucket = bucket;
+             }
+
+            // steps along the chain, becoming end() once the next node belongs to another bucket
+            void _advance() {
+                _node = _node->next_node();
+                if(_node && _map->_node_bucket(_node) != _bucket) {
+                    _node = nullptr;
+                }
+            }
+
+        public:
+            // basically like linked list iterator
+            // Creates a local_iterator by default, pointer belonging to the local iterator = nullptr.
+
+            local_iterator() { 
+                _map = nullptr;
+                _node = nullptr;
+                _bucket = 0;
+             }
+
+            local_iterator(const local_iterator &) = default;
+            local_iterator(local_iterator &&) = default;
+            ~local_iterator() = default;
+            local_iterator &operator=(const local_iterator &) = default;
+            local_iterator &operator=(local_iterator &&) = default;
+            // Return a reference to the key-value pair belonging to the _node owned by this iterator.
+            reference operator*() const { return _node->val; }
+            pointer operator->() const { return &(_node->val); }
+            local_iterator & operator++() {  // prefix increment
+                // dont increment if next node is nullptr
+                if(_node == nullptr ) {
+                    return *this;
+                }
+                _advance();
+                return *this;
+             }
+            local_iterator operator++(int) { // postfix increment
+                // dont increment if next node is nullptr
+                if(_node == nullptr ) {
+                    return *this;
+                }
+                local_iterator copy = *this;
+                _advance();
+                return copy;
+             }
+
+            bool operator==(const local_iterator &other) const noexcept { return _node == other._node; }
+            bool operator!=(const local_iterator &other) const noexcept { return _node != other._node; }
+    };
+
+    /*
+    Owns a node taken out of a map by extract, together with a copy of the
+    allocator that made it, until insert links it into a map again or the
+    handle goes out of scope and frees it. Move-only; an empty handle owns
+    nothing.
+    */
+    class node_type {
+        public:
+            node_type() = default;
+            node_type(node_type && other) noexcept : _node(other._node), _alloc(std::move(other._alloc)) {
+                other._node = nullptr;
+                other._alloc.reset();
+            }
+            node_type & operator=(node_type && other) noexcept {
+                if(this != &other) {
+                    _reset();
+                    _node = other._node;
+                    _alloc = std::move(other._alloc);
+                    other._node = nullptr;
+                    other._alloc.reset();
+                }
+                return *this;
+            }
+            ~node_type() { _reset(); }
+
+            bool empty() const noexcept { return _node == nullptr; }
+            explicit operator bool() const noexcept { return _node != nullptr; }
+
+            // the element; only for a handle that is not empty
+            const key_type & key() const { return _key(_node->val); }
+            const value_type & value() const { return _node->val; }
+            // a map's mapped value
+            template <typename V = Value, typename = std::enable_if_t<!std::is_same<V, Key>::value>>
+            typename V::second_type & mapped() const { return _node->val.second; }
+
+            allocator_type get_allocator() const { return allocator_type(*_alloc); }
+
+        private:
+            friend class HashTable;
+
+            HashNode * _node = nullptr;
+            // allocators need not be default constructible, so an empty handle has none
+            std::optional<_node_allocator> _alloc;
+
+            node_type(HashNode * node, const _node_allocator & alloc) : _node(node), _alloc(alloc) { }
+
+            // gives up the node without freeing it
+            HashNode * _release() noexcept {
+                HashNode * node = _node;
+                _node = nullptr;
+                _alloc.reset();
+                return node;
+            }
+
+            void _reset() noexcept {
+                if(_node) {
+                    _node_traits::destroy(*_alloc, _node);
+                    _node_traits::deallocate(*_alloc, _node, 1);
+                    _node = nullptr;
+                }
+                _alloc.reset();
+            }
+    };
+
+    // what inserting a node handle into a table of unique keys did; node keeps the handle when the key was already present
+    struct insert_return_type {
+        iterator position;
+        bool inserted;
+        node_type node;
+    };
+
+    // what inserting returns: where the element is and whether it went in, or, with equal keys allowed, where it went
+    using insert_result = std::conditional_t<UniqueKeys, std::pair<iterator, bool>, iterator>;
+    using node_insert_result = std::conditional_t<UniqueKeys, insert_return_type, iterator>;
+
+protected:
+    
+    // returns the bucket index for the given hash code
+    // (named apart from _bucket so keys of type size_t don't make the overloads ambiguous)
+    size_type _bucket_index(size_t code) const { return _range_hash(code); }
+
+    // the slot holding hash code code, which is its bucket unless a rehash has yet to move it
+    size_type _slot(size_t code) const {
+        if(_old_buckets) {
+            size_type old = _old_range_hash(code);
+            if(old >= _rehash_cursor) {
+                return _bucket_count + old;
+            }
+        }
+        return _range_hash(code);
+    }
+
+    // the pointer to the node before slot's first node
+    HashNodeBase * _head(size_type slot) const {
+        return slot < _bucket_count ? _buckets[slot] : _old_buckets[slot - _bucket_count];
+    }
+    HashNodeBase *& _head(size_type slot) {
+        return slot < _bucket_count ? _buckets[slot] : _old_buckets[slot - _bucket_count];
+    }
+    // returns the bucket index for the given key: hash the key and then find the bucket index
+    size_type _bucket(const Key & key) const { return _bucket_index(_hash(key)); }
+
+    // the hash code of node's key, read from the node when codes are cached
+    size_type _code(const HashNode * node) const {
+        if constexpr (_cache_codes) {
+            return node->code;
+        } else {
+            return _hash(_key(node->val));
+        }
+    }
+    // the slot node belongs to
+    size_type _node_bucket(const HashNode * node) const { return _slot(_code(node)); }
+
+    // whether node holds key; with cached codes, differing codes rule it out without calling _equal
+    template <typename K>
+    bool _matches(const HashNode * node, size_type code, const K & key) const {
+        if constexpr (_cache_codes) {
+            if(node->code != code) {
+                return false;
+            }
+        }
+        return _equal(_key(node->val), key);
+    }
+
+    /*Starts with the nodes in bucket bucket and iterates forward until the key matches key, 
+    returning the node *before* the one where the keys match, so the caller can unlink it. 
+    If no such match occurs, returns nullptr.*/
+    template <typename K>
+    HashNodeBase * _find_before(size_type code, size_type bucket, const K & key) const { 
+        _stats.lookup();
+        HashNodeBase * prev = _head(bucket);
+        if(prev == nullptr) {
+            return nullptr;
+        }
+        for(HashNode * node = static_cast<HashNode *>(prev->next); ; prev = node, node = node->next_node()) {
+            _stats.comparison();
+            if(_matches(node, code, key)) {
+                return prev;
+            }
+            // stop at the end of the chain or of the bucket
+            if(node->next == nullptr || _node_bucket(node->next_node()) != bucket) {
+                return nullptr;
+            }
+        }
+     }
+
+    // returns the node holding key in bucket, or nullptr
+    template <typename K>
+    HashNode * _find(size_type code, size_type bucket, const K & key) const { 
+        HashNodeBase * prev = _find_before(code, bucket, key);
+        return prev ? static_cast<HashNode *>(prev->next) : nullptr;
+     }
+
+    // call above with the given key
+    template <typename K>
+    HashNode * _find(const K & key) const {
+        size_type code = _hash(key);
+        return _find(code, _slot(code), key);
+    }
+
+    // hints that p is about to be read; does nothing where the compiler has no prefetch builtin
+    static void _prefetch(const void * p) {
+#if defined(__GNUC__)
+        __builtin_prefetch(p);
+#else
+        (void) p;
+#endif
+    }
+
+    /*
+    Looks the keys up FIND_BATCH_GROUP at a time and passes each result to
+    out(i, node). Reaching a key's first node takes three dependent loads:
+    the bucket pointer, the node before the bucket (whose next is the first
+    node) and the first node itself. Rather than stalling on each in turn
+    for every key, one pass over the group prefetches the bucket pointers,
+    the next the nodes they point at, the next the first nodes, so the
+    misses of a whole group overlap; the last pass walks the chains.
+    */
+    template <typename Out>
+    void _find_batch(const Key * keys, size_type n, Out out) const {
+        size_type codes[FIND_BATCH_GROUP];
+        size_type slots[FIND_BATCH_GROUP];
+        for(size_type first = 0; first < n; first += FIND_BATCH_GROUP) {
+            size_type count = std::min(FIND_BATCH_GROUP, n - first);
+            for(size_type i = 0; i < count; i++) {
+                codes[i] = _hash(keys[first + i]);
+                slots[i] = _slot(codes[i]);
+                _prefetch(slots[i] < _bucket_count ? &_buckets[slots[i]] : &_old_buckets[slots[i] - _bucket_count]);
+            }
+            for(size_type i = 0; i < count; i++) {
+                if(HashNodeBase * prev = _head(slots[i])) {
+                    _prefetch(prev);
+                }
+            }
+            for(size_type i = 0; i < count; i++) {
+                if(HashNodeBase * prev = _head(slots[i])) {
+                    _prefetch(prev->next);
+                }
+            }
+            for(size_type i = 0; i < count; i++) {
+                out(first + i, _find(codes[i], slots[i], keys[first + i]));
+            }
+        }
+    }
+
+    // links node in as the first node of bucket
+    void _insert_bucket_begin(size_type bucket, HashNode * node) {
+        HashNodeBase *& head = _head(bucket);
+        if(head) {
+            // the bucket already has a predecessor, put node right after it
+            node->next = head->next;
+            head->next = node;
+            return;
+        }
+        // an empty bucket starts at the front of the chain
+        node->next = _before_begin.next;
+        _before_begin.next = node;
+        if(node->next) {
+            // the bucket that used to be in front is now preceded by node
+            _head(_node_bucket(node->next_node())) = node;
+        }
+        head = &_before_begin;
+    }
+
+    // unlinks the node after prev, which belongs to bucket, and returns it
+    HashNode * _unlink_after(size_type bucket, HashNodeBase * prev) {
+        HashNode * node = static_cast<HashNode *>(prev->next);
+        HashNode * next = node->next_node();
+        // node is the last of its bucket when the chain ends or moves on to another bucket
+        bool ends_bucket = next == nullptr;
+        if(next) {
+            size_type next_bucket = _node_bucket(next);
+            if(next_bucket != bucket) {
+                // next starts its bucket, which is now preceded by prev
+                _head(next_bucket) = prev;
+                ends_bucket = true;
+            }
+        }
+        if(ends_bucket && prev == _head(bucket)) {
+            // node was the only node in its bucket
+            _head(bucket) = nullptr;
+        }
+        prev->next = next;
+        return node;
+    }
+    
+    // a node whose value is built from args
+    template <typename... Args>
+    HashNode * _new_node(Args &&... args) {
+        HashNode * node = _node_traits::allocate(_node_alloc, 1);
+        _node_traits::construct(_node_alloc, node, std::in_place, std::forward<Args>(args)...);
+        return node;
+    }
+
+    void _delete_node(HashNode * node) {
+        _node_traits::destroy(_node_alloc, node);
+        _node_traits::deallocate(_node_alloc, node, 1);
+    }
+
+    // an array of count empty buckets
+    HashNodeBase ** _new_buckets(size_type count) {
+        _bucket_allocator alloc(_node_alloc);
+        HashNodeBase ** buckets = _bucket_traits::allocate(alloc, count);
+        std::fill(buckets, buckets + count, nullptr);
+        return buckets;
+    }
+
+    void _delete_buckets(HashNodeBase ** buckets, size_type count) {
+        if(buckets == _shared_empty()) {
+            return;
+        }
+        _bucket_allocator alloc(_node_alloc);
+        _bucket_traits::deallocate(alloc, buckets, count);
+    }
+
+    // links node, whose key has hash code code, in as the head of bucket
+    HashNode * _insert_into_bucket(size_type bucket, size_type code, HashNode * node) {
+        if constexpr (_cache_codes) {
+            node->code = code;
+        }
+        _insert_bucket_begin(bucket, node);
+        _size++; // increment size
+        return node;   
+     }
+
+    // buckets needed to hold n elements under the max load factor
+    size_type _buckets_for(size_type n) const {
+        return static_cast<size_type>(std::ceil(static_cast<float>(n) / _max_load_factor));
+    }
+
+    // frees the old table of an incremental rehash, whose nodes have all been moved or dropped
+    void _drop_old_buckets() {
+        if(_old_buckets) {
+            _delete_buckets(_old_buckets, _old_bucket_count);
+            _old_buckets = nullptr;
+            _old_bucket_count = 0;
+            _rehash_cursor = 0;
+        }
+    }
+
+    /*
+    Moves the old buckets at the cursor to the new table until max_moved of
+    them held nodes or 10 * max_moved have been looked at, so one step
+    stays cheap even across a long run of empty buckets. A bucket's nodes
+    are adjacent, so they are cut out of the chain at once; advancing the
+    cursor then makes their codes map to the new table, where they are
+    linked in one by one.
+    */
+    void _rehash_step(size_type max_moved) {
+        [[maybe_unused]] typename Stats::timer timer(_stats);
+        size_type n_moved = 0;
+        for(size_type n_visited = 0; _rehash_cursor < _old_bucket_count && n_moved < max_moved && n_visited < 10 * max_moved; n_visited++) {
+            HashNodeBase * prev = _old_buckets[_rehash_cursor];
+            if(prev == nullptr) {
+                _rehash_cursor++;
+                continue;
+            }
+            size_type slot = _bucket_count + _rehash_cursor;
+            HashNode * first = static_cast<HashNode *>(prev->next);
+            HashNode * last = first;
+            while(last->next && _node_bucket(last->next_node()) == slot) {
+                last = last->next_node();
+            }
+            HashNode * next = last->next_node();
+            prev->next = next;
+            if(next) {
+                _head(_node_bucket(next)) = prev;
+            }
+            last->next = nullptr;
+            _old_buckets[_rehash_cursor] = nullptr;
+            _rehash_cursor++;
+
+            while(first) {
+                HashNode * node = first;
+                first = first->next_node();
+                _insert_bucket_begin(_range_hash(_code(node)), node);
+            }
+            n_moved++;
+        }
+        if(_rehash_cursor == _old_bucket_count) {
+            _drop_old_buckets();
+        }
+    }
+
+    void _finish_rehash() {
+        while(_old_buckets) {
+            _rehash_step(_old_bucket_count);
+        }
+    }
+
+    // swaps in an empty table of BucketPolicy::bucket_count_for(count) buckets, keeping the current one as the old table
+    void _start_incremental_rehash(size_type count) {
+        _finish_rehash();
+        BucketPolicy new_range_hash(count);
+        if(new_range_hash.bucket_count() == _bucket_count) {
+            return;
+        }
+        _stats.rehash();
+        _old_buckets = _buckets;
+        _old_bucket_count = _bucket_count;
+        _old_range_hash = _range_hash;
+        _rehash_cursor = 0;
+        _bucket_count = new_range_hash.bucket_count();
+        _buckets = _new_buckets(_bucket_count);
+        _range_hash = new_range_hash;
+    }
+
+    // relinks every node into a fresh array of BucketPolicy::bucket_count_for(count) buckets
+    void _rehash(size_type count) {
+        BucketPolicy new_range_hash(count);
+        size_type new_bucket_count = new_range_hash.bucket_count();
+        if(new_bucket_count == _bucket_count) {
+            // nodes of an unfinished incremental rehash still have to move
+            _finish_rehash();
+            return;
+        }
+        _stats.rehash();
+        [[maybe_unused]] typename Stats::timer timer(_stats);
+        HashNodeBase ** new_buckets = _new_buckets(new_bucket_count);
+        HashNode * node = static_cast<HashNode *>(_before_begin.next);
+        _before_begin.next = nullptr;
+        // bucket of the node currently at the front of the rebuilt chain
+        size_type front_bucket = 0;
+        while(node) {
+            HashNode * next = node->next_node();
+            size_type bucket = new_range_hash(_code(node));
+            if(new_buckets[bucket]) {
+                node->next = new_buckets[bucket]->next;
+                new_buckets[bucket]->next = node;
+            } else {
+                node->next = _before_begin.next;
+                _before_begin.next = node;
+                new_buckets[bucket] = &_before_begin;
+                if(node->next) {
+                    new_buckets[front_bucket] = node;
+                }
+                front_bucket = bucket;
+            }
+            node = next;
+        }
+        // every node was placed from its code alone, so an incremental rehash is over too
+        _drop_old_buckets();
+        _delete_buckets(_buckets, _bucket_count);
+        _buckets = new_buckets;
+        _bucket_count = new_bucket_count;
+        _range_hash = new_range_hash;
+    }
+
+    /*
+    Grows the table if one more element would exceed the max load factor, and
+    moves on an incremental rehash. Returns whether slots may have changed.
+    */
+    bool _reserve_for_insert() {
+        if(_buckets == _shared_empty()) {
+            // a moved-from map gets buckets of its own, as many as it had, on its first insert
+            _buckets = _new_buckets(_bucket_count);
+        }
+        bool moved = _old_buckets != nullptr;
+        if(moved) {
+            _rehash_step(INCREMENTAL_REHASH_STEP);
+        }
+        if(static_cast<float>(_size + 1) <= static_cast<float>(_bucket_count) * _max_load_factor) {
+            return moved;
+        }
+        // at least double so a run of inserts rehashes O(log n) times
+        size_type count = std::max(2 * _bucket_count, _buckets_for(_size + 1));
+        if(_incremental_rehash) {
+            _start_incremental_rehash(count);
+        } else {
+            _rehash(count);
+        }
+        return true;
+    }
+
+    /*
+    Hashes key once and returns its node if it is present. Otherwise links in
+    the node make_node() returns, which must hold key, so nothing is built
+    when the insertion fails.
+    */
+    template <typename K, typename MakeNode>
+    std::pair<iterator, bool> _try_insert(const K & key, MakeNode make_node) {
+        return _try_insert(key, _hash(key), make_node);
+    }
+
+    // as above, for a key whose code the caller has already computed
+    template <typename K, typename MakeNode>
+    std::pair<iterator, bool> _try_insert(const K & key, size_type code, MakeNode make_node) {
+        size_type bucket = _slot(code);
+        HashNode * node = _find(code, bucket, key);
+        if(node) {
+            return std::make_pair(iterator(node), false);
+        }
+        if(_reserve_for_insert()) {
+            bucket = _slot(code);
+        }
+        return std::make_pair(iterator(_insert_into_bucket(bucket, code, make_node())), true);
+    }
+
+    /*
+    Links in node, built by this map's allocator, unless its key is present,
+    in which case the existing node is returned and node is left to the
+    caller. Hashes the key once, or not at all when the code can be reused.
+    */
+    std::pair<iterator, bool> _insert_node(HashNode * node, size_type code) {
+        size_type bucket = _slot(code);
+        HashNode * existing = _find(code, bucket, _key(node->val));
+        if(existing) {
+            return std::make_pair(iterator(existing), false);
+        }
+        if(_reserve_for_insert()) {
+            bucket = _slot(code);
+        }
+        return std::make_pair(iterator(_insert_into_bucket(bucket, code, node)), true);
+    }
+
+    /*
+    Links in node whatever keys are present: right before the first node with
+    an equal key, so equal keys stay one run of the chain, or as the first
+    node of its bucket when there is none.
+    */
+    iterator _insert_equal(HashNode * node, size_type code) {
+        _reserve_for_insert();
+        size_type bucket = _slot(code);
+        HashNodeBase * prev = _find_before(code, bucket, _key(node->val));
+        if(prev == nullptr) {
+            return iterator(_insert_into_bucket(bucket, code, node));
+        }
+        if constexpr (_cache_codes) {
+            node->code = code;
+        }
+        // prev stays the node before the bucket's first if that is where node goes
+        node->next = prev->next;
+        prev->next = node;
+        _size++;
+        return iterator(node);
+    }
+
+    // links in node, built by this table's allocator, under the table's key rule; returns whether it went in
+    bool _link(HashNode * node, size_type code) {
+        if constexpr (UniqueKeys) {
+            return _insert_node(node, code).second;
+        } else {
+            _insert_equal(node, code);
+            return true;
+        }
+    }
+
+    // inserts a new node holding other's element, moved out of it, under the table's key rule
+    bool _insert_moved(HashNode * other) {
+        if constexpr (UniqueKeys) {
+            return _try_insert(_key(other->val), [&] { return _new_node(std::move(other->val)); }).second;
+        } else {
+            HashNode * node = _new_node(std::move(other->val));
+            _insert_equal(node, _hash(_key(node->val)));
+            return true;
+        }
+    }
+
+    // the code of a node coming from another map: cached codes carry over when Hash has no state to differ in
+    size_type _transferred_code(const HashNode * node) const {
+        if constexpr (_cache_codes && std::is_empty<Hash>::value) {
+            return node->code;
+        } else {
+            return _hash(_key(node->val));
+        }
+    }
+
+    // whether nodes allocated through alloc may be freed through this map's allocator
+    bool _same_allocator(const _node_allocator & alloc) const {
+        if constexpr (_node_traits::is_always_equal::value) {
+            return true;
+        } else {
+            return _node_alloc == alloc;
+        }
+    }
+
+    // unlinks node from the chain and returns it without freeing it
+    HashNode * _unlink(HashNode * node) {
+        // the chain is singly linked, so walk the bucket to find the node before
+        size_type bucket = _node_bucket(node);
+        HashNodeBase * prev = _head(bucket);
+        while(prev->next != node) {
+            prev = prev->next;
+        }
+        _size--;
+        return _unlink_after(bucket, prev);
+    }
+
+    // unlinks the node holding key and returns it without freeing it, or returns nullptr
+    template <typename K>
+    HashNode * _unlink_key(const K & key) {
+        size_type code = _hash(key);
+        size_type bucket = _slot(code);
+        HashNodeBase * prev = _find_before(code, bucket, key);
+        if(prev == nullptr) {
+            return nullptr;
+        }
+        _size--;
+        return _unlink_after(bucket, prev);
+    }
+
+    // erases every element keyed by key, which are adjacent, and returns how many there were
+    template <typename K>
+    size_type _erase_key(const K & key) { return _erase_key(key, _hash(key)); }
+
+    template <typename K>
+    size_type _erase_key(const K & key, size_type code) {
+        size_type bucket = _slot(code);
+        HashNodeBase * prev = _find_before(code, bucket, key);
+        size_type n_erased = 0;
+        while(prev && prev->next && _matches(static_cast<HashNode *>(prev->next), code, key)) {
+            _delete_node(_unlink_after(bucket, prev));
+            _size--;
+            n_erased++;
+            if constexpr (UniqueKeys) {
+                break;
+            }
+        }
+        return n_erased;
+    }
+
+    // the first node keyed by key and the node after the last, or two nullptrs
+    template <typename K>
+    std::pair<HashNode *, HashNode *> _equal_range(const K & key) const {
+        size_type code = _hash(key);
+        HashNode * first = _find(code, _slot(code), key);
+        if(first == nullptr) {
+            return { nullptr, nullptr };
+        }
+        HashNode * last = first->next_node();
+        if constexpr (!UniqueKeys) {
+            // equal keys share a bucket, so the run ends at the first other key
+            while(last && _matches(last, code, key)) {
+                last = last->next_node();
+            }
+        }
+        return { first, last };
+    }
+
+    // the number of elements keyed by key, walking the run _equal_range finds
+    template <typename K>
+    size_type _count(const K & key) const {
+        std::pair<HashNode *, HashNode *> range = _equal_range(key);
+        size_type n = 0;
+        for(HashNode * node = range.first; node != range.second; node = node->next_node()) {
+            n++;
+        }
+        return n;
+    }
+
+    // gives this map empty buckets shaped like other's, including the old table of a rehash
+    void _copy_tables(const HashTable & other) {
+        _bucket_count = other._bucket_count;
+        _buckets = _new_buckets(_bucket_count);
+        _range_hash = other._range_hash;
+        if(other._old_buckets) {
+            _old_bucket_count = other._old_bucket_count;
+            _old_buckets = _new_buckets(_old_bucket_count);
+            _old_range_hash = other._old_range_hash;
+            _rehash_cursor = other._rehash_cursor;
+        }
+    }
+
+    /*
+    Copies other's chain node by node into this map, whose slots are empty
+    and shaped like other's. Every bucket's nodes are adjacent in the chain, so
+    the first time a bucket comes up its pointer is set to the current tail:
+    no key is looked up, and with cached codes none is hashed. Nodes in the
+    reuse list get the new values before any node is allocated; leftovers
+    are freed.
+    */
+    void _clone_chain(const HashTable & other, HashNode * reuse) {
+        HashNodeBase * tail = &_before_begin;
+        for(const HashNode * src = static_cast<const HashNode *>(other._before_begin.next); src; src = src->next_node()) {
+            HashNode * node = reuse;
+            if(node) {
+                reuse = reuse->next_node();
+                _node_traits::destroy(_node_alloc, node);
+                _node_traits::construct(_node_alloc, node, std::in_place, src->val);
+            } else {
+                node = _new_node(src->val);
+            }
+            if constexpr (_cache_codes) {
+                node->code = src->code;
+            }
+            size_type bucket = other._node_bucket(src);
+            if(_head(bucket) == nullptr) {
+                _head(bucket) = tail;
+            }
+            tail->next = node;
+            tail = node;
+        }
+        tail->next = nullptr;
+        _size = other._size;
+
+        while(reuse) {
+            HashNode * next = reuse->next_node();
+            _delete_node(reuse);
+            reuse = next;
+        }
+    }
+
+    // takes over other's chain and the old table of its rehash once its buckets have been adopted
+    void _take_chain(HashTable & other) {
+        _old_buckets = other._old_buckets;
+        _old_bucket_count = other._old_bucket_count;
+        _old_range_hash = other._old_range_hash;
+        _rehash_cursor = other._rehash_cursor;
+        other._old_buckets = nullptr;
+        other._old_bucket_count = 0;
+        other._rehash_cursor = 0;
+
+        _before_begin.next = other._before_begin.next;
+        other._before_begin.next = nullptr;
+        if(_before_begin.next) {
+            // the front bucket pointed at other's _before_begin
+            _head(_node_bucket(static_cast<HashNode *>(_before_begin.next))) = &_before_begin;
+        }
+    }
+
+    /*
+    Leaves this map, whose nodes and buckets have been taken, empty with the
+    smallest table BucketPolicy allows, which it shares with every other
+    moved-from map, so a move allocates nothing; see _shared_empty.
+    */
+    void _leave_empty() noexcept {
+        _range_hash = BucketPolicy(0);
+        _bucket_count = _range_hash.bucket_count();
+        _buckets = _shared_empty();
+        _size = 0;
+    }
+
+    // runs f(0), ..., f(n_threads - 1) at once, the last one on the calling thread
+    template <typename F>
+    static void _run_parallel(size_type n_threads, F f) {
+        std::vector<std::thread> threads;
+        threads.reserve(n_threads - 1);
+        for(size_type t = 0; t + 1 < n_threads; t++) {
+            threads.emplace_back(f, t);
+        }
+        f(n_threads - 1);
+        for(std::thread & thread : threads) {
+            thread.join();
+        }
+    }
+
+    /*
+    Fills this map, which is empty, from the n pairs at first, in four passes
+    of n_threads threads each:
+
+    1. Each thread hashes a contiguous chunk of the input and counts its
+       pairs per bucket range.
+    2. Prefix sums of the counts give every (chunk, range) pair its place
+       in one array, to which each thread scatters its chunk's indices. A
+       range's indices end up in input order.
+    3. Each thread takes whole bucket ranges and links their pairs into a
+       chain of the range's own, exactly as _rehash relinks nodes. Threads
+       share no bucket and no node, so they need no locks. Equal keys share
+       a bucket and so a range, where the first one kept is the first in
+       input order.
+    4. The calling thread strings the ranges' chains together.
+
+    Nodes come from the allocator in pass 3 when it is always equal, as
+    std::allocator is, since such allocators hold no state for threads to
+    race on. Any other allocator hands out all n nodes up front on the
+    calling thread, and those a duplicate key leaves unused are freed at
+    the end. Hash and Pred must be safe to call from several threads.
+
+    Keys are read from the input through KeyOfValue, which takes the
+    input's own pair type, so no pair is copied but into its node. If
+    allocating the nodes up front throws, those already allocated are
+    freed and the exception reaches the caller, with the map still empty.
+    An allocation or copy that throws on a worker thread, in pass 3,
+    calls std::terminate.
+    */
+    template <typename RandomIt>
+    void _build_parallel(RandomIt first, size_type n, size_type n_threads, duplicate_policy duplicates) {
+        constexpr bool parallel_alloc = _node_traits::is_always_equal::value;
+        n_threads = std::max<size_type>(1, std::min(n_threads, n / 1024 + 1));
+        size_type n_ranges = n_threads * BUILD_RANGES_PER_THREAD;
+        // the chunk of the input and the bucket range of a pair
+        auto chunk_begin = [&](size_type t) { return n * t / n_threads; };
+        auto range_of = [&](size_type bucket) { return bucket * n_ranges / _bucket_count; };
+
+        std::vector<size_type> codes(n);
+        std::vector<size_type> offsets(n_threads * n_ranges, 0);
+        _run_parallel(n_threads, [&](size_type t) {
+            size_type * counts = &offsets[t * n_ranges];
+            for(size_type i = chunk_begin(t); i < chunk_begin(t + 1); i++) {
+                codes[i] = _hash(KeyOfValue { }(first[i]));
+                counts[range_of(_range_hash(codes[i]))]++;
+            }
+        });
+
+        // range r's indices start at range_begins[r]: those from chunk 0, then chunk 1, ...
+        std::vector<size_type> range_begins(n_ranges + 1, 0);
+        size_type sum = 0;
+        for(size_type r = 0; r < n_ranges; r++) {
+            range_begins[r] = sum;
+            for(size_type t = 0; t < n_threads; t++) {
+                size_type count = offsets[t * n_ranges + r];
+                offsets[t * n_ranges + r] = sum;
+                sum += count;
+            }
+        }
+        range_begins[n_ranges] = sum;
+
+        std::vector<size_type> order(n);
+        _run_parallel(n_threads, [&](size_type t) {
+            size_type * next = &offsets[t * n_ranges];
+            for(size_type i = chunk_begin(t); i < chunk_begin(t + 1); i++) {
+                order[next[range_of(_range_hash(codes[i]))]++] = i;
+            }
+        });
+
+        // the preallocated nodes no pair took, freed on the way out, even when allocating them throws
+        struct spare_nodes {
+            _node_allocator & alloc;
+            std::vector<HashNode *> nodes;
+
+            ~spare_nodes() {
+                for(HashNode * node : nodes) {
+                    if(node) {
+                        _node_traits::deallocate(alloc, node, 1);
+                    }
+                }
+            }
+        } spare { _node_alloc, { } };
+        std::vector<HashNode *> & nodes = spare.nodes;
+        if constexpr (!parallel_alloc) {
+            nodes.resize(n, nullptr);
+            for(HashNode *& node : nodes) {
+                node = _node_traits::allocate(_node_alloc, 1);
+            }
+        }
+
+        // each range's chain starts after its own front, and ends at its first node linked
+        std::vector<HashNodeBase> fronts(n_ranges);
+        std::vector<HashNode *> tails(n_ranges, nullptr);
+        std::vector<size_type> front_buckets(n_ranges, 0);
+        std::vector<size_type> sizes(n_ranges, 0);
+        _run_parallel(n_threads, [&](size_type t) {
+            for(size_type r = t; r < n_ranges; r += n_threads) {
+                HashNodeBase & front = fronts[r];
+                for(size_type k = range_begins[r]; k < range_begins[r + 1]; k++) {
+                    size_type i = order[k];
+                    size_type code = codes[i];
+                    size_type bucket = _range_hash(code);
+
+                    HashNode * existing = nullptr;
+                    if(_buckets[bucket]) {
+                        for(HashNode * node = static_cast<HashNode *>(_buckets[bucket]->next);
+                            node && _range_hash(_code(node)) == bucket; node = node->next_node()) {
+                            if(_matches(node, code, KeyOfValue { }(first[i]))) {
+                                existing = node;
+                                break;
+                            }
+                        }
+                    }
+                    if(existing) {
+                        if constexpr (!_is_set) {
+                            if(duplicates == duplicate_policy::keep_last) {
+                                existing->val.second = first[i].second;
+                            }
+                        }
+                        continue;
+                    }
+
+                    HashNode * node;
+                    if constexpr (parallel_alloc) {
+                        node = _new_node(first[i]);
+                    } else {
+                        node = nodes[i];
+                        nodes[i] = nullptr;
+                        _node_traits::construct(_node_alloc, node, std::in_place, first[i]);
+                    }
+                    if constexpr (_cache_codes) {
+                        node->code = code;
+                    }
+                    if(_buckets[bucket]) {
+                        node->next = _buckets[bucket]->next;
+                        _buckets[bucket]->next = node;
+                    } else {
+                        node->next = front.next;
+                        front.next = node;
+                        _buckets[bucket] = &front;
+                        if(node->next) {
+                            _buckets[front_buckets[r]] = node;
+                        } else {
+                            tails[r] = node;
+                        }
+                        front_buckets[r] = bucket;
+                    }
+                    sizes[r]++;
+                }
+            }
+        });
+
+        HashNodeBase * tail = &_before_begin;
+        for(size_type r = 0; r < n_ranges; r++) {
+            if(fronts[r].next) {
+                tail->next = fronts[r].next;
+                _buckets[front_buckets[r]] = tail;
+                tail = tails[r];
+            }
+            _size += sizes[r];
+        }
+        tail->next = nullptr;
+    }
+
+    // whether a move assignment may take other's nodes, which this map's allocator then frees
+    static constexpr bool _moves_nodes = _node_traits::propagate_on_container_move_assignment::value
+                                         || _node_traits::is_always_equal::value;
+    static constexpr bool _nothrow_copy_functors = std::is_nothrow_copy_constructible<Hash>::value
+                                                   && std::is_nothrow_copy_constructible<key_equal>::value;
+
+public:
+
+    // construct _buckets array
+    // size _buckets array should be a prime number
+    // initialize array with nullptr
+    // Ptr* new_node = new Ptr [size]{};
+
+    explicit HashTable(size_type bucket_count, const Hash & hash = Hash { },
+                const key_equal & equal = key_equal { }, const allocator_type & alloc = allocator_type { })
+                // hash and equal are initialized directly so they need not be default constructible
+                : _hash(hash), _equal(equal), _range_hash(bucket_count), _old_range_hash(_range_hash), _node_alloc(alloc) { 
+                    // default constructor
+                    // set up the shared empty table here, where throwing is allowed, before any move needs it
+                    _shared_empty();
+                    _bucket_count = _range_hash.bucket_count();
+                    _buckets = _new_buckets(_bucket_count);
+                    _size = 0;
+                    _max_load_factor = std::numeric_limits<float>::infinity();
+                }
+    // destructor
+    ~HashTable() { 
+        clear();
+        _delete_buckets(_buckets, _bucket_count);
+     }
+
+    // copy constructor
+    HashTable(const HashTable & other)
+        : _hash(other._hash), _equal(other._equal), _range_hash(other._range_hash), _old_range_hash(other._range_hash),
+          _incremental_rehash(other._incremental_rehash),
+          _node_alloc(_node_traits::select_on_container_copy_construction(other._node_alloc)) { 
+        // copy the content of other to this
+        _copy_tables(other);
+        _size = 0;
+        _max_load_factor = other._max_load_factor;
+        _clone_chain(other, nullptr);
+     }
+
+    /*
+    Takes other's nodes and bucket array as they are, allocating nothing,
+    and leaves other empty but usable, with its own copy of the hasher and
+    equality predicate. Every iterator into other now points into this map.
+    */
+    HashTable(HashTable && other) noexcept(_nothrow_copy_functors)
+        : _bucket_count(other._bucket_count), _buckets(other._buckets), _size(other._size),
+          _hash(other._hash), _equal(other._equal), _max_load_factor(other._max_load_factor),
+          _range_hash(other._range_hash), _old_range_hash(other._range_hash),
+          _incremental_rehash(other._incremental_rehash), _node_alloc(other._node_alloc) { 
+        _take_chain(other);
+        other._leave_empty();
+     }
+
+    // copy assignment
+    HashTable & operator=(const HashTable & other) { 
+        // copy the content of other to this
+        if(this != &other) {
+            // the old nodes are recycled for other's elements, and the bucket array if it fits
+            HashNode * reuse = static_cast<HashNode *>(_before_begin.next);
+            _before_begin.next = nullptr;
+            _drop_old_buckets();
+            if(_bucket_count == other._bucket_count && other._old_buckets == nullptr && _buckets != _shared_empty()) {
+                std::fill(_buckets, _buckets + _bucket_count, nullptr);
+                _range_hash = other._range_hash;
+            } else {
+                _delete_buckets(_buckets, _bucket_count);
+                _copy_tables(other);
+            }
+            _incremental_rehash = other._incremental_rehash;
+            _size = 0;
+            _hash = other._hash;
+            _equal = other._equal;
+            _max_load_factor = other._max_load_factor;
+            _clone_chain(other, reuse);
+        }
+        return *this;
+     }
+
+    /*
+    Frees this map's nodes and buckets and takes other's, allocating nothing,
+    unless the allocator neither propagates nor always compares equal and
+    the two differ: this map's allocator could not free other's nodes then,
+    so the elements are moved into new ones instead.
+    */
+    HashTable & operator=(HashTable && other) noexcept(_moves_nodes && _nothrow_copy_functors) { 
+        if(this == &other) {
+            return *this;
+        }
+        if constexpr (!_moves_nodes) {
+            if(_node_alloc != other._node_alloc) {
+                clear();
+                _hash = other._hash;
+                _equal = other._equal;
+                _max_load_factor = other._max_load_factor;
+                _incremental_rehash = other._incremental_rehash;
+                reserve(other._size);
+                for(HashNode * node = static_cast<HashNode *>(other._before_begin.next); node; node = node->next_node()) {
+                    _insert_moved(node);
+                }
+                other.clear();
+                return *this;
+            }
+        }
+        clear();
+        _delete_buckets(_buckets, _bucket_count);
+        // the nodes change owner without being copied, so the allocator goes with them
+        if constexpr (_node_traits::propagate_on_container_move_assignment::value) {
+            _node_alloc = other._node_alloc;
+        }
+        _buckets = other._buckets;
+        _bucket_count = other._bucket_count;
+        _range_hash = other._range_hash;
+        _size = other._size;
+        _hash = other._hash;
+        _equal = other._equal;
+        _max_load_factor = other._max_load_factor;
+        _incremental_rehash = other._incremental_rehash;
+        _take_chain(other);
+        other._leave_empty();
+        return *this;
+     }
+
+    // frees the nodes in chain order, which is bucket by bucket, then empties the buckets
+    void clear() noexcept { 
+        HashNode * node = static_cast<HashNode *>(_before_begin.next);
+        while(node) {
+            HashNode * next = node->next_node();
+            _delete_node(node);
+            node = next;
+        }
+        _before_begin.next = nullptr;
+        if(_buckets != _shared_empty()) {
+            std::fill(_buckets, _buckets + _bucket_count, nullptr);
+        }
+        _drop_old_buckets();
+        _size = 0;
+     }
+
+    allocator_type get_allocator() const { return allocator_type(_node_alloc); }
+    hasher hash_function() const { return _hash; }
+    key_equal key_eq() const { return _equal; }
+
+    size_type size() const noexcept { return _size; }
+
+    bool empty() const noexcept { return _size == 0; }
+
+    size_type bucket_count() const noexcept { 
+        // returns number of buckets
+        return _bucket_count;
+    }
+    // returns an iterator to the first element of the map
+    iterator begin() { return iterator(static_cast<HashNode *>(_before_begin.next)); }
+    // returns an iterator to the element following the last element of the map
+    iterator end() { return iterator(nullptr); }
+
+    const_iterator cbegin() const { 
+        // returns a const iterator to the first element of the map
+        return const_iterator(static_cast<HashNode *>(_before_begin.next));
+     };
+    const_iterator cend() const { 
+        return const_iterator(nullptr);
+     };
+
+    // the bucket interface sees the new table only, so it finishes an incremental rehash first
+    local_iterator begin(size_type n) { 
+        // Returns a local iterator to the first element of the bucket with index n.
+        _finish_rehash();
+        HashNode * first = _buckets[n] ? static_cast<HashNode *>(_buckets[n]->next) : nullptr;
+        return local_iterator(this, first, n);
+     }
+    local_iterator end(size_type n) { 
+        // Returns a local iterator to the element following the last element of the bucket with index n.
+        return local_iterator(this, nullptr, n);
+    }
+
+    size_type bucket_size(size_type n) { 
+        // returns the number of elements in the bucket
+        size_type count = 0;
+        for(local_iterator it = begin(n); it != end(n); ++it) {
+            count++; // iterate and count
+        }
+        return count;
+    }
+    // static cast to float, returns average # of elements per bucket
+    float load_factor() const { return  static_cast<float>( size() )/ bucket_count(); }
+
+    /*
+     The load factor an insert may not exceed before the map grows to the next
+     bucket count the policy allows. Defaults to infinity: the bucket count chosen at
+     construction stays fixed unless a maximum is set. ml must be positive.
+    */
+    float max_load_factor() const { return _max_load_factor; }
+    void max_load_factor(float ml) {
+        _max_load_factor = ml;
+        if(load_factor() > _max_load_factor) {
+            _rehash(_buckets_for(_size));
+        }
+    }
+
+    /*
+     Sets the bucket count to BucketPolicy::bucket_count_for(count), which is
+     next_greater_prime(count) by default, but never below what size() needs
+     under the max load factor. Nodes are relinked, not reallocated, so
+     pointers and references stay valid; iterators are invalidated.
+    */
+    void rehash(size_type count) { _rehash(std::max(count, _buckets_for(_size))); }
+
+    /*
+     With incremental rehashing on, an insert that grows the table only
+     allocates the new bucket array. The old one is kept, and every insert
+     after it moves up to INCREMENTAL_REHASH_STEP of its buckets over, so no
+     single insert relinks more than a few buckets' worth of nodes. Lookups
+     and erasures meanwhile find each key in whichever table holds it, and
+     iteration still visits every element once. Off by default. Turning it
+     off finishes a rehash in progress, as do rehash, reserve and the bucket
+     interface (begin(n) and bucket_size).
+    */
+    bool incremental_rehash() const { return _incremental_rehash; }
+    void incremental_rehash(bool on) {
+        _incremental_rehash = on;
+        if(!on) {
+            _finish_rehash();
+        }
+    }
+
+    // whether an incremental rehash is still moving buckets
+    bool rehashing() const { return _old_buckets != nullptr; }
+
+    /*
+     Measures the shape of the table, walking the chain once, and reports it
+     with whatever counters Stats keeps; see map_stats.h.
+     During an incremental rehash the old buckets not yet moved count as
+     buckets too.
+    */
+    map_stats stats() const {
+        map_stats stats;
+        stats.size = _size;
+        stats.bucket_count = _bucket_count;
+        stats.load_factor = load_factor();
+
+        // a bucket's nodes are adjacent, so each run of nodes in one slot is a whole bucket
+        size_type n_slots = _bucket_count + (_old_buckets ? _old_bucket_count - _rehash_cursor : 0);
+        size_type n_chains = 0;
+        double sum_squares = 0;
+        size_type slot = 0;
+        size_type length = 0;
+        for(const HashNode * node = static_cast<const HashNode *>(_before_begin.next); ; node = node->next_node()) {
+            size_type node_slot = node ? _node_bucket(node) : 0;
+            if(length && (node == nullptr || node_slot != slot)) {
+                n_chains++;
+                stats.max_chain = std::max(stats.max_chain, length);
+                sum_squares += static_cast<double>(length) * length;
+                length = 0;
+            }
+            if(node == nullptr) {
+                break;
+            }
+            slot = node_slot;
+            if(length == stats.probe_histogram.size()) {
+                stats.probe_histogram.push_back(0);
+            }
+            stats.probe_histogram[length]++;
+            length++;
+        }
+        stats.empty_buckets = n_slots - n_chains;
+        stats.empty_bucket_ratio = static_cast<double>(stats.empty_buckets) / n_slots;
+        double mean_bucket = static_cast<double>(_size) / n_slots;
+        stats.bucket_variance = sum_squares / n_slots - mean_bucket * mean_bucket;
+        if(n_chains) {
+            stats.mean_chain = static_cast<double>(_size) / n_chains;
+            stats.chain_variance = sum_squares / n_chains - stats.mean_chain * stats.mean_chain;
+        }
+        if(_size) {
+            // a chain of length l takes l(l + 1) / 2 comparisons to look up each of its keys once
+            double n = static_cast<double>(_size), m = static_cast<double>(n_slots);
+            double looked_at = (sum_squares + n) / 2;
+            stats.hash_quality = looked_at / (n / (2 * m) * (n + 2 * m - 1));
+        }
+
+        _stats.report(stats);
+        return stats;
+    }
+
+    // zeroes the counters stats reports
+    void reset_stats() {
+        _stats.reset();
+    }
+
+    // makes room for count elements without exceeding the max load factor
+    void reserve(size_type count) {
+        if(static_cast<float>(count) > static_cast<float>(_bucket_count) * _max_load_factor) {
+            _rehash(_buckets_for(count));
+        }
+    }
+
+    size_type bucket(const Key & key) const { 
+        /*
+         Returns the index of the bucket for key. Elements (if any) with keys 
+         equivalent to key are always found in this bucket. The returned value is valid only 
+         for instances of the container for which bucket_count() returns the same value.
+        */
+        return _bucket(key);
+    }
+
+
+    /*
+    Inserts value using move semantics. With unique keys, returns a pair
+    consisting of an iterator to the inserted element (or to the element that
+    prevented the insertion) and a bool denoting whether the insertion took
+    place; otherwise the insertion always takes place and the iterator is
+    returned alone.
+    */
+    insert_result insert(value_type && value) { 
+        if constexpr (UniqueKeys) {
+            // insertion fails when the key already exists
+            return _try_insert(_key(value), [&] { return _new_node(std::move(value)); });
+        } else {
+            HashNode * node = _new_node(std::move(value));
+            return _insert_equal(node, _hash(_key(node->val)));
+        }
+     }
+
+    // value is only copied when the insertion takes place
+    insert_result insert(const value_type & value) { 
+        if constexpr (UniqueKeys) {
+            return _try_insert(_key(value), [&] { return _new_node(value); });
+        } else {
+            HashNode * node = _new_node(value);
+            return _insert_equal(node, _hash(_key(node->val)));
+        }
+     }
+
+    /*
+    Builds an element from args in a new node, then links it in unless its
+    key is present and keys are unique, in which case the node is destroyed.
+    The key is only known once the element exists, so unlike try_emplace
+    this always builds one; it still hashes once.
+    */
+    template <typename... Args>
+    insert_result emplace(Args &&... args) {
+        HashNode * node = _new_node(std::forward<Args>(args)...);
+        if constexpr (UniqueKeys) {
+            std::pair<iterator, bool> result = _insert_node(node, _hash(_key(node->val)));
+            if(!result.second) {
+                _delete_node(node);
+            }
+            return result;
+        } else {
+            return _insert_equal(node, _hash(_key(node->val)));
+        }
+    }
+
+    /*
+    Links in the node nh owns unless its key is present and keys are
+    unique, in which case nh comes back in the result, still owning it. The
+    node is relinked as is, so nothing is allocated, copied or moved; only
+    a node whose allocator differs from this table's has its element moved
+    into a new node.
+    */
+    node_insert_result insert(node_type && nh) {
+        if(nh.empty()) {
+            if constexpr (UniqueKeys) {
+                return { end(), false, node_type() };
+            } else {
+                return end();
+            }
+        }
+        HashNode * node = nh._node;
+        size_type code = _transferred_code(node);
+        if(!_same_allocator(*nh._alloc)) {
+            if constexpr (UniqueKeys) {
+                HashNode * existing = _find(code, _slot(code), _key(node->val));
+                if(existing) {
+                    return { iterator(existing), false, std::move(nh) };
+                }
+            }
+            node = _new_node(std::move(node->val));
+            nh._reset();
+        }
+        if constexpr (UniqueKeys) {
+            std::pair<iterator, bool> result = _insert_node(node, code);
+            if(!result.second) {
+                return { result.first, false, std::move(nh) };
+            }
+            nh._release();
+            return { result.first, true, node_type() };
+        } else {
+            nh._release();
+            return _insert_equal(node, code);
+        }
+    }
+
+    // unlinks the element at pos and hands its node over, without freeing it
+    node_type extract(iterator pos) { return node_type(_unlink(pos._ptr), _node_alloc); }
+
+    // unlinks the (first) element keyed by key, if any, and hands its node over
+    node_type extract(const Key & key) {
+        HashNode * node = _unlink_key(key);
+        return node ? node_type(node, _node_alloc) : node_type();
+    }
+
+    /*
+    Moves the elements of source over to this table by relinking their
+    nodes: all of them when equal keys are allowed, otherwise those whose
+    key this table lacks, leaving the rest in source. Like
+    insert(node_type &&) this allocates nothing, unless the two tables'
+    allocators differ, in which case each element moved over is moved into
+    a new node.
+    */
+    void merge(HashTable & source) {
+        if(&source == this) {
+            return;
+        }
+        if(!_same_allocator(source._node_alloc)) {
+            for(iterator it = source.begin(); it != source.end();) {
+                if(_insert_moved(it._ptr)) {
+                    it = source.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            return;
+        }
+        HashNodeBase * prev = &source._before_begin;
+        while(prev->next) {
+            HashNode * node = static_cast<HashNode *>(prev->next);
+            size_type code = _transferred_code(node);
+            if constexpr (UniqueKeys) {
+                if(_find(code, _slot(code), _key(node->val))) {
+                    prev = node;
+                    continue;
+                }
+            }
+            // prev then precedes the node after, which is looked at next
+            source._unlink_after(source._node_bucket(node), prev);
+            source._size--;
+            _link(node, code);
+        }
+    }
+
+    void merge(HashTable && source) { merge(source); }
+
+    iterator find(const Key & key) { 
+        /*
+         Finds an element with key equivalent to key. 
+         If no such element is found, past-the-end (see end()) iterator is returned.
+        */
+        HashNode* node = _find(key);
+        if(node == nullptr) {
+            return end();
+        }
+        return iterator(node);
+     }
+
+    const_iterator find(const Key & key) const {
+        HashNode * node = _find(key);
+        return node ? const_iterator(node) : cend();
+    }
+
+    // find for any key type Hash and Pred accept, when both are transparent
+    template <typename K, typename = enable_if_transparent_t<Hash, Pred, K>>
+    iterator find(const K & key) {
+        HashNode * node = _find(key);
+        return node ? iterator(node) : end();
+    }
+    template <typename K, typename = enable_if_transparent_t<Hash, Pred, K>>
+    const_iterator find(const K & key) const {
+        HashNode * node = _find(key);
+        return node ? const_iterator(node) : cend();
+    }
+
+    /*
+    Writes an iterator to each of the n elements keyed by keys to out, or end()
+    for keys that are absent, as calling find on every key would. Meant for
+    probing many keys in a row, such as the probe side of a hash join, where
+    it overlaps the cache misses of several lookups; see _find_batch.
+    */
+    void find_batch(const Key * keys, size_type n, iterator * out) {
+        _find_batch(keys, n, [&](size_type i, HashNode * node) { out[i] = node ? iterator(node) : end(); });
+    }
+
+    void find_batch(const Key * keys, size_type n, const_iterator * out) const {
+        _find_batch(keys, n, [&](size_type i, HashNode * node) { out[i] = node ? const_iterator(node) : cend(); });
+    }
+
+    bool contains(const Key & key) const { return _find(key) != nullptr; }
+
+    template <typename K, typename = enable_if_transparent_t<Hash, Pred, K>>
+    bool contains(const K & key) const { return _find(key) != nullptr; }
+
+    /*
+    find, contains and erase for a key the caller has already hashed, as a
+    sharded map does to pick the shard; code must be hash_function()(key).
+    The key is not hashed again.
+    */
+    iterator find_hashed(const Key & key, size_type code) {
+        HashNode * node = _find(code, _slot(code), key);
+        return node ? iterator(node) : end();
+    }
+    const_iterator find_hashed(const Key & key, size_type code) const {
+        HashNode * node = _find(code, _slot(code), key);
+        return node ? const_iterator(node) : cend();
+    }
+    bool contains_hashed(const Key & key, size_type code) const { return _find(code, _slot(code), key) != nullptr; }
+    size_type erase_hashed(const Key & key, size_type code) { return _erase_key(key, code); }
+
+    /*
+    The elements keyed by key, as [first, second), which are adjacent in the
+    chain so the range is walked like any other; both are end() when key is
+    absent. With unique keys the range holds one element at most.
+    */
+    std::pair<iterator, iterator> equal_range(const Key & key) {
+        std::pair<HashNode *, HashNode *> range = _equal_range(key);
+        return { iterator(range.first), iterator(range.second) };
+    }
+    std::pair<const_iterator, const_iterator> equal_range(const Key & key) const {
+        std::pair<HashNode *, HashNode *> range = _equal_range(key);
+        return { const_iterator(range.first), const_iterator(range.second) };
+    }
+
+    template <typename K, typename = enable_if_transparent_t<Hash, Pred, K>>
+    std::pair<iterator, iterator> equal_range(const K & key) {
+        std::pair<HashNode *, HashNode *> range = _equal_range(key);
+        return { iterator(range.first), iterator(range.second) };
+    }
+    template <typename K, typename = enable_if_transparent_t<Hash, Pred, K>>
+    std::pair<const_iterator, const_iterator> equal_range(const K & key) const {
+        std::pair<HashNode *, HashNode *> range = _equal_range(key);
+        return { const_iterator(range.first), const_iterator(range.second) };
+    }
+
+    // the number of elements keyed by key
+    size_type count(const Key & key) const { return _count(key); }
+
+    template <typename K, typename = enable_if_transparent_t<Hash, Pred, K>>
+    size_type count(const K & key) const { return _count(key); }
+
+    // find node
+    // return an iterator following the removed element
+    // return end() if the element is not found
+    iterator erase(iterator pos) { 
+        /*
+        Removes the element at pos. The given iterator pos must be valid and able to be dereferenced 
+        (you don't have to check this and can assume it to be true). 
+        Thus the end() iterator (which is valid, but is not able to be dereferenced) 
+        cannot be used as a value for pos. Returns an iterator following the last removed element.
+        */
+        HashNode * node = pos._ptr;
+        ++pos;
+        _delete_node(_unlink(node)); // unlink and delete the node
+        return pos;
+     }
+
+    // erases every element keyed by key and returns how many there were, 0 or 1 with unique keys
+    size_type erase(const Key & key) { return _erase_key(key); }
+
+    template <typename K, typename = enable_if_transparent_t<Hash, Pred, K>>
+    size_type erase(const K & key) { return _erase_key(key); }
+
+};
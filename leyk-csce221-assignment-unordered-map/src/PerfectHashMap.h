@@ -0,0 +1,298 @@
+#pragma once
+
+#include <algorithm>  // std::sort, std::adjacent_find, std::max
+#include <cstddef>    // size_t
+#include <cstdint>    // uint64_t, uint32_t
+#include <functional> // std::hash, std::equal_to
+#include <utility>    // std::pair, std::move
+#include <vector>     // std::vector
+
+#include "hash_traits.h"
+#include "primes.h"
+
+/*
+    Read-only map over a key set known up front, built around a minimal
+    perfect hash: every key gets its own slot in [0, size()), so a lookup
+    hashes once, probes one slot and compares one key.
+
+    The hash is PTHash-style hash-and-displace. Keys are spread over about
+    size() / KEYS_PER_BUCKET buckets. Buckets are then placed largest first:
+    for each one a pilot is searched for, the smallest number that, mixed
+    into the codes of the bucket's keys, sends all of them to free slots of
+    a table of size() / LOAD_FACTOR slots. A lookup recomputes its key's
+    slot from the key's bucket's pilot.
+
+    Pilots are stored bit-packed, as wide as the largest one needs, and
+    stay small since a table at LOAD_FACTOR always has some free slots left.
+    The few keys landing in the slots past size() are then moved to the
+    free slots below it, through a remap array. Together that comes to
+    about 3 bits per key besides the keys and values themselves; see
+    bits_per_key.
+
+    Codes come from Hash (the hashers of hash_functions.h work) and are
+    mixed with MurmurHash3's finalizer, so weak hashes are fine. Two keys
+    with the same code can never be told apart, so build fails on them.
+*/
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename Pred = std::equal_to<Key>>
+class PerfectHashMap {
+    public:
+
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using size_type = size_t;
+    using hasher = Hash;
+    using key_equal = Pred;
+
+    static constexpr size_type KEYS_PER_BUCKET = 5;
+    static constexpr double LOAD_FACTOR = 0.99;
+    // pilots searched per bucket before the build starts over with a new seed
+    static constexpr uint64_t MAX_PILOT = 1 << 20;
+    static constexpr size_type MAX_SEEDS = 16;
+
+    private:
+
+    Hash _hash;
+    Pred _equal;
+
+    uint64_t _seed = 0;
+    size_type _n_buckets = 0;
+    size_type _table_size = 0;
+
+    // bit-packed pilots, _pilot_bits each
+    std::vector<uint64_t> _pilots;
+    size_type _pilot_bits = 0;
+    // the slot below size() that stands in for each slot from size() up
+    std::vector<uint32_t> _remap;
+
+    // every element in its slot
+    std::vector<value_type> _slots;
+
+    static uint64_t _mix(uint64_t code) { return power_of_two_buckets::mix(code); }
+
+    // maps a uniform 64-bit value into [0, range) without a division
+    static uint64_t _reduce(uint64_t value, uint64_t range) {
+        return mulhi64(value, range);
+    }
+
+    uint64_t _bucket(uint64_t mixed) const { return _reduce(mixed, _n_buckets); }
+
+    uint64_t _position(uint64_t mixed, uint64_t pilot) const {
+        // the low half of mixed picked the bucket, so the pilot is mixed into all of it
+        return _reduce(_mix(mixed ^ _mix(pilot + 0x9E3779B97F4A7C15ull)), _table_size);
+    }
+
+    uint64_t _pilot(size_type bucket) const {
+        if(_pilot_bits == 0) {
+            return 0;
+        }
+        size_type bit = bucket * _pilot_bits;
+        uint64_t value = _pilots[bit / 64] >> (bit % 64);
+        if(bit % 64 + _pilot_bits > 64) {
+            value |= _pilots[bit / 64 + 1] << (64 - bit % 64);
+        }
+        return value & ((uint64_t(1) << _pilot_bits) - 1);
+    }
+
+    // the slot of a key with code code, which is only meaningful for built keys
+    size_type _slot(size_t code) const {
+        uint64_t mixed = _mix(code ^ _seed);
+        uint64_t position = _position(mixed, _pilot(_bucket(mixed)));
+        return position < _slots.size() ? position : _remap[position - _slots.size()];
+    }
+
+    /*
+        Places every key with the current seed, or returns false if a bucket
+        ran out of pilots. Fills pilots and positions.
+    */
+    bool _place(const std::vector<uint64_t> & codes, std::vector<uint64_t> & pilots, std::vector<uint64_t> & positions) {
+        size_type n = codes.size();
+
+        // keys grouped by bucket, buckets largest first
+        std::vector<uint64_t> mixed(n);
+        std::vector<size_type> order(n);
+        std::vector<size_type> bucket_sizes(_n_buckets, 0);
+        for(size_type i = 0; i < n; i++) {
+            mixed[i] = _mix(codes[i] ^ _seed);
+            bucket_sizes[_bucket(mixed[i])]++;
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](size_type a, size_type b) {
+            uint64_t bucket_a = _bucket(mixed[a]), bucket_b = _bucket(mixed[b]);
+            if(bucket_sizes[bucket_a] != bucket_sizes[bucket_b]) {
+                return bucket_sizes[bucket_a] > bucket_sizes[bucket_b];
+            }
+            return bucket_a < bucket_b;
+        });
+
+        std::vector<bool> taken(_table_size, false);
+        std::vector<uint64_t> tried;
+        pilots.assign(_n_buckets, 0);
+        for(size_type first = 0; first < n;) {
+            uint64_t bucket = _bucket(mixed[order[first]]);
+            size_type last = first + bucket_sizes[bucket];
+
+            uint64_t pilot = 0;
+            for(; pilot < MAX_PILOT; pilot++) {
+                tried.clear();
+                bool fits = true;
+                for(size_type k = first; k < last && fits; k++) {
+                    uint64_t position = _position(mixed[order[k]], pilot);
+                    fits = !taken[position] && std::find(tried.begin(), tried.end(), position) == tried.end();
+                    tried.push_back(position);
+                }
+                if(fits) {
+                    break;
+                }
+            }
+            if(pilot == MAX_PILOT) {
+                return false;
+            }
+            pilots[bucket] = pilot;
+            for(size_type k = first; k < last; k++) {
+                positions[order[k]] = tried[k - first];
+                taken[tried[k - first]] = true;
+            }
+            first = last;
+        }
+        return true;
+    }
+
+    void _pack_pilots(const std::vector<uint64_t> & pilots) {
+        uint64_t max = 0;
+        for(uint64_t pilot : pilots) {
+            max = std::max(max, pilot);
+        }
+        _pilot_bits = 0;
+        while(max >> _pilot_bits) {
+            _pilot_bits++;
+        }
+        _pilots.assign((pilots.size() * _pilot_bits + 63) / 64 + 1, 0);
+        for(size_type bucket = 0; bucket < pilots.size() && _pilot_bits; bucket++) {
+            size_type bit = bucket * _pilot_bits;
+            _pilots[bit / 64] |= pilots[bucket] << (bit % 64);
+            if(bit % 64 + _pilot_bits > 64) {
+                _pilots[bit / 64 + 1] |= pilots[bucket] >> (64 - bit % 64);
+            }
+        }
+    }
+
+    public:
+
+    explicit PerfectHashMap(const Hash & hash = Hash { }, const Pred & equal = Pred { }) : _hash(hash), _equal(equal) { }
+
+    /*
+        Replaces the contents with the pairs in [first, last), whose keys
+        must be distinct. Returns false, leaving the map empty, if two keys
+        share a hash code (in particular if a key repeats) or no placement
+        was found within MAX_SEEDS seeds.
+    */
+    template <typename InputIt>
+    bool build(InputIt first, InputIt last) {
+        std::vector<value_type> pairs;
+        for(; first != last; ++first) {
+            pairs.emplace_back(first->first, first->second);
+        }
+        clear();
+
+        size_type n = pairs.size();
+        std::vector<uint64_t> codes(n);
+        for(size_type i = 0; i < n; i++) {
+            codes[i] = _hash(pairs[i].first);
+        }
+        std::vector<uint64_t> sorted = codes;
+        std::sort(sorted.begin(), sorted.end());
+        if(std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+            return false;
+        }
+        if(n == 0) {
+            return true;
+        }
+
+        _n_buckets = std::max<size_type>(1, (n + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET);
+        _table_size = std::max(n, static_cast<size_type>(n / LOAD_FACTOR));
+        std::vector<uint64_t> pilots;
+        std::vector<uint64_t> positions(n);
+        bool placed = false;
+        for(size_type attempt = 0; attempt < MAX_SEEDS && !placed; attempt++) {
+            _seed = _mix(attempt + 1);
+            placed = _place(codes, pilots, positions);
+        }
+        if(!placed) {
+            clear();
+            return false;
+        }
+        _pack_pilots(pilots);
+
+        // slots past n are remapped, in order, to the slots below n no key took
+        std::vector<bool> taken(_table_size, false);
+        for(uint64_t position : positions) {
+            taken[position] = true;
+        }
+        _remap.assign(_table_size - n, 0);
+        size_type free = 0;
+        for(size_type position = n; position < _table_size; position++) {
+            if(taken[position]) {
+                while(taken[free]) {
+                    free++;
+                }
+                _remap[position - n] = static_cast<uint32_t>(free++);
+            }
+        }
+
+        std::vector<size_type> slot_of(n);
+        for(size_type i = 0; i < n; i++) {
+            slot_of[i] = positions[i] < n ? positions[i] : _remap[positions[i] - n];
+        }
+        // every slot gets exactly one pair, so build the array in slot order
+        std::vector<size_type> at_slot(n);
+        for(size_type i = 0; i < n; i++) {
+            at_slot[slot_of[i]] = i;
+        }
+        _slots.reserve(n);
+        for(size_type slot = 0; slot < n; slot++) {
+            _slots.push_back(std::move(pairs[at_slot[slot]]));
+        }
+        return true;
+    }
+
+    void clear() {
+        _seed = 0;
+        _n_buckets = 0;
+        _table_size = 0;
+        _pilots.clear();
+        _pilot_bits = 0;
+        _remap.clear();
+        _slots.clear();
+    }
+
+    size_type size() const noexcept { return _slots.size(); }
+    bool empty() const noexcept { return _slots.empty(); }
+
+    // the slot in [0, size()) of a key that was built; any slot for other keys
+    size_type index(const Key & key) const { return _slot(_hash(key)); }
+
+    // the value mapped to key, or nullptr
+    const T * find(const Key & key) const {
+        if(_slots.empty()) {
+            return nullptr;
+        }
+        const value_type & slot = _slots[_slot(_hash(key))];
+        return _equal(slot.first, key) ? &slot.second : nullptr;
+    }
+
+    bool contains(const Key & key) const { return find(key) != nullptr; }
+
+    // the bits the hash function itself takes per key, pilots and remap array
+    double bits_per_key() const {
+        if(_slots.empty()) {
+            return 0;
+        }
+        size_type bits = _n_buckets * _pilot_bits + 32 * _remap.size() + 64;
+        return static_cast<double>(bits) / _slots.size();
+    }
+
+    // the pairs in slot order
+    typename std::vector<value_type>::const_iterator begin() const { return _slots.cbegin(); }
+    typename std::vector<value_type>::const_iterator end() const { return _slots.cend(); }
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>     // size_t, std::max_align_t
+#include <memory>      // std::shared_ptr, std::make_shared
+#include <new>         // operator new, operator delete
+#include <type_traits> // std::true_type
+
+/*
+    Memory behind PoolAllocator: single objects are carved out of large
+    slabs, and freed ones go onto a free list for their size class, from
+    which the next allocation of that size is served. Slabs are only given
+    back when the arena is destroyed.
+
+    Size classes are multiples of alignof(std::max_align_t) up to
+    MAX_POOLED_SIZE bytes; anything larger bypasses the arena. Slabs start
+    at MIN_SLAB_SIZE bytes and double up to MAX_SLAB_SIZE, so filling a map
+    with n nodes takes O(log n) calls to operator new and not n.
+
+    Not thread safe.
+*/
+class PoolArena {
+    public:
+
+    static constexpr size_t ALIGN = alignof(std::max_align_t);
+    static constexpr size_t MAX_POOLED_SIZE = 256;
+    static constexpr size_t MIN_SLAB_SIZE = 4096;
+    static constexpr size_t MAX_SLAB_SIZE = 1 << 20;
+
+    private:
+
+    // a freed block, and the header of each slab
+    struct Link {
+        Link * next;
+    };
+
+    static constexpr size_t N_CLASSES = MAX_POOLED_SIZE / ALIGN;
+
+    Link * _free[N_CLASSES] = { };
+    Link * _slabs = nullptr;
+    char * _cursor = nullptr;
+    char * _slab_end = nullptr;
+    size_t _next_slab_size = MIN_SLAB_SIZE;
+    size_t _n_slabs = 0;
+
+    static size_t _class(size_t bytes) { return bytes ? (bytes - 1) / ALIGN : 0; }
+
+    void _new_slab(size_t at_least) {
+        size_t size = _next_slab_size;
+        while(size < at_least + ALIGN) {
+            size *= 2;
+        }
+        char * slab = static_cast<char *>(::operator new(size));
+        // the slab's first ALIGN bytes link it to the previous one
+        _slabs = new (slab) Link { _slabs };
+        _cursor = slab + ALIGN;
+        _slab_end = slab + size;
+        _next_slab_size = size < MAX_SLAB_SIZE ? 2 * size : size;
+        _n_slabs++;
+    }
+
+    public:
+
+    PoolArena() = default;
+    PoolArena(const PoolArena &) = delete;
+    PoolArena & operator=(const PoolArena &) = delete;
+
+    ~PoolArena() {
+        while(_slabs) {
+            Link * next = _slabs->next;
+            ::operator delete(_slabs);
+            _slabs = next;
+        }
+    }
+
+    // whether an object of this size and alignment comes from the slabs
+    static bool pooled(size_t bytes, size_t align) { return bytes <= MAX_POOLED_SIZE && align <= ALIGN; }
+
+    void * allocate(size_t bytes) {
+        Link *& free = _free[_class(bytes)];
+        if(free) {
+            Link * block = free;
+            free = block->next;
+            return block;
+        }
+        size_t size = (_class(bytes) + 1) * ALIGN;
+        if(static_cast<size_t>(_slab_end - _cursor) < size) {
+            _new_slab(size);
+        }
+        void * block = _cursor;
+        _cursor += size;
+        return block;
+    }
+
+    void deallocate(void * p, size_t bytes) {
+        Link *& free = _free[_class(bytes)];
+        free = new (p) Link { free };
+    }
+
+    size_t n_slabs() const { return _n_slabs; }
+};
+
+/*
+    Allocator whose single-object allocations come from a shared PoolArena,
+    for node-based containers such as UnorderedMap:
+
+        UnorderedMap<K, V, Hash, Pred, PoolAllocator<std::pair<const K, V>>> map(n);
+
+    Copies and rebound copies share the arena, and compare equal exactly when
+    they do. Arrays, such as a map's buckets, still come from operator new.
+    The arena lives until the last allocator using it is destroyed.
+*/
+template <typename T>
+class PoolAllocator {
+    template <typename U>
+    friend class PoolAllocator;
+
+    std::shared_ptr<PoolArena> _arena;
+
+    public:
+
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    PoolAllocator() : _arena(std::make_shared<PoolArena>()) { }
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> & other) noexcept : _arena(other._arena) { }
+
+    T * allocate(size_t n) {
+        if(n == 1 && PoolArena::pooled(sizeof(T), alignof(T))) {
+            return static_cast<T *>(_arena->allocate(sizeof(T)));
+        }
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T * p, size_t n) {
+        if(n == 1 && PoolArena::pooled(sizeof(T), alignof(T))) {
+            _arena->deallocate(p, sizeof(T));
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    const PoolArena & arena() const { return *_arena; }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U> & other) const noexcept { return _arena == other._arena; }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U> & other) const noexcept { return _arena != other._arena; }
+};
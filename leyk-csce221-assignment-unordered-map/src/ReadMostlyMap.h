@@ -0,0 +1,443 @@
+#pragma once
+
+#include <atomic>      // std::atomic
+#include <cstddef>     // size_t
+#include <cstdint>     // uint64_t
+#include <functional>  // std::hash, std::equal_to
+#include <limits>      // std::numeric_limits
+#include <mutex>       // std::mutex, std::lock_guard
+#include <optional>    // std::optional
+#include <utility>     // std::move
+#include <vector>      // std::vector
+
+#include "hash_traits.h"
+
+/*
+    Hash map for tables that are read constantly and written rarely.
+
+    Readers never lock and never write to shared memory other than their
+    own reader record. They look up keys in an immutable snapshot reached
+    through one atomic pointer. Writers serialize on a mutex, apply a batch
+    of updates to a copy of the current snapshot and publish the copy with
+    a single exchange.
+
+    A snapshot is an array of bucket chains. A new snapshot starts as a
+    copy of that array, so every bucket a batch leaves alone is shared with
+    the previous snapshot and only the buckets it touches are rebuilt. A
+    chain is freed when the last snapshot holding it is.
+
+    Old snapshots are reclaimed by epoch. Every reader has a record in
+    which it publishes the global epoch for as long as it is reading.
+    Publishing a snapshot retires the old one at the current epoch and
+    advances the epoch. A retired snapshot is freed once no reader is still
+    in an epoch at or before the one it was retired in, as only those
+    readers can have loaded it.
+
+    Reads go through a Reader, a per-thread handle that owns one record:
+
+        ReadMostlyMap<std::string, Route> routes;
+        auto reader = routes.reader();
+        std::optional<Route> route = reader.find("/index");
+
+    A Reader must not be shared between threads, and all readers must be
+    gone before the map is destroyed.
+*/
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename Pred = std::equal_to<Key>>
+class ReadMostlyMap {
+    public:
+
+    using key_type = Key;
+    using mapped_type = T;
+    using size_type = size_t;
+    using hasher = Hash;
+    using key_equal = Pred;
+
+    private:
+
+    static constexpr uint64_t IDLE = std::numeric_limits<uint64_t>::max();
+
+    struct Entry {
+        size_type code;
+        Key key;
+        T value;
+    };
+
+    // a bucket's elements; immutable once a published snapshot refers to it
+    struct Chain {
+        size_type refs = 1; // snapshots holding the chain, only touched by writers
+        std::vector<Entry> entries;
+    };
+
+    struct Snapshot {
+        prime_buckets range_hash;
+        std::vector<Chain *> buckets;
+        size_type size = 0;
+
+        // set when the snapshot is retired
+        uint64_t retired_epoch = 0;
+        Snapshot * next_retired = nullptr;
+
+        explicit Snapshot(size_type bucket_count)
+            : range_hash(bucket_count), buckets(range_hash.bucket_count(), nullptr) { }
+
+        // shares every chain of other
+        Snapshot(const Snapshot & other) : range_hash(other.range_hash), buckets(other.buckets), size(other.size) {
+            for(Chain * chain : buckets) {
+                if(chain) {
+                    chain->refs++;
+                }
+            }
+        }
+
+        const Entry * find(size_type code, const Key & key, const Pred & equal) const {
+            const Chain * chain = buckets[range_hash(code)];
+            if(chain == nullptr) {
+                return nullptr;
+            }
+            for(const Entry & entry : chain->entries) {
+                if(entry.code == code && equal(entry.key, key)) {
+                    return &entry;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    struct alignas(64) ReaderRecord {
+        std::atomic<uint64_t> epoch { IDLE };
+        std::atomic<bool> in_use { true };
+        ReaderRecord * next = nullptr;
+    };
+
+    Hash _hash;
+    Pred _equal;
+    std::atomic<Snapshot *> _current;
+    std::atomic<uint64_t> _epoch { 0 };
+    std::atomic<ReaderRecord *> _readers { nullptr };
+
+    // everything below is guarded by _write_lock
+    std::mutex _write_lock;
+    Snapshot * _retired = nullptr;
+    size_type _n_retired = 0;
+
+    static void _release(Chain * chain) {
+        if(chain && --chain->refs == 0) {
+            delete chain;
+        }
+    }
+
+    static void _delete_snapshot(Snapshot * snapshot) {
+        for(Chain * chain : snapshot->buckets) {
+            _release(chain);
+        }
+        delete snapshot;
+    }
+
+    ReaderRecord * _acquire_record() {
+        for(ReaderRecord * record = _readers.load(std::memory_order_acquire); record; record = record->next) {
+            bool free = false;
+            if(!record->in_use.load(std::memory_order_relaxed)
+                && record->in_use.compare_exchange_strong(free, true, std::memory_order_acquire)) {
+                return record;
+            }
+        }
+        // records are never unlinked, so pushing one is a plain lock-free push
+        ReaderRecord * record = new ReaderRecord;
+        record->next = _readers.load(std::memory_order_relaxed);
+        while(!_readers.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed)) { }
+        return record;
+    }
+
+    // the oldest epoch a reader is still in, or IDLE if nobody is reading
+    uint64_t _min_reader_epoch() const {
+        uint64_t min = IDLE;
+        for(ReaderRecord * record = _readers.load(std::memory_order_acquire); record; record = record->next) {
+            uint64_t epoch = record->epoch.load();
+            if(epoch < min) {
+                min = epoch;
+            }
+        }
+        return min;
+    }
+
+    // frees the retired snapshots no reader can still see, caller holds _write_lock
+    void _reclaim() {
+        uint64_t min = _min_reader_epoch();
+        Snapshot ** link = &_retired;
+        while(*link) {
+            Snapshot * snapshot = *link;
+            if(snapshot->retired_epoch < min) {
+                *link = snapshot->next_retired;
+                _delete_snapshot(snapshot);
+                _n_retired--;
+            } else {
+                link = &snapshot->next_retired;
+            }
+        }
+    }
+
+    // caller holds _write_lock
+    void _publish(Snapshot * snapshot) {
+        Snapshot * old = _current.exchange(snapshot);
+        // a reader that sees the new epoch loads the pointer after the exchange above
+        old->retired_epoch = _epoch.fetch_add(1);
+        old->next_retired = _retired;
+        _retired = old;
+        _n_retired++;
+        _reclaim();
+    }
+
+    public:
+
+    /*
+        Updates applied to the next snapshot, handed to the function passed
+        to update. Reads through a Batch see its own earlier writes.
+    */
+    class Batch {
+        friend class ReadMostlyMap;
+
+        ReadMostlyMap & _map;
+        // the snapshot being written, until _take hands it over for publishing
+        Snapshot * _next;
+
+        Batch(ReadMostlyMap & map, const Snapshot & current) : _map(map), _next(new Snapshot(current)) { }
+
+        Snapshot * _take() {
+            Snapshot * next = _next;
+            _next = nullptr;
+            return next;
+        }
+
+        // the chain for bucket, copied first if an older snapshot also holds it
+        Chain & _own(size_type bucket) {
+            Chain *& chain = _next->buckets[bucket];
+            if(chain == nullptr) {
+                chain = new Chain;
+            } else if(chain->refs > 1) {
+                Chain * copy = new Chain { 1, chain->entries };
+                chain->refs--;
+                chain = copy;
+            }
+            return *chain;
+        }
+
+        // moves every entry into a snapshot with room for the new size
+        void _grow() {
+            if(_next->size <= _next->buckets.size()) {
+                return;
+            }
+            Snapshot * grown = new Snapshot(2 * _next->size);
+            for(Chain * chain : _next->buckets) {
+                if(chain == nullptr) {
+                    continue;
+                }
+                for(const Entry & entry : chain->entries) {
+                    Chain *& dst = grown->buckets[grown->range_hash(entry.code)];
+                    if(dst == nullptr) {
+                        dst = new Chain;
+                    }
+                    dst->entries.push_back(entry);
+                }
+            }
+            grown->size = _next->size;
+            _delete_snapshot(_next);
+            _next = grown;
+        }
+
+        public:
+
+        Batch(const Batch &) = delete;
+        Batch & operator=(const Batch &) = delete;
+
+        // a batch left unpublished, because the update threw, gives its chains back
+        ~Batch() {
+            if(_next) {
+                _delete_snapshot(_next);
+            }
+        }
+
+        const T * find(const Key & key) const {
+            const Entry * entry = _next->find(_map._hash(key), key, _map._equal);
+            return entry ? &entry->value : nullptr;
+        }
+
+        // returns true if a new element was inserted
+        bool insert_or_assign(const Key & key, T value) {
+            size_type code = _map._hash(key);
+            Chain & chain = _own(_next->range_hash(code));
+            for(Entry & entry : chain.entries) {
+                if(entry.code == code && _map._equal(entry.key, key)) {
+                    entry.value = std::move(value);
+                    return false;
+                }
+            }
+            chain.entries.push_back(Entry { code, key, std::move(value) });
+            _next->size++;
+            return true;
+        }
+
+        size_type erase(const Key & key) {
+            size_type code = _map._hash(key);
+            size_type bucket = _next->range_hash(code);
+            if(_next->find(code, key, _map._equal) == nullptr) {
+                // leaves a shared chain shared
+                return 0;
+            }
+            Chain & chain = _own(bucket);
+            for(auto it = chain.entries.begin(); it != chain.entries.end(); ++it) {
+                if(it->code == code && _map._equal(it->key, key)) {
+                    chain.entries.erase(it);
+                    break;
+                }
+            }
+            if(chain.entries.empty()) {
+                _release(&chain);
+                _next->buckets[bucket] = nullptr;
+            }
+            _next->size--;
+            return 1;
+        }
+
+        size_type size() const { return _next->size; }
+    };
+
+    /*
+        A thread's handle for lock-free reads. Each read pins the current
+        epoch in the handle's record for as long as it touches the snapshot.
+    */
+    class Reader {
+        friend class ReadMostlyMap;
+
+        const ReadMostlyMap * _map;
+        ReaderRecord * _record;
+
+        explicit Reader(ReadMostlyMap & map) : _map(&map), _record(map._acquire_record()) { }
+
+        const Snapshot & _pin() const {
+            _record->epoch.store(_map->_epoch.load());
+            return *_map->_current.load();
+        }
+
+        void _unpin() const { _record->epoch.store(IDLE, std::memory_order_release); }
+
+        public:
+
+        Reader(Reader && other) noexcept : _map(other._map), _record(other._record) { other._record = nullptr; }
+        Reader(const Reader &) = delete;
+        Reader & operator=(const Reader &) = delete;
+        Reader & operator=(Reader &&) = delete;
+
+        ~Reader() {
+            if(_record) {
+                _record->in_use.store(false, std::memory_order_release);
+            }
+        }
+
+        // returns a copy of the value mapped to key in the current snapshot, or nothing
+        std::optional<T> find(const Key & key) const {
+            size_type code = _map->_hash(key);
+            const Snapshot & snapshot = _pin();
+            const Entry * entry = snapshot.find(code, key, _map->_equal);
+            std::optional<T> value;
+            if(entry) {
+                value = entry->value;
+            }
+            _unpin();
+            return value;
+        }
+
+        bool contains(const Key & key) const {
+            size_type code = _map->_hash(key);
+            bool found = _pin().find(code, key, _map->_equal) != nullptr;
+            _unpin();
+            return found;
+        }
+
+        // calls f(key, value) for every element of one snapshot; f must not write to the map
+        template <typename F>
+        void for_each(F && f) const {
+            const Snapshot & snapshot = _pin();
+            for(const Chain * chain : snapshot.buckets) {
+                if(chain == nullptr) {
+                    continue;
+                }
+                for(const Entry & entry : chain->entries) {
+                    f(entry.key, entry.value);
+                }
+            }
+            _unpin();
+        }
+
+        size_type size() const {
+            size_type n = _pin().size;
+            _unpin();
+            return n;
+        }
+    };
+
+    explicit ReadMostlyMap(size_type bucket_count = 0, const Hash & hash = Hash { }, const Pred & equal = Pred { })
+        : _hash(hash), _equal(equal), _current(new Snapshot(bucket_count)) { }
+
+    ReadMostlyMap(const ReadMostlyMap &) = delete;
+    ReadMostlyMap & operator=(const ReadMostlyMap &) = delete;
+
+    ~ReadMostlyMap() {
+        _delete_snapshot(_current.load());
+        while(_retired) {
+            Snapshot * next = _retired->next_retired;
+            _delete_snapshot(_retired);
+            _retired = next;
+        }
+        ReaderRecord * record = _readers.load();
+        while(record) {
+            ReaderRecord * next = record->next;
+            delete record;
+            record = next;
+        }
+    }
+
+    Reader reader() { return Reader(*this); }
+
+    /*
+        Calls f(batch) and publishes the result as one snapshot, so readers
+        see either none or all of the batch. Writers are serialized. If f
+        throws, nothing is published and the batch is discarded.
+    */
+    template <typename F>
+    void update(F && f) {
+        std::lock_guard<std::mutex> guard(_write_lock);
+        Batch batch(*this, *_current.load());
+        f(batch);
+        batch._grow();
+        _publish(batch._take());
+    }
+
+    bool insert_or_assign(const Key & key, T value) {
+        bool inserted = false;
+        update([&](Batch & batch) { inserted = batch.insert_or_assign(key, std::move(value)); });
+        return inserted;
+    }
+
+    size_type erase(const Key & key) {
+        size_type n = 0;
+        update([&](Batch & batch) { n = batch.erase(key); });
+        return n;
+    }
+
+    // frees what retired snapshots no reader still holds
+    void reclaim() {
+        std::lock_guard<std::mutex> guard(_write_lock);
+        _reclaim();
+    }
+
+    // snapshots waiting for readers to move on
+    size_type retired_count() {
+        std::lock_guard<std::mutex> guard(_write_lock);
+        return _n_retired;
+    }
+
+    size_type bucket_count() {
+        std::lock_guard<std::mutex> guard(_write_lock);
+        return _current.load()->buckets.size();
+    }
+};
@@ -0,0 +1,500 @@
+#pragma once
+
+#include <algorithm>  // std::max
+#include <cmath>      // std::ceil
+#include <cstddef>    // size_t
+#include <cstdint>    // uint32_t
+#include <functional> // std::hash, std::equal_to
+#include <iterator>   // std::forward_iterator_tag
+#include <memory>     // std::allocator
+#include <new>        // placement new
+#include <utility>    // std::pair, std::move
+#include <vector>
+
+#include "hash_traits.h"
+
+/*
+    Open-addressing hash map using Robin Hood linear probing.
+
+    Each occupied slot records its probe distance: how far the element sits
+    from its home bucket, hash % bucket_count(). An insert walks forward from
+    the home bucket and takes the first slot whose element is closer to its
+    own home than the new one would be, shifting the rest of the run one slot
+    right. This keeps every run ordered by home bucket, which bounds the
+    variance of probe lengths and lets a failed lookup stop as soon as it
+    meets an element closer to home than the key it is looking for. Erase
+    shifts the run after the hole one slot left instead of leaving a
+    tombstone, so lookups never slow down after many erasures.
+
+    Runs never wrap around: the slot array extends a few slots past the last
+    bucket and that tail grows when a run near the end reaches it. Because of
+    this, erasing while iterating visits every remaining element exactly once.
+
+    The interface follows UnorderedMap, except that elements move when other
+    elements are inserted or erased, so only indices into the table (and no
+    pointers or references) are stable, and there are no local iterators.
+
+    Since elements move so often, slots hold std::pair<Key, T>, whose key
+    can be moved from, and iterators view them as value_type, the pair
+    with a const key, which has the same layout.
+*/
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename Pred = std::equal_to<Key>>
+class RobinHoodMap {
+    public:
+
+    using key_type = Key;
+    using mapped_type = T;
+    using hasher = Hash;
+    using key_equal = Pred;
+    using value_type = std::pair<const key_type, mapped_type>;
+    using reference = value_type &;
+    using const_reference = const value_type &;
+    using pointer = value_type *;
+    using const_pointer = const value_type *;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    private:
+
+    // probe distance plus one, so zero marks an empty slot
+    using dist_t = uint32_t;
+    // what a slot really holds, so shifting and rehashing move keys rather than copy them
+    using slot_type = std::pair<key_type, mapped_type>;
+    static_assert(sizeof(slot_type) == sizeof(value_type) && alignof(slot_type) == alignof(value_type));
+
+    static constexpr size_type MIN_TAIL = 8;
+    static constexpr size_type NPOS = static_cast<size_type>(-1);
+
+    slot_type * _slots;
+    dist_t * _dist;
+    size_type _bucket_count;
+    size_type _slot_count; // _bucket_count plus the overflow tail
+    size_type _size;
+
+    Hash _hash;
+    key_equal _equal;
+    float _max_load_factor;
+    // hash % bucket_count without a division
+    prime_buckets _range_hash;
+    std::allocator<slot_type> _alloc;
+
+    size_type _home(const Key & key) const { return _range_hash(_hash(key)); }
+
+    // slot pos as the element the iterators hand out
+    value_type * _value(size_type pos) const { return reinterpret_cast<value_type *>(_slots + pos); }
+
+    void _allocate(size_type bucket_count, size_type slot_count) {
+        _bucket_count = bucket_count;
+        _slot_count = slot_count;
+        if(slot_count == 0) {
+            _slots = nullptr;
+            _dist = nullptr;
+            return;
+        }
+        _slots = _alloc.allocate(slot_count);
+        _dist = new dist_t[slot_count] { };
+    }
+
+    void _destroy_all() {
+        for(size_type i = 0; i < _slot_count; i++) {
+            if(_dist[i]) {
+                _slots[i].~slot_type();
+            }
+        }
+    }
+
+    void _deallocate() {
+        if(_slot_count == 0) {
+            return;
+        }
+        _alloc.deallocate(_slots, _slot_count);
+        delete[] _dist;
+    }
+
+    // moves slot from into the empty slot to
+    void _move_slot(size_type from, size_type to) {
+        new (_slots + to) slot_type(std::move(_slots[from]));
+        _slots[from].~slot_type();
+    }
+
+    // index of the slot holding key, or NPOS
+    size_type _find_index(const Key & key) const {
+        if(_size == 0) {
+            return NPOS;
+        }
+        // past the first slot whose element is closer to home than d, key can't be
+        size_type i = _home(key);
+        for(dist_t d = 1; i < _slot_count && _dist[i] >= d; i++, d++) {
+            if(_dist[i] == d && _equal(_slots[i].first, key)) {
+                return i;
+            }
+        }
+        return NPOS;
+    }
+
+    // reallocates the slots with a tail twice as long, keeping every element's index
+    void _grow_tail() {
+        slot_type * old_slots = _slots;
+        dist_t * old_dist = _dist;
+        size_type old_slot_count = _slot_count;
+        size_type tail = std::max(MIN_TAIL, 2 * (_slot_count - _bucket_count));
+
+        _allocate(_bucket_count, _bucket_count + tail);
+        for(size_type i = 0; i < old_slot_count; i++) {
+            if(old_dist[i]) {
+                new (_slots + i) slot_type(std::move(old_slots[i]));
+                old_slots[i].~slot_type();
+                _dist[i] = old_dist[i];
+            }
+        }
+        _alloc.deallocate(old_slots, old_slot_count);
+        delete[] old_dist;
+    }
+
+    /*
+    Places an element whose key is absent, built by make(slot), into home's
+    run and returns its index. Everything from its slot up to the next empty
+    one shifts one slot right.
+    */
+    template <typename Make>
+    size_type _place(size_type home, Make make) {
+        size_type pos = home;
+        dist_t d = 1;
+        while(pos < _slot_count && _dist[pos] >= d) {
+            pos++;
+            d++;
+        }
+        size_type empty = pos;
+        while(empty < _slot_count && _dist[empty]) {
+            empty++;
+        }
+        while(empty == _slot_count) {
+            _grow_tail();
+        }
+        for(size_type j = empty; j > pos; j--) {
+            _move_slot(j - 1, j);
+            _dist[j] = _dist[j - 1] + 1;
+        }
+        make(_slots + pos);
+        _dist[pos] = d;
+        _size++;
+        return pos;
+    }
+
+    // empties slot pos and shifts the rest of its run one slot left
+    void _erase_index(size_type pos) {
+        _slots[pos].~slot_type();
+        size_type next = pos + 1;
+        while(next < _slot_count && _dist[next] > 1) {
+            _move_slot(next, pos);
+            _dist[pos] = _dist[next] - 1;
+            pos = next++;
+        }
+        _dist[pos] = 0;
+        _size--;
+    }
+
+    size_type _buckets_for(size_type n) const {
+        return static_cast<size_type>(std::ceil(static_cast<float>(n) / _max_load_factor));
+    }
+
+    // moves every element into a fresh table of next_greater_prime(count) buckets
+    void _rehash(size_type count) {
+        slot_type * old_slots = _slots;
+        dist_t * old_dist = _dist;
+        size_type old_slot_count = _slot_count;
+        size_type size = _size;
+
+        _range_hash = prime_buckets(count);
+        size_type bucket_count = _range_hash.bucket_count();
+        _allocate(bucket_count, bucket_count + MIN_TAIL);
+        _size = 0;
+        for(size_type i = 0; i < old_slot_count; i++) {
+            if(old_dist[i]) {
+                _place(_home(old_slots[i].first), [&](slot_type * slot) { new (slot) slot_type(std::move(old_slots[i])); });
+                old_slots[i].~slot_type();
+            }
+        }
+        _size = size;
+
+        if(old_slot_count) {
+            _alloc.deallocate(old_slots, old_slot_count);
+            delete[] old_dist;
+        }
+    }
+
+    void _reserve_for_insert() {
+        if(static_cast<float>(_size + 1) > static_cast<float>(_bucket_count) * _max_load_factor) {
+            _rehash(std::max(2 * _bucket_count, _buckets_for(_size + 1)));
+        }
+    }
+
+    // shared by insert and operator[]: finds key, or places an element built by make()
+    template <typename Make>
+    std::pair<size_type, bool> _find_or_insert(const Key & key, Make make) {
+        size_type pos = _find_index(key);
+        if(pos != NPOS) {
+            return { pos, false };
+        }
+        _reserve_for_insert();
+        return { _place(_home(key), make), true };
+    }
+
+    void _copy_from(const RobinHoodMap & other) {
+        _allocate(other._bucket_count, other._slot_count);
+        for(size_type i = 0; i < _slot_count; i++) {
+            if(other._dist[i]) {
+                new (_slots + i) slot_type(other._slots[i]);
+                _dist[i] = other._dist[i];
+            }
+        }
+        _size = other._size;
+    }
+
+    void _steal(RobinHoodMap & other) noexcept {
+        _slots = other._slots;
+        _dist = other._dist;
+        _bucket_count = other._bucket_count;
+        _slot_count = other._slot_count;
+        _size = other._size;
+        other._allocate(0, 0);
+        other._size = 0;
+    }
+
+    public:
+
+    template <typename pointer_type, typename reference_type, typename _value_type>
+    class basic_iterator {
+        public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = _value_type;
+        using difference_type = ptrdiff_t;
+        using pointer = value_type *;
+        using reference = value_type &;
+
+        private:
+        friend class RobinHoodMap;
+
+        const dist_t * _dist;
+        const dist_t * _end;
+        value_type * _slot;
+
+        basic_iterator(const dist_t * dist, const dist_t * end, value_type * slot) noexcept
+            : _dist(dist), _end(end), _slot(slot) { }
+
+        void _skip_empty() {
+            while(_dist != _end && *_dist == 0) {
+                _dist++;
+                _slot++;
+            }
+        }
+
+        public:
+        basic_iterator() : _dist(nullptr), _end(nullptr), _slot(nullptr) { }
+
+        operator basic_iterator<const_pointer, const_reference, const typename RobinHoodMap::value_type>() const {
+            return { _dist, _end, _slot };
+        }
+
+        reference operator*() const { return *_slot; }
+        pointer operator->() const { return _slot; }
+
+        basic_iterator & operator++() {
+            _dist++;
+            _slot++;
+            _skip_empty();
+            return *this;
+        }
+        basic_iterator operator++(int) {
+            basic_iterator copy = *this;
+            ++(*this);
+            return copy;
+        }
+
+        bool operator==(const basic_iterator & other) const noexcept { return _dist == other._dist; }
+        bool operator!=(const basic_iterator & other) const noexcept { return _dist != other._dist; }
+    };
+
+    using iterator = basic_iterator<pointer, reference, value_type>;
+    using const_iterator = basic_iterator<const_pointer, const_reference, const value_type>;
+
+    private:
+
+    // iterator to the first element at or after slot pos
+    iterator _iterator_from(size_type pos) const {
+        iterator it(_dist + pos, _dist + _slot_count, _value(pos));
+        it._skip_empty();
+        return it;
+    }
+
+    public:
+
+    explicit RobinHoodMap(size_type bucket_count, const Hash & hash = Hash { },
+                const key_equal & equal = key_equal { })
+        : _size(0), _hash(hash), _equal(equal), _max_load_factor(0.9f), _range_hash(bucket_count)
+    {
+        _allocate(_range_hash.bucket_count(), _range_hash.bucket_count() + MIN_TAIL);
+    }
+
+    RobinHoodMap(const RobinHoodMap & other)
+        : _hash(other._hash), _equal(other._equal), _max_load_factor(other._max_load_factor),
+          _range_hash(other._range_hash)
+    {
+        _copy_from(other);
+    }
+
+    // other is left empty with no buckets; inserting into it allocates again
+    RobinHoodMap(RobinHoodMap && other) noexcept
+        : _hash(other._hash), _equal(other._equal), _max_load_factor(other._max_load_factor),
+          _range_hash(other._range_hash)
+    {
+        _steal(other);
+    }
+
+    ~RobinHoodMap() {
+        _destroy_all();
+        _deallocate();
+    }
+
+    RobinHoodMap & operator=(const RobinHoodMap & other) {
+        if(this != &other) {
+            _destroy_all();
+            _deallocate();
+            _hash = other._hash;
+            _equal = other._equal;
+            _max_load_factor = other._max_load_factor;
+            _range_hash = other._range_hash;
+            _copy_from(other);
+        }
+        return *this;
+    }
+
+    RobinHoodMap & operator=(RobinHoodMap && other) noexcept {
+        if(this != &other) {
+            _destroy_all();
+            _deallocate();
+            _hash = std::move(other._hash);
+            _equal = std::move(other._equal);
+            _max_load_factor = other._max_load_factor;
+            _range_hash = other._range_hash;
+            _steal(other);
+        }
+        return *this;
+    }
+
+    void clear() noexcept {
+        for(size_type i = 0; i < _slot_count; i++) {
+            if(_dist[i]) {
+                _slots[i].~slot_type();
+                _dist[i] = 0;
+            }
+        }
+        _size = 0;
+    }
+
+    size_type size() const noexcept { return _size; }
+    bool empty() const noexcept { return _size == 0; }
+    size_type bucket_count() const noexcept { return _bucket_count; }
+
+    float load_factor() const { return _bucket_count ? static_cast<float>(_size) / _bucket_count : 0.0f; }
+
+    /*
+     The load factor an insert may not exceed before the map grows to the next
+     prime bucket count. Defaults to 0.9; ml must be positive and below 1.
+    */
+    float max_load_factor() const { return _max_load_factor; }
+    void max_load_factor(float ml) {
+        _max_load_factor = ml;
+        if(load_factor() > _max_load_factor) {
+            _rehash(_buckets_for(_size));
+        }
+    }
+
+    // sets the bucket count to next_greater_prime(count), but never below what size() needs
+    void rehash(size_type count) { _rehash(std::max(count, _buckets_for(_size))); }
+
+    void reserve(size_type count) {
+        if(static_cast<float>(count) > static_cast<float>(_bucket_count) * _max_load_factor) {
+            _rehash(_buckets_for(count));
+        }
+    }
+
+    // the home bucket of key; bucket_count() must be nonzero
+    size_type bucket(const Key & key) const { return _home(key); }
+
+    // number of elements whose home is bucket n, found by walking its run
+    size_type bucket_size(size_type n) const {
+        size_type count = 0;
+        size_type i = n;
+        for(dist_t d = 1; i < _slot_count && _dist[i] >= d; i++, d++) {
+            count += _dist[i] == d;
+        }
+        return count;
+    }
+
+    /*
+     Returns h where h[k] is the number of elements sitting k slots past their
+     home bucket, so a successful find for them inspects k + 1 slots.
+    */
+    std::vector<size_type> probe_histogram() const {
+        std::vector<size_type> histogram;
+        for(size_type i = 0; i < _slot_count; i++) {
+            if(_dist[i]) {
+                if(_dist[i] > histogram.size()) {
+                    histogram.resize(_dist[i]);
+                }
+                histogram[_dist[i] - 1]++;
+            }
+        }
+        return histogram;
+    }
+
+    iterator begin() { return _iterator_from(0); }
+    iterator end() { return iterator(_dist + _slot_count, _dist + _slot_count, _value(_slot_count)); }
+    const_iterator begin() const { return const_cast<RobinHoodMap *>(this)->begin(); }
+    const_iterator end() const { return const_cast<RobinHoodMap *>(this)->end(); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    iterator find(const Key & key) {
+        size_type pos = _find_index(key);
+        return pos == NPOS ? end() : iterator(_dist + pos, _dist + _slot_count, _value(pos));
+    }
+    const_iterator find(const Key & key) const { return const_cast<RobinHoodMap *>(this)->find(key); }
+
+    bool contains(const Key & key) const { return _find_index(key) != NPOS; }
+
+    /*
+    Inserts value unless its key is present. Returns an iterator to the element
+    with that key and whether the insertion took place.
+    */
+    std::pair<iterator, bool> insert(const value_type & value) {
+        auto [pos, inserted] = _find_or_insert(value.first, [&](slot_type * slot) { new (slot) slot_type(value); });
+        return { iterator(_dist + pos, _dist + _slot_count, _value(pos)), inserted };
+    }
+    std::pair<iterator, bool> insert(value_type && value) {
+        auto [pos, inserted] = _find_or_insert(value.first, [&](slot_type * slot) { new (slot) slot_type(std::move(value)); });
+        return { iterator(_dist + pos, _dist + _slot_count, _value(pos)), inserted };
+    }
+
+    T & operator[](const Key & key) {
+        auto result = _find_or_insert(key, [&](slot_type * slot) { new (slot) slot_type(key, T()); });
+        return _slots[result.first].second;
+    }
+
+    // the elements after pos shift into its slot, so the next one is found from there
+    iterator erase(iterator pos) {
+        size_type index = static_cast<size_type>(pos._dist - _dist);
+        _erase_index(index);
+        return _iterator_from(index);
+    }
+
+    size_type erase(const Key & key) {
+        size_type pos = _find_index(key);
+        if(pos == NPOS) {
+            return 0;
+        }
+        _erase_index(pos);
+        return 1;
+    }
+};
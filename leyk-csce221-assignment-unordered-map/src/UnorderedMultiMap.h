@@ -0,0 +1,31 @@
+#pragma once
+
+#include <functional> // std::hash, std::equal_to
+#include <memory>     // std::allocator
+#include <utility>    // std::pair
+
+#include "HashTable.h"
+
+/*
+    Maps keys to any number of values, on UnorderedMap's bucket engine,
+    HashTable.h. Inserting always succeeds; an element whose key is already
+    present goes right in front of the first element with that key, so the
+    elements sharing a key are always adjacent in the chain, through
+    rehashes too, and equal_range hands them over as one range. count and
+    erase(key) walk that same run.
+
+    There is no operator[] or try_emplace, as a key picks no single value.
+*/
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename Pred = std::equal_to<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>, typename BucketPolicy = prime_buckets,
+          typename Stats = no_stats>
+class UnorderedMultiMap : public HashTable<Key, std::pair<const Key, T>, select_first, false, Hash, Pred, Allocator, BucketPolicy, Stats> {
+    using _base = HashTable<Key, std::pair<const Key, T>, select_first, false, Hash, Pred, Allocator, BucketPolicy, Stats>;
+
+    public:
+
+    using mapped_type = T;
+    using const_mapped_type = const T;
+
+    using _base::_base;
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <functional> // std::hash, std::equal_to
+#include <memory>     // std::allocator
+
+#include "HashTable.h"
+
+/*
+    A set of unique keys on UnorderedMap's bucket engine, HashTable.h. Its
+    nodes hold the key alone, with no mapped value alongside, and its
+    iterators only give const access, since changing a key in place would
+    leave it in the wrong bucket.
+
+    Allocator, BucketPolicy and the rest behave as for UnorderedMap.
+*/
+template <typename Key, typename Hash = std::hash<Key>, typename Pred = std::equal_to<Key>,
+          typename Allocator = std::allocator<Key>, typename BucketPolicy = prime_buckets,
+          typename Stats = no_stats>
+class UnorderedSet : public HashTable<Key, Key, identity_key, true, Hash, Pred, Allocator, BucketPolicy, Stats> {
+    using _base = HashTable<Key, Key, identity_key, true, Hash, Pred, Allocator, BucketPolicy, Stats>;
+
+    public:
+
+    using _base::_base;
+};
@@ -2,6 +2,8 @@
 
 #include <string>
 
+#include "hash_traits.h"
+
 struct polynomial_rolling_hash {
     size_t operator() (std::string const & str) const;
 };
@@ -9,3 +11,10 @@ struct polynomial_rolling_hash {
 struct fnv1a_hash {
     size_t operator() (std::string const & str) const;
 };
+
+// both walk the whole string, so UnorderedMap keeps the codes they produce
+template <>
+struct cache_hash_code<polynomial_rolling_hash> : std::true_type { };
+
+template <>
+struct cache_hash_code<fnv1a_hash> : std::true_type { };
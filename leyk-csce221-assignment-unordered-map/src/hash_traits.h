@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>     // size_t
+#include <cstdint>     // uint64_t
+#include <functional>  // std::hash
+#include <string>
+#include <string_view>
+#include <type_traits> // std::true_type, std::false_type, std::enable_if_t, std::void_t
+
+#include "primes.h"
+
+/*
+    Per-hasher tuning for UnorderedMap.
+
+    cache_hash_code<Hash> decides whether every node stores its key's hash
+    code. A cached code costs one size_t per node and pays off when hashing
+    the key is expensive: lookups compare codes before calling the equality
+    predicate, and erase, rehash and bucket walks read the code instead of
+    hashing again. Specialize it as std::true_type for a hasher to opt in.
+*/
+template <typename Hash>
+struct cache_hash_code : std::false_type { };
+
+// strings are hashed character by character, so keep their codes
+template <>
+struct cache_hash_code<std::hash<std::string>> : std::true_type { };
+
+/*
+    is_transparent<T> detects the is_transparent member that marks a hasher
+    or equality predicate as accepting any type comparable with the key. When
+    both of a map's are transparent, find, contains and erase take those
+    types directly instead of converting them to Key first.
+*/
+template <typename T, typename = void>
+struct is_transparent : std::false_type { };
+
+template <typename T>
+struct is_transparent<T, std::void_t<typename T::is_transparent>> : std::true_type { };
+
+// K, when lookups may use it as a key; otherwise a substitution failure
+template <typename Hash, typename Pred, typename K>
+using enable_if_transparent_t = std::enable_if_t<is_transparent<Hash>::value && is_transparent<Pred>::value, K>;
+
+/*
+    std::hash<std::string> made transparent. A std::string, a string_view and
+    a string literal with the same characters get the same code, so a map
+    with string_hash and std::equal_to<> can look up any of them without
+    building a std::string.
+*/
+struct string_hash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view str) const { return std::hash<std::string_view> {}(str); }
+};
+
+template <>
+struct cache_hash_code<string_hash> : std::true_type { };
+
+/*
+    Bucket policies decide which bucket counts a map may have and which
+    bucket a hash code falls in. A policy is constructed for one bucket
+    count, the one bucket_count_for(n) picks for a request of n buckets,
+    and its call operator maps any hash code to [0, bucket_count()).
+*/
+
+// prime bucket counts, reduced with the fastmod constant stored next to each prime
+class prime_buckets {
+    prime_modulus _modulus;
+
+    public:
+
+    explicit prime_buckets(size_t bucket_count) : _modulus(next_greater_prime_modulus(bucket_count)) { }
+
+    static size_t bucket_count_for(size_t n) { return next_greater_prime(n); }
+
+    size_t bucket_count() const { return _modulus.prime; }
+
+    size_t operator()(size_t code) const { return _modulus.reduce(code); }
+};
+
+/*
+    Power-of-two bucket counts, reduced with a mask. A mask keeps only the
+    low bits of the code, which for weak hashes (std::hash of an integer is
+    the integer) are far from uniform, so codes go through the MurmurHash3
+    finalizer first.
+*/
+class power_of_two_buckets {
+    size_t _mask;
+
+    public:
+
+    explicit power_of_two_buckets(size_t bucket_count) : _mask(bucket_count_for(bucket_count) - 1) { }
+
+    static size_t bucket_count_for(size_t n) {
+        size_t count = 1;
+        while(count < n) {
+            count *= 2;
+        }
+        return count;
+    }
+
+    static size_t mix(size_t code) {
+        uint64_t h = code;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+
+    size_t bucket_count() const { return _mask + 1; }
+
+    size_t operator()(size_t code) const { return mix(code) & _mask; }
+};
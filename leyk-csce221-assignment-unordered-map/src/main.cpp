@@ -1,8 +1,8 @@
 #include "UnorderedMap.h"
+#include "RobinHoodMap.h"
 #include "hash_functions.h"
 
 #include <random>
-#include <limits>
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
@@ -12,6 +12,7 @@
 
 constexpr size_t MAX_TERMINAL_WIDTH = 80;
 constexpr size_t N_ELEMENTS = 1e4;
+constexpr size_t MAX_HISTOGRAM_ROWS = 16;
 
 static void print_sep() {
     std::cout << std::endl;
@@ -20,6 +21,31 @@ static void print_sep() {
     std::cout << std::endl << std::endl;
 }
 
+// one bar per probe distance; the last row gathers everything at or beyond it
+static void print_histogram(std::vector<size_t> histogram) {
+    if(histogram.size() > MAX_HISTOGRAM_ROWS) {
+        for(size_t k = MAX_HISTOGRAM_ROWS; k < histogram.size(); k++)
+            histogram[MAX_HISTOGRAM_ROWS - 1] += histogram[k];
+        histogram.resize(MAX_HISTOGRAM_ROWS);
+    }
+
+    size_t max_count = 1;
+    for(size_t count : histogram)
+        max_count = std::max(max_count, count);
+
+    for(size_t k = 0; k < histogram.size(); k++) {
+        std::cout << std::setw(4) << k << (k + 1 == MAX_HISTOGRAM_ROWS ? "+" : " ") << ": ";
+
+        size_t width = (MAX_TERMINAL_WIDTH - 20) *
+            (static_cast<float>(histogram[k]) / static_cast<float>(max_count));
+
+        for(size_t i = 0; i < width; i++)
+            std::cout << "#";
+
+        std::cout << " " << histogram[k] << std::endl;
+    }
+}
+
 struct zero_hash {
     size_t operator() (std::string const & str) const {
         return 0;
@@ -71,6 +97,10 @@ struct hash_selector {
     }
 };
 
+// every choice hashes a whole string, so have the map keep the codes
+template <>
+struct cache_hash_code<hash_selector> : std::true_type { };
+
 HashType prompt_hash_type() {
     using std::cin, std::cout, std::endl, std::ios;
 
@@ -184,29 +214,16 @@ int main() {
         std::cout << animal << ": " << hash(animal) << std::endl;
     }
 
-    UnorderedMap<std::string, int, hash_selector> map(30, hash);
+    // counts lookups and rehashes too, for the stats printed below
+    UnorderedMap<std::string, int, hash_selector, std::equal_to<std::string>,
+                 std::allocator<std::pair<const std::string, int>>, prime_buckets, counted_stats> map(30, hash);
 
     for(size_t i = 0; i < N_ELEMENTS; i++) {
         map.insert({distribution(generator), 0});
     }
 
-    std::vector<size_t> bucket_sizes(map.bucket_count());
-    size_t max_count = std::numeric_limits<size_t>::min();
-    for(size_t bucket = 0; bucket < map.bucket_count(); bucket++) {
-        bucket_sizes[bucket] = map.bucket_size(bucket);
-        max_count = std::max(max_count, bucket_sizes[bucket]);
-    }
-
-    double load_variance = std::numeric_limits<double>::max();
-    if(map.size() > 1) {
-        load_variance = 0;
-        double res;
-        for(size_t i = 0; i < map.bucket_count(); i++) {
-            res = bucket_sizes[i] - map.load_factor();
-            load_variance += res * res;
-        }
-        load_variance /= map.size() - 1;
-    }
+    map_stats stats = map.stats();
+    size_t max_count = std::max<size_t>(stats.max_chain, 1);
 
     print_sep();
 
@@ -214,7 +231,7 @@ int main() {
         std::cout << std::setw(5) << bucket << ": ";
         
         size_t width = MAX_TERMINAL_WIDTH * 
-            (static_cast<float>(bucket_sizes[bucket]) / static_cast<float>(max_count));
+            (static_cast<float>(map.bucket_size(bucket)) / static_cast<float>(max_count));
     
         for(size_t i = 0; i < width; i++) {
             std::cout << "#";
@@ -225,10 +242,39 @@ int main() {
 
     print_sep();
 
-    std::cout << "  Size: " << map.size() << std::endl;
-    std::cout << "  Buckets: " << map.bucket_count() << std::endl;
-    std::cout << "  Load factor: " << map.load_factor() << std::endl;
-    std::cout << "  Load variance: " << load_variance << std::endl;
+    std::cout << "  Size: " << stats.size << std::endl;
+    std::cout << "  Buckets: " << stats.bucket_count << std::endl;
+    std::cout << "  Load factor: " << stats.load_factor << std::endl;
+    std::cout << "  Load variance: " << stats.bucket_variance << std::endl;
+    std::cout << "  Stats: " << stats.json() << std::endl;
+
+    // Letting the map grow keeps the chains short no matter how many keys arrive
+    map.max_load_factor(1.0f);
+    stats = map.stats();
+
+    print_sep();
+
+    std::cout << "  With max_load_factor(1):" << std::endl;
+    std::cout << "  Buckets: " << stats.bucket_count << std::endl;
+    std::cout << "  Load factor: " << stats.load_factor << std::endl;
+    std::cout << "  Longest chain: " << stats.max_chain << std::endl;
+    std::cout << "  Hash quality: " << stats.hash_quality << std::endl;
+
+    // The same keys under open addressing, at the Robin Hood default of 0.9
+    RobinHoodMap<std::string, int, hash_selector> robin_hood(30, hash);
+    for(auto const & pair : map)
+        robin_hood.insert(pair);
+
+    print_sep();
+
+    std::cout << "  Probe distances, chaining with max_load_factor(1):" << std::endl << std::endl;
+    print_histogram(stats.probe_histogram);
+
+    std::cout << std::endl;
+    std::cout << "  Probe distances, Robin Hood with max_load_factor(" << robin_hood.max_load_factor() << "):" << std::endl;
+    std::cout << "  Buckets: " << robin_hood.bucket_count() << std::endl;
+    std::cout << "  Load factor: " << robin_hood.load_factor() << std::endl << std::endl;
+    print_histogram(robin_hood.probe_histogram());
 
     return 0;
 }
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <atomic>   // std::atomic
+#include <chrono>   // std::chrono::steady_clock
+#include <cstddef>  // size_t
+#include <cstdint>  // uint64_t
+#include <ostream>  // std::ostream
+#include <sstream>  // std::ostringstream
+#include <string>   // std::string
+#include <vector>   // std::vector
+
+/*
+    What UnorderedMap::stats reports. The shape of the table is measured
+    when stats is called. The counters are only kept by maps whose Stats
+    parameter is counted_stats, since updating them costs every lookup a
+    few instructions:
+
+        UnorderedMap<Key, T, Hash, Pred, Allocator, prime_buckets, counted_stats> map;
+
+    With the default, no_stats, counted is false and they read zero.
+*/
+struct map_stats {
+    size_t size = 0;
+    size_t bucket_count = 0;
+    double load_factor = 0;
+
+    // over every bucket, including those an incremental rehash has yet to move
+    size_t empty_buckets = 0;
+    double empty_bucket_ratio = 0;
+    size_t max_chain = 0;
+    // of the chain lengths, empty buckets included
+    double bucket_variance = 0;
+    // over the buckets that are not empty
+    double mean_chain = 0;
+    double chain_variance = 0;
+    // probe_histogram[k] keys sit behind k others in their chain, so finding them looks at k + 1 nodes
+    std::vector<size_t> probe_histogram;
+
+    /*
+        The nodes looking up every key once looks at, over what a uniformly
+        random hash would make it look at on average: about 1 for a good
+        hash, approaching bucket_count when every key shares one bucket.
+    */
+    double hash_quality = 1;
+
+    bool counted = false;
+    // keys probed for, by lookups, inserts and erasures alike
+    uint64_t lookups = 0;
+    // nodes looked at while probing
+    uint64_t comparisons = 0;
+    double comparisons_per_lookup = 0;
+    uint64_t rehashes = 0;
+    double rehash_seconds = 0;
+
+    // writes the stats as one JSON object
+    void write_json(std::ostream & os) const {
+        os << "{\"size\": " << size
+           << ", \"bucket_count\": " << bucket_count
+           << ", \"load_factor\": " << load_factor
+           << ", \"empty_buckets\": " << empty_buckets
+           << ", \"empty_bucket_ratio\": " << empty_bucket_ratio
+           << ", \"max_chain\": " << max_chain
+           << ", \"bucket_variance\": " << bucket_variance
+           << ", \"mean_chain\": " << mean_chain
+           << ", \"chain_variance\": " << chain_variance
+           << ", \"probe_histogram\": [";
+        for(size_t k = 0; k < probe_histogram.size(); k++) {
+            os << (k ? ", " : "") << probe_histogram[k];
+        }
+        os << "]"
+           << ", \"hash_quality\": " << hash_quality
+           << ", \"counted\": " << (counted ? "true" : "false")
+           << ", \"lookups\": " << lookups
+           << ", \"comparisons\": " << comparisons
+           << ", \"comparisons_per_lookup\": " << comparisons_per_lookup
+           << ", \"rehashes\": " << rehashes
+           << ", \"rehash_seconds\": " << rehash_seconds
+           << "}";
+    }
+
+    std::string json() const {
+        std::ostringstream os;
+        write_json(os);
+        return os.str();
+    }
+};
+
+/*
+    The Stats parameter of the maps: the hooks the table calls as it looks
+    keys up and rehashes, and what they add to map_stats. The type decides
+    both the map's layout and what the hooks compile to, so translation
+    units can never disagree on them.
+
+    no_stats, the default, keeps nothing and takes no space beyond padding.
+*/
+struct no_stats {
+    static constexpr bool counted = false;
+
+    void lookup() noexcept { }
+    void comparison() noexcept { }
+    void rehash() noexcept { }
+
+    // times nothing
+    class timer {
+        public:
+
+        explicit timer(no_stats &) noexcept { }
+    };
+
+    void report(map_stats &) const noexcept { }
+    void reset() noexcept { }
+};
+
+/*
+    Counts what the map has done since it was built or its stats were
+    reset. Lookups run from const members, possibly on several threads at
+    once under a shared lock, so their counters are atomic and bumped with
+    relaxed increments. Rehashes only happen in members that change the
+    map, which callers already serialize.
+*/
+class counted_stats {
+    std::atomic<uint64_t> _lookups { 0 };
+    std::atomic<uint64_t> _comparisons { 0 };
+    uint64_t _rehashes = 0;
+    double _rehash_seconds = 0;
+
+    public:
+
+    static constexpr bool counted = true;
+
+    void lookup() noexcept { _lookups.fetch_add(1, std::memory_order_relaxed); }
+    void comparison() noexcept { _comparisons.fetch_add(1, std::memory_order_relaxed); }
+    void rehash() noexcept { _rehashes++; }
+
+    // adds the time from its construction to its destruction to the rehash time
+    class timer {
+        double & _seconds;
+        std::chrono::steady_clock::time_point _start;
+
+        public:
+
+        explicit timer(counted_stats & stats) : _seconds(stats._rehash_seconds), _start(std::chrono::steady_clock::now()) { }
+        timer(const timer &) = delete;
+        timer & operator=(const timer &) = delete;
+        ~timer() { _seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count(); }
+    };
+
+    void report(map_stats & stats) const noexcept {
+        stats.counted = true;
+        stats.lookups = _lookups.load(std::memory_order_relaxed);
+        stats.comparisons = _comparisons.load(std::memory_order_relaxed);
+        if(stats.lookups) {
+            stats.comparisons_per_lookup = static_cast<double>(stats.comparisons) / stats.lookups;
+        }
+        stats.rehashes = _rehashes;
+        stats.rehash_seconds = _rehash_seconds;
+    }
+
+    void reset() noexcept {
+        _lookups.store(0, std::memory_order_relaxed);
+        _comparisons.store(0, std::memory_order_relaxed);
+        _rehashes = 0;
+        _rehash_seconds = 0;
+    }
+};
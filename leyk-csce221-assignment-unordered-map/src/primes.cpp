@@ -1,7 +1,10 @@
 #include <cstddef>
 #include <algorithm>
+#include <array>
 
-static const size_t _map_primes[] = {
+#include "primes.h"
+
+static constexpr size_t _map_primes[] = {
 	2ul,
 	3ul,
 	5ul,
@@ -303,9 +306,26 @@ static const size_t _map_primes[] = {
     #endif
 };
 
-static const size_t _n_map_primes = sizeof(_map_primes) / sizeof(*_map_primes);
+static constexpr size_t _n_map_primes = sizeof(_map_primes) / sizeof(*_map_primes);
+
+// fastmod constants for every prime above, computed at compile time
+static constexpr std::array<prime_modulus, _n_map_primes> _map_moduli = [] {
+	std::array<prime_modulus, _n_map_primes> moduli {};
+	for(size_t i = 0; i < _n_map_primes; i++) {
+		moduli[i].prime = _map_primes[i];
+#if defined(__SIZEOF_INT128__)
+		moduli[i].inverse = ~fastmod_uint128(0) / _map_primes[i] + 1;
+#endif
+	}
+	return moduli;
+}();
 
 size_t next_greater_prime(size_t sz) {
 	size_t const *p = std::lower_bound(_map_primes, _map_primes + _n_map_primes, sz);
 	return *p;
+}
+
+prime_modulus const & next_greater_prime_modulus(size_t sz) {
+	size_t const *p = std::lower_bound(_map_primes, _map_primes + _n_map_primes, sz);
+	return _map_moduli[p - _map_primes];
 }
\ No newline at end of file
@@ -1,5 +1,53 @@
 #pragma once
 
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t, UINT32_MAX, UINT64_MAX
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 fastmod_uint128;
+#endif
+
+// the high 64 bits of the 128-bit product a * b, from 32-bit halves where there are no 128-bit integers
+inline uint64_t mulhi64(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    return static_cast<uint64_t>((fastmod_uint128(a) * b) >> 64);
+#else
+    uint64_t a_low = a & UINT32_MAX, a_high = a >> 32;
+    uint64_t b_low = b & UINT32_MAX, b_high = b >> 32;
+    uint64_t high_low = a_high * b_low;
+    // cannot overflow: at most three 32-bit values' worth of carries into 64 bits
+    uint64_t middle = ((a_low * b_low) >> 32) + (high_low & UINT32_MAX) + a_low * b_high;
+    return a_high * b_high + (high_low >> 32) + (middle >> 32);
+#endif
+}
+
+/*
+    A prime from the lookup table together with the constant that reduces
+    numbers modulo it without a hardware division.
+
+    The reduction is Lemire, Kaser and Kurz's fastmod: multiplying code by
+    inverse = ceil(2^128 / prime) leaves the fractional part of code / prime
+    in the low 128 bits, and multiplying that by prime brings the remainder
+    into the top 64. Three multiplications instead of a 64-bit division,
+    which costs tens of cycles. Without 128-bit integers it falls back to %.
+*/
+struct prime_modulus {
+    size_t prime;
+#if defined(__SIZEOF_INT128__)
+    fastmod_uint128 inverse;
+
+    // code % prime
+    size_t reduce(size_t code) const {
+        fastmod_uint128 fraction = inverse * code;
+        fastmod_uint128 low = ((fraction & UINT64_MAX) * prime) >> 64;
+        fastmod_uint128 high = (fraction >> 64) * prime;
+        return static_cast<size_t>((low + high) >> 64);
+    }
+#else
+    size_t reduce(size_t code) const { return code % prime; }
+#endif
+};
+
 /*
     Retrieves the next prime > size via a lookup table.
 
@@ -8,4 +56,7 @@
 
     Practically very fast.
 */
-size_t next_greater_prime(size_t size);
\ No newline at end of file
+size_t next_greater_prime(size_t size);
+
+// the table entry behind next_greater_prime(size), with its fastmod constant
+prime_modulus const & next_greater_prime_modulus(size_t size);
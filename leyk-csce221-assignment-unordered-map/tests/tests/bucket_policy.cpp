@@ -0,0 +1,85 @@
+#include "executable.h"
+
+#include <unordered_map>
+
+TEST(bucket_policy) {
+    Typegen t;
+
+    // fastmod agrees with % for every prime bucket count and any code
+    for(size_t bucket_count = 1; bucket_count < (1ull << 40); bucket_count = bucket_count * 3 / 2 + 1) {
+        prime_buckets range_hash(bucket_count);
+        size_t prime = next_greater_prime(bucket_count);
+        ASSERT_EQ(prime, prime_buckets::bucket_count_for(bucket_count));
+        ASSERT_EQ(prime, range_hash.bucket_count());
+        for(size_t i = 0; i < TEST_ITER; i++) {
+            size_t code = t.get<size_t>();
+            size_t expected = code % prime;
+            ASSERT_EQ(expected, range_hash(code));
+        }
+        size_t top = SIZE_MAX % prime;
+        ASSERT_EQ(top, range_hash(SIZE_MAX));
+        ASSERT_EQ(0ULL, range_hash(prime));
+        ASSERT_EQ(1ULL, range_hash(prime + 1));
+    }
+
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        using Map = UnorderedMap<int, int, std::hash<int>, std::equal_to<int>,
+                                 std::allocator<std::pair<const int, int>>, power_of_two_buckets>;
+
+        size_t n = t.range(100ull);
+        size_t n_ops = t.range(2000ul);
+        Map map(n);
+        std::unordered_map<int, int> gt;
+
+        // the smallest power of two no less than n
+        size_t bucket_count = map.bucket_count();
+        ASSERT_EQ(0ULL, bucket_count & (bucket_count - 1));
+        ASSERT_LE(n, bucket_count);
+        ASSERT_LT(bucket_count / 2, std::max<size_t>(n, 1));
+
+        if(t.get<bool>()) {
+            map.max_load_factor(t.range(0.5f, 2.0f));
+        }
+
+        for(size_t op = 0; op < n_ops; op++) {
+            int key = t.range(-500, 500);
+            if(t.get<bool>(0.6)) {
+                ASSERT_EQ(gt.insert({ key, key }).second, map.insert({ key, key }).second);
+            } else {
+                ASSERT_EQ(gt.erase(key), map.erase(key));
+            }
+            ASSERT_EQ(gt.size(), map.size());
+        }
+
+        // keys sit in the bucket the mixed code masks to, and rehash keeps powers of two
+        map.rehash(t.range(3000ull));
+        bucket_count = map.bucket_count();
+        ASSERT_EQ(0ULL, bucket_count & (bucket_count - 1));
+        size_t n_local = 0;
+        for(size_t bucket = 0; bucket < bucket_count; bucket++) {
+            for(auto it = map.begin(bucket); it != map.end(bucket); ++it) {
+                size_t expected = power_of_two_buckets::mix(std::hash<int> {}(it->first)) & (bucket_count - 1);
+                ASSERT_EQ(expected, bucket);
+                n_local++;
+            }
+        }
+        ASSERT_EQ(gt.size(), n_local);
+
+        // consecutive integers spread out instead of filling consecutive buckets
+        Map sequential(1024);
+        for(int key = 0; key < 1024; key++) {
+            sequential.insert({ key * 1024, key });
+        }
+        size_t longest = 0;
+        for(size_t bucket = 0; bucket < sequential.bucket_count(); bucket++) {
+            longest = std::max(longest, sequential.bucket_size(bucket));
+        }
+        ASSERT_LT(longest, 16ULL);
+
+        for(auto const & pair : gt) {
+            auto it = map.find(pair.first);
+            ASSERT_TRUE(it != map.end());
+            ASSERT_EQ(pair.second, it->second);
+        }
+    }
+}
@@ -0,0 +1,201 @@
+#include "executable.h"
+
+#include "PoolAllocator.h"
+
+#include <new>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+// counts its copies, so building can be checked to copy each pair once, into its node
+struct copy_counted {
+    static size_t n_copies;
+    int value = 0;
+
+    copy_counted() = default;
+    explicit copy_counted(int v) : value(v) { }
+    copy_counted(const copy_counted & other) : value(other.value) { n_copies++; }
+    copy_counted & operator=(const copy_counted & other) {
+        value = other.value;
+        n_copies++;
+        return *this;
+    }
+};
+size_t copy_counted::n_copies = 0;
+
+// what a limited_allocator may still hand out, and how many of its blocks are live
+struct allocation_budget {
+    size_t n_left = 0;
+    size_t n_live = 0;
+};
+
+// throws once its budget runs out; not always equal, so build_parallel allocates on the calling thread
+template <typename T>
+struct limited_allocator {
+    using value_type = T;
+    using is_always_equal = std::false_type;
+
+    allocation_budget * budget;
+
+    explicit limited_allocator(allocation_budget * b) : budget(b) { }
+    template <typename U>
+    limited_allocator(const limited_allocator<U> & other) : budget(other.budget) { }
+
+    T * allocate(size_t n) {
+        if(budget->n_left == 0) {
+            throw std::bad_alloc();
+        }
+        budget->n_left--;
+        budget->n_live++;
+        return std::allocator<T> { }.allocate(n);
+    }
+    void deallocate(T * p, size_t n) {
+        budget->n_live--;
+        std::allocator<T> { }.deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const limited_allocator<U> & other) const { return budget == other.budget; }
+    template <typename U>
+    bool operator!=(const limited_allocator<U> & other) const { return budget != other.budget; }
+};
+
+TEST(build_parallel) {
+    Typegen t;
+
+    // The same map inserting the pairs in order gives, whatever the thread count
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        size_t n_pairs = t.range(5000ul);
+        int n_keys = static_cast<int>(t.range(1ul, 2 * n_pairs + 2));
+        std::vector<std::pair<int, int>> pairs(n_pairs);
+        for(auto & pair : pairs) {
+            pair = { t.range(0, n_keys), t.get<int>() };
+        }
+        size_t n_threads = t.range(1ul, 9ul);
+        bool keep_last = t.get<bool>();
+
+        using Map = UnorderedMap<int, int>;
+        Map map = Map::build_parallel(pairs.begin(), pairs.end(), n_threads,
+                                      keep_last ? Map::duplicate_policy::keep_last : Map::duplicate_policy::keep_first);
+
+        std::unordered_map<int, int> gt;
+        for(auto const & pair : pairs) {
+            if(keep_last) {
+                gt[pair.first] = pair.second;
+            } else {
+                gt.insert(pair);
+            }
+        }
+        ASSERT_EQ(gt.size(), map.size());
+        ASSERT_LE(n_pairs, map.bucket_count());
+        for(auto const & pair : gt) {
+            auto it = map.find(pair.first);
+            ASSERT_TRUE(it != map.end());
+            ASSERT_EQ(pair.second, it->second);
+        }
+
+        // every node is on the chain once, in its own bucket
+        size_t n_iterated = 0;
+        for(auto it = map.begin(); it != map.end(); ++it) {
+            n_iterated++;
+        }
+        ASSERT_EQ(map.size(), n_iterated);
+        size_t n_in_buckets = 0;
+        size_t n_misplaced = 0;
+        for(size_t bucket = 0; bucket < map.bucket_count(); bucket++) {
+            for(auto it = map.begin(bucket); it != map.end(bucket); ++it) {
+                n_in_buckets++;
+                n_misplaced += map.bucket(it->first) != bucket;
+            }
+        }
+        ASSERT_EQ(map.size(), n_in_buckets);
+        ASSERT_EQ(0ULL, n_misplaced);
+
+        // and the map goes on as any other
+        for(int k = 0; k < 100; k++) {
+            int key = t.range(0, 2 * n_keys);
+            if(t.get<bool>()) {
+                ASSERT_EQ(gt.insert({ key, k }).second, map.insert({ key, k }).second);
+            } else {
+                ASSERT_EQ(gt.erase(key), map.erase(key));
+            }
+        }
+        ASSERT_EQ(gt.size(), map.size());
+        for(auto const & pair : gt) {
+            ASSERT_EQ(pair.second, map.find(pair.first)->second);
+        }
+    }
+
+    // Cached hash codes, and an allocator that is not always equal, whose nodes come from the calling thread
+    for(size_t i = 0; i < 10; i++) {
+        using Allocator = PoolAllocator<std::pair<const std::string, size_t>>;
+        using Map = UnorderedMap<std::string, size_t, fnv1a_hash, std::equal_to<std::string>, Allocator>;
+
+        size_t n_pairs = t.range(20000ul);
+        std::vector<std::pair<std::string, size_t>> pairs(n_pairs);
+        for(size_t k = 0; k < n_pairs; k++) {
+            pairs[k] = { std::to_string(t.range(n_pairs + 1)), k };
+        }
+        Map map = Map::build_parallel(pairs.begin(), pairs.end(), t.range(1ul, 9ul), Map::duplicate_policy::keep_last);
+
+        std::unordered_map<std::string, size_t> gt;
+        for(auto const & pair : pairs) {
+            gt[pair.first] = pair.second;
+        }
+        ASSERT_EQ(gt.size(), map.size());
+        for(auto const & pair : gt) {
+            auto it = map.find(pair.first);
+            ASSERT_TRUE(it != map.end());
+            ASSERT_EQ(pair.second, it->second);
+        }
+        map.max_load_factor(1);
+        for(size_t k = 0; k < 1000; k++) {
+            map.insert({ "new" + std::to_string(k), k });
+        }
+        ASSERT_EQ(gt.size() + 1000, map.size());
+    }
+
+    // Keys are read from the input in place, so each pair is copied once, into its node
+    {
+        std::vector<std::pair<int, copy_counted>> pairs;
+        for(int k = 0; k < 1000; k++) {
+            pairs.emplace_back(k, copy_counted(k));
+        }
+        copy_counted::n_copies = 0;
+        auto map = UnorderedMap<int, copy_counted>::build_parallel(pairs.begin(), pairs.end(), 4);
+        ASSERT_EQ(1000ULL, map.size());
+        ASSERT_EQ(1000ULL, copy_counted::n_copies);
+    }
+
+    // Running out of memory while preallocating nodes frees those already allocated
+    {
+        using Allocator = limited_allocator<std::pair<const int, int>>;
+        using Map = UnorderedMap<int, int, std::hash<int>, std::equal_to<int>, Allocator>;
+
+        std::vector<std::pair<int, int>> pairs;
+        for(int k = 0; k < 1000; k++) {
+            pairs.emplace_back(k, k);
+        }
+        allocation_budget budget;
+        budget.n_left = 500;
+        bool threw = false;
+        try {
+            Map::build_parallel(pairs.begin(), pairs.end(), 2, Map::duplicate_policy::keep_first, std::hash<int> { },
+                                std::equal_to<int> { }, Allocator(&budget));
+        } catch(const std::bad_alloc &) {
+            threw = true;
+        }
+        ASSERT_TRUE(threw);
+        ASSERT_EQ(0ULL, budget.n_live);
+    }
+
+    // Nothing to build
+    {
+        std::vector<std::pair<int, int>> pairs;
+        auto map = UnorderedMap<int, int>::build_parallel(pairs.begin(), pairs.end(), 4);
+        ASSERT_TRUE(map.empty());
+        ASSERT_TRUE(map.begin() == map.end());
+        map.insert({ 1, 1 });
+        ASSERT_EQ(1, map.find(1)->second);
+    }
+}
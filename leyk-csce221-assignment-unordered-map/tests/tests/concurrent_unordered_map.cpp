@@ -0,0 +1,151 @@
+#include "executable.h"
+#include "ConcurrentUnorderedMap.h"
+
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// counts the keys it hashes
+struct counting_int_hash {
+    static size_t calls;
+
+    size_t operator()(int key) const {
+        calls++;
+        return std::hash<int> {}(key);
+    }
+};
+
+size_t counting_int_hash::calls = 0;
+
+// so walking a bucket reads the stored codes instead of hashing the nodes again
+template <>
+struct cache_hash_code<counting_int_hash> : std::true_type { };
+
+TEST(concurrent_unordered_map) {
+    Typegen t;
+
+    // The key picking the shard is hashed once, not again inside the shard
+    {
+        ConcurrentUnorderedMap<int, int, counting_int_hash> map(1024, 4);
+        auto hashes = [&](auto && op) {
+            size_t calls = counting_int_hash::calls;
+            op();
+            return counting_int_hash::calls - calls;
+        };
+        for(int key = 0; key < 100; key++) {
+            ASSERT_EQ(1ULL, hashes([&] { map.insert_or_assign(key, key); }));
+            ASSERT_EQ(1ULL, hashes([&] { map.insert_or_assign(key, -key); }));
+            ASSERT_EQ(1ULL, hashes([&] { ASSERT_EQ(-key, map.find(key).value_or(0)); }));
+            ASSERT_EQ(1ULL, hashes([&] { ASSERT_TRUE(map.contains(key)); }));
+            ASSERT_EQ(1ULL, hashes([&] { map.compute_if_absent(key + 1000, [](int k) { return k; }); }));
+            ASSERT_EQ(1ULL, hashes([&] { ASSERT_EQ(1ULL, map.erase(key)); }));
+        }
+    }
+
+    // On one thread it behaves like any other map
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        size_t n_shards = t.range(1ull, 33ull);
+        size_t n_ops = t.range(2000ul);
+        int range = static_cast<int>(t.range(10ul, 1000ul));
+
+        ConcurrentUnorderedMap<int, int> map(t.range(100ull), n_shards);
+        std::unordered_map<int, int> gt;
+        ASSERT_LE(n_shards, map.shard_count());
+        ASSERT_EQ(0ULL, map.shard_count() & (map.shard_count() - 1));
+
+        for(size_t op = 0; op < n_ops; op++) {
+            int key = t.range(-range, range);
+            int value = t.get<int>();
+            switch(t.range(0, 4)) {
+            case 0:
+                ASSERT_EQ(gt.insert_or_assign(key, value).second, map.insert_or_assign(key, value));
+                break;
+            case 1:
+                ASSERT_EQ(gt.erase(key), map.erase(key));
+                break;
+            case 2: {
+                size_t n_calls = 0;
+                int got = map.compute_if_absent(key, [&](int k) {
+                    n_calls++;
+                    return k + value;
+                });
+                ASSERT_EQ(gt.count(key) ? 0ULL : 1ULL, n_calls);
+                ASSERT_EQ(gt.insert({ key, key + value }).first->second, got);
+                break;
+            }
+            default: {
+                std::optional<int> got = map.find(key);
+                ASSERT_EQ(gt.count(key) == 1, got.has_value());
+                ASSERT_EQ(gt.count(key) == 1, map.contains(key));
+                if(got) {
+                    ASSERT_EQ(gt.at(key), *got);
+                }
+            }
+            }
+            ASSERT_EQ(gt.size(), map.size());
+        }
+
+        // for_each visits every element once
+        size_t n_visited = 0;
+        size_t n_wrong = 0;
+        map.for_each([&](int key, int value) {
+            n_visited++;
+            n_wrong += gt.count(key) == 0 || gt.at(key) != value;
+        });
+        ASSERT_EQ(gt.size(), n_visited);
+        ASSERT_EQ(0ULL, n_wrong);
+
+        map.clear();
+        ASSERT_TRUE(map.empty());
+    }
+
+    // Concurrent readers and writers never observe a torn or foreign value,
+    // and compute_if_absent makes each key exactly once
+    for(size_t i = 0; i < 4; i++) {
+        const size_t n_threads = 4;
+        const size_t n_ops = 0x4000;
+        const int n_keys = 512;
+
+        ConcurrentUnorderedMap<int, int> map(0, 8);
+        std::atomic<size_t> bad_values { 0 };
+        std::atomic<size_t> n_made { 0 };
+
+        std::vector<std::thread> threads;
+        for(size_t tid = 0; tid < n_threads; tid++) {
+            threads.emplace_back([&, tid]() {
+                Typegen tt(tid + 1);
+                for(size_t op = 0; op < n_ops; op++) {
+                    int key = tt.range(0, n_keys);
+                    if(tt.get<bool>(0.8)) {
+                        std::optional<int> value = map.find(key);
+                        if(value && *value != 7 * key) {
+                            bad_values++;
+                        }
+                    } else if(tt.get<bool>(0.5)) {
+                        int value = map.compute_if_absent(n_keys + key, [&](int k) {
+                            n_made++;
+                            return 7 * k;
+                        });
+                        if(value != 7 * (n_keys + key)) {
+                            bad_values++;
+                        }
+                    } else if(tt.get<bool>(0.9)) {
+                        map.insert_or_assign(key, 7 * key);
+                    } else {
+                        map.erase(key);
+                    }
+                }
+            });
+        }
+
+        for(std::thread & thread : threads) {
+            thread.join();
+        }
+
+        ASSERT_EQ(0ULL, bad_values.load());
+        size_t n_computed = 0;
+        map.for_each([&](int key, int) { n_computed += key >= n_keys; });
+        ASSERT_EQ(n_computed, n_made.load());
+    }
+}
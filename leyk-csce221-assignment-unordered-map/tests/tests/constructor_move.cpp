@@ -1,5 +1,14 @@
 #include "executable.h"
 
+// power-of-two bucket counts, never fewer than 64, more than the static shared empty table holds
+class wide_buckets : public power_of_two_buckets {
+    public:
+
+    explicit wide_buckets(size_t bucket_count) : power_of_two_buckets(bucket_count_for(bucket_count)) { }
+
+    static size_t bucket_count_for(size_t n) { return power_of_two_buckets::bucket_count_for(n < 64 ? 64 : n); }
+};
+
 TEST(constructor_move) {
     Typegen t;
     for(size_t i = 0; i < TEST_ITER; i++) {
@@ -29,7 +38,9 @@ TEST(constructor_move) {
             Map cpy_map { std::move(map) };
 
             ASSERT_EQ(0ULL, mh.n_frees()); // no deallocations
-            ASSERT_EQ(1ULL, mh.n_allocs()); // 1 allocation
+            ASSERT_EQ(0ULL, mh.n_allocs()); // the moved-from map shares an empty table
+            ASSERT_TRUE(map.empty());
+            ASSERT_TRUE(map.begin() == map.end());
             ASSERT_EQ(shad_map.size(), cpy_map.size());
 
             ASSERT_PAIRS_FOUND_IN_CORRECT_BUCKETS(shad_map, cpy_map);
@@ -50,7 +61,8 @@ TEST(constructor_move) {
 
             ASSERT_PAIRS_FOUND_IN_CORRECT_BUCKETS(shad_map, cpy_map);
             
-            shadow_map<double, double> moved_shad_map(n);
+            // the moved-from map starts over from the smallest table
+            shadow_map<double, double> moved_shad_map(map.bucket_count());
 
             for(auto const & pair : new_pairs) {
                 map.insert(pair);
@@ -61,4 +73,39 @@ TEST(constructor_move) {
         }
 
     }
-}
\ No newline at end of file
+
+    // Moves cannot throw, so containers of maps move them when they grow
+    static_assert(std::is_nothrow_move_constructible<UnorderedMap<double, double>>::value);
+    static_assert(std::is_nothrow_move_assignable<UnorderedMap<double, double>>::value);
+    {
+        std::vector<UnorderedMap<int, int>> maps;
+        for(int k = 0; k < 100; k++) {
+            maps.emplace_back(7);
+            maps.back().insert({ k, k });
+        }
+        for(int k = 0; k < 100; k++) {
+            ASSERT_EQ(1ULL, maps[k].size());
+            ASSERT_EQ(k, maps[k].find(k)->second);
+        }
+    }
+
+    // A policy whose smallest table outgrows the static one still moves without allocating
+    {
+        using Map = UnorderedMap<int, int, std::hash<int>, std::equal_to<int>, std::allocator<std::pair<const int, int>>, wide_buckets>;
+        static_assert(std::is_nothrow_move_constructible<Map>::value);
+
+        Map map(t.range(100ull));
+        for(int k = 0; k < 100; k++) {
+            map.insert({ k, k });
+        }
+        Memhook mh;
+        Map moved(std::move(map));
+        ASSERT_EQ(0ULL, mh.n_allocs());
+        ASSERT_EQ(64ULL, map.bucket_count());
+        ASSERT_TRUE(map.empty());
+        ASSERT_EQ(100ULL, moved.size());
+        map.insert({ 1, 1 });
+        ASSERT_EQ(1, map.find(1)->second);
+        ASSERT_EQ(1ULL, map.size());
+    }
+}
@@ -0,0 +1,202 @@
+#include "executable.h"
+
+#include "PoolAllocator.h"
+#include "hash_functions.h"
+
+#include <string>
+#include <unordered_map>
+
+TEST(extract_merge) {
+    Typegen t;
+
+    // Extracted nodes leave the map, and move to another one without allocating
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        size_t n_pairs = t.range(1000ul);
+        std::vector<std::pair<int, int>> pairs(n_pairs);
+        t.fill_unique(pairs.begin(), pairs.end());
+
+        UnorderedMap<int, int> source(t.range(1ull, 100ull));
+        UnorderedMap<int, int> target(t.range(1ull, 100ull));
+        target.max_load_factor(t.range(0.5f, 2.0f));
+        target.incremental_rehash(t.get<bool>());
+        std::unordered_map<int, int> gt_source, gt_target;
+        for(auto const & pair : pairs) {
+            source.insert(pair);
+            gt_source.insert(pair);
+        }
+
+        // room for every node up front, so no insert below reallocates the buckets
+        target.reserve(n_pairs);
+        t.shuffle(pairs.begin(), pairs.end());
+        for(auto const & pair : pairs) {
+            if(t.range(3)) {
+                continue;
+            }
+            bool by_key = t.get<bool>();
+            Memhook mh;
+            auto nh = by_key ? source.extract(pair.first) : source.extract(source.find(pair.first));
+            ASSERT_FALSE(nh.empty());
+            ASSERT_EQ(pair.first, nh.key());
+            ASSERT_EQ(pair.second, nh.mapped());
+            nh.mapped() += 1;
+
+            auto result = target.insert(std::move(nh));
+            ASSERT_TRUE(result.inserted);
+            ASSERT_TRUE(result.node.empty());
+            ASSERT_TRUE(nh.empty());
+            ASSERT_EQ(pair.first, result.position->first);
+            ASSERT_EQ(0ULL, mh.n_allocs());
+            ASSERT_EQ(0ULL, mh.n_frees());
+
+            gt_source.erase(pair.first);
+            gt_target.insert({ pair.first, pair.second + 1 });
+        }
+
+        ASSERT_EQ(gt_source.size(), source.size());
+        ASSERT_EQ(gt_target.size(), target.size());
+        for(auto const & pair : gt_source) {
+            ASSERT_EQ(pair.second, source.find(pair.first)->second);
+        }
+        for(auto const & pair : gt_target) {
+            ASSERT_FALSE(source.contains(pair.first));
+            ASSERT_EQ(pair.second, target.find(pair.first)->second);
+        }
+        size_t n_iterated = 0;
+        for(auto it = source.begin(); it != source.end(); ++it) {
+            n_iterated++;
+        }
+        ASSERT_EQ(source.size(), n_iterated);
+    }
+
+    // Missing keys give empty handles, and a present key sends the handle back
+    {
+        UnorderedMap<int, int> map(7);
+        map.insert({ 1, 10 });
+        map.insert({ 2, 20 });
+
+        auto missing = map.extract(3);
+        ASSERT_TRUE(missing.empty());
+        ASSERT_FALSE(static_cast<bool>(missing));
+        auto result = map.insert(std::move(missing));
+        ASSERT_FALSE(result.inserted);
+        ASSERT_TRUE(result.position == map.end());
+        ASSERT_EQ(2ULL, map.size());
+
+        UnorderedMap<int, int> other(7);
+        other.insert({ 1, 11 });
+        auto nh = other.extract(1);
+        result = map.insert(std::move(nh));
+        ASSERT_FALSE(result.inserted);
+        ASSERT_FALSE(result.node.empty());
+        ASSERT_EQ(11, result.node.mapped());
+        ASSERT_EQ(10, result.position->second);
+        ASSERT_EQ(2ULL, map.size());
+        ASSERT_TRUE(other.empty());
+
+        // a handle that is never inserted frees its node
+        Memhook mh;
+        map.extract(2);
+        ASSERT_EQ(1ULL, mh.n_frees());
+        ASSERT_EQ(1ULL, map.size());
+        auto first = map.extract(1);
+        result.node = std::move(first);
+        ASSERT_EQ(2ULL, mh.n_frees());
+        ASSERT_EQ(10, result.node.mapped());
+        ASSERT_TRUE(map.empty());
+        ASSERT_TRUE(map.begin() == map.end());
+    }
+
+    // merge relinks the nodes of keys the target lacks and leaves the rest in the source
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        UnorderedMap<std::string, int, fnv1a_hash> source(t.range(1ull, 100ull));
+        UnorderedMap<std::string, int, fnv1a_hash> target(t.range(1ull, 100ull));
+        source.max_load_factor(1);
+        source.incremental_rehash(t.get<bool>());
+        target.max_load_factor(1);
+        target.incremental_rehash(t.get<bool>());
+        std::unordered_map<std::string, int> gt_source, gt_target;
+
+        size_t n_pairs = t.range(1000ul);
+        for(size_t k = 0; k < n_pairs; k++) {
+            std::string key = std::to_string(t.range(2 * n_pairs + 1));
+            int value = t.get<int>();
+            if(t.get<bool>()) {
+                source.insert({ key, value });
+                gt_source.insert({ key, value });
+            } else {
+                target.insert({ key, value });
+                gt_target.insert({ key, value });
+            }
+        }
+        std::unordered_map<std::string, int> gt_left;
+        for(auto const & pair : gt_source) {
+            if(!gt_target.insert(pair).second) {
+                gt_left.insert(pair);
+            }
+        }
+        gt_source = gt_left;
+
+        // with room reserved and no rehash to finish nothing allocates or frees; otherwise the target grows as it goes
+        bool reserved = t.get<bool>();
+        if(reserved) {
+            target.reserve(target.size() + source.size());
+            target.incremental_rehash(false);
+        }
+        {
+            Memhook mh;
+            target.merge(source);
+            if(reserved) {
+                ASSERT_EQ(0ULL, mh.n_allocs());
+                ASSERT_EQ(0ULL, mh.n_frees());
+            }
+        }
+
+        ASSERT_EQ(gt_source.size(), source.size());
+        ASSERT_EQ(gt_target.size(), target.size());
+        for(auto const & pair : gt_source) {
+            auto it = source.find(pair.first);
+            ASSERT_TRUE(it != source.end());
+            ASSERT_EQ(pair.second, it->second);
+        }
+        for(auto const & pair : gt_target) {
+            auto it = target.find(pair.first);
+            ASSERT_TRUE(it != target.end());
+            ASSERT_EQ(pair.second, it->second);
+        }
+        size_t n_iterated = 0;
+        for(auto it = source.begin(); it != source.end(); ++it) {
+            n_iterated++;
+        }
+        ASSERT_EQ(source.size(), n_iterated);
+
+        target.merge(target);
+        ASSERT_EQ(gt_target.size(), target.size());
+    }
+
+    // Maps over different arenas cannot swap nodes, so merge and insert move the elements instead
+    {
+        using Allocator = PoolAllocator<std::pair<const int, int>>;
+        using Map = UnorderedMap<int, int, std::hash<int>, std::equal_to<int>, Allocator>;
+        Map source(11);
+        Map target(11);
+        for(int k = 0; k < 100; k++) {
+            source.insert({ k, k });
+        }
+        for(int k = 50; k < 150; k++) {
+            target.insert({ k, -k });
+        }
+        target.merge(source);
+        ASSERT_EQ(50ULL, source.size());
+        ASSERT_EQ(150ULL, target.size());
+        for(int k = 0; k < 150; k++) {
+            ASSERT_EQ(k < 50 ? k : -k, target.find(k)->second);
+            ASSERT_EQ(k >= 50 && k < 100, source.contains(k));
+        }
+
+        Map other(11);
+        auto result = other.insert(source.extract(60));
+        ASSERT_TRUE(result.inserted);
+        ASSERT_EQ(60, other.find(60)->second);
+        ASSERT_EQ(49ULL, source.size());
+    }
+}
@@ -0,0 +1,46 @@
+#include "executable.h"
+
+#include <vector>
+
+TEST(find_batch) {
+    Typegen t;
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        UnorderedMap<int, int> map(t.range(1ull, 200ull));
+        if(t.get<bool>()) {
+            map.max_load_factor(t.range(0.5f, 2.0f));
+        }
+        // lookups must also find keys the old table of a rehash still holds
+        map.incremental_rehash(t.get<bool>());
+
+        int range = static_cast<int>(t.range(10ul, 2000ul));
+        size_t n_pairs = t.range(2000ul);
+        for(size_t k = 0; k < n_pairs; k++) {
+            int key = t.range(-range, range);
+            map.insert({ key, t.get<int>() });
+        }
+
+        // a batch size that is rarely a multiple of the group size
+        size_t n = t.range(200ul);
+        std::vector<int> keys(n);
+        for(int & key : keys) {
+            key = t.range(-2 * range, 2 * range);
+        }
+
+        std::vector<UnorderedMap<int, int>::iterator> found(n);
+        map.find_batch(keys.data(), n, found.data());
+        for(size_t k = 0; k < n; k++) {
+            ASSERT_TRUE(map.find(keys[k]) == found[k]);
+        }
+
+        const UnorderedMap<int, int> & const_map = map;
+        std::vector<UnorderedMap<int, int>::const_iterator> const_found(n);
+        const_map.find_batch(keys.data(), n, const_found.data());
+        for(size_t k = 0; k < n; k++) {
+            auto it = const_map.find(keys[k]);
+            ASSERT_TRUE(it == const_found[k]);
+            if(it != const_map.cend()) {
+                ASSERT_EQ(found[k]->second, const_found[k]->second);
+            }
+        }
+    }
+}
@@ -0,0 +1,171 @@
+#include "executable.h"
+
+#include "FlatUnorderedMap.h"
+
+#include <unordered_map>
+
+// sends every key into the same group and gives them all the same H2
+struct constant_hash {
+    size_t operator()(int) const { return 42; }
+};
+
+// counts its copies, so growing the table can be checked to move keys
+struct copy_counted_key {
+    static size_t n_copies;
+    int value;
+
+    explicit copy_counted_key(int v) : value(v) { }
+    copy_counted_key(const copy_counted_key & other) : value(other.value) { n_copies++; }
+    copy_counted_key(copy_counted_key && other) noexcept : value(other.value) { }
+    copy_counted_key & operator=(const copy_counted_key & other) {
+        value = other.value;
+        n_copies++;
+        return *this;
+    }
+    copy_counted_key & operator=(copy_counted_key && other) noexcept {
+        value = other.value;
+        return *this;
+    }
+    bool operator==(const copy_counted_key & other) const { return value == other.value; }
+};
+size_t copy_counted_key::n_copies = 0;
+
+struct copy_counted_hash {
+    size_t operator()(const copy_counted_key & key) const { return std::hash<int> {}(key.value); }
+};
+
+TEST(flat_unordered_map) {
+    Typegen t;
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        using Map = FlatUnorderedMap<int, int>;
+
+        size_t n = t.range(100ull);
+        size_t n_ops = t.range(3000ul);
+        Map map(n);
+        std::unordered_map<int, int> gt;
+
+        // the initial capacity already holds n elements
+        ASSERT_LE(n, static_cast<size_t>(map.bucket_count() * map.max_load_factor()));
+        size_t n_groups = map.bucket_count() / Map::GROUP_WIDTH;
+        ASSERT_EQ(map.bucket_count(), n_groups * Map::GROUP_WIDTH);
+
+        int range = static_cast<int>(t.range(10ul, 1000ul));
+        for(size_t op = 0; op < n_ops; op++) {
+            int key = t.range(-range, range);
+            int value = t.get<int>();
+            switch(t.range(0, 5)) {
+            case 0:
+            case 1: {
+                auto gt_result = gt.insert({ key, value });
+                auto result = map.insert({ key, value });
+                ASSERT_EQ(gt_result.second, result.second);
+                ASSERT_EQ(key, result.first->first);
+                ASSERT_EQ(gt_result.first->second, result.first->second);
+                break;
+            }
+            case 2:
+                gt[key] += value;
+                map[key] += value;
+                break;
+            case 3:
+                ASSERT_EQ(gt.erase(key), map.erase(key));
+                break;
+            case 4: {
+                auto it = map.find(key);
+                if(it != map.end()) {
+                    auto next = std::next(it);
+                    ASSERT_TRUE(next == map.erase(it));
+                    gt.erase(key);
+                }
+                break;
+            }
+            default: {
+                auto it = map.find(key);
+                auto gt_it = gt.find(key);
+                ASSERT_EQ(gt_it != gt.end(), it != map.end());
+                ASSERT_EQ(gt_it != gt.end(), map.contains(key));
+                if(it != map.end()) {
+                    ASSERT_EQ(gt_it->second, it->second);
+                }
+            }
+            }
+            ASSERT_EQ(gt.size(), map.size());
+            ASSERT_LE(map.load_factor(), map.max_load_factor());
+        }
+
+        // Iteration visits every element exactly once
+        size_t n_iterated = 0;
+        for(auto const & pair : map) {
+            ASSERT_EQ(gt.at(pair.first), pair.second);
+            n_iterated++;
+        }
+        ASSERT_EQ(gt.size(), n_iterated);
+
+        // Copies are independent, moves leave the source empty
+        Map copy(map);
+        copy[range + 1] = 1;
+        ASSERT_EQ(gt.size(), map.size());
+        ASSERT_FALSE(map.contains(range + 1));
+        Map moved(std::move(copy));
+        ASSERT_EQ(gt.size() + 1, moved.size());
+        ASSERT_TRUE(copy.empty());
+        ASSERT_TRUE(copy.begin() == copy.end());
+        copy = map;
+        moved = std::move(copy);
+        for(auto const & pair : gt) {
+            auto it = moved.find(pair.first);
+            ASSERT_TRUE(it != moved.end());
+            ASSERT_EQ(pair.second, it->second);
+        }
+
+        // clear keeps the slots, reserve makes the next inserts allocation-free
+        size_t capacity = map.bucket_count();
+        map.clear();
+        ASSERT_TRUE(map.empty());
+        ASSERT_EQ(capacity, map.bucket_count());
+        ASSERT_TRUE(map.begin() == map.end());
+
+        map.reserve(n_ops);
+        {
+            Memhook mh;
+            for(size_t k = 0; k < n_ops; k++) {
+                map.insert({ static_cast<int>(k), 0 });
+            }
+            ASSERT_EQ(0ULL, mh.n_allocs());
+        }
+        ASSERT_EQ(n_ops, map.size());
+    }
+
+    // Colliding keys spill over into later groups and are still found after erasures
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        FlatUnorderedMap<int, int, constant_hash> map;
+        std::unordered_map<int, int> gt;
+        size_t n_ops = t.range(500ul);
+        for(size_t op = 0; op < n_ops; op++) {
+            int key = t.range(0, 100);
+            if(t.get<bool>(0.6)) {
+                ASSERT_EQ(gt.insert({ key, key }).second, map.insert({ key, key }).second);
+            } else {
+                ASSERT_EQ(gt.erase(key), map.erase(key));
+            }
+        }
+        ASSERT_EQ(gt.size(), map.size());
+        for(int key = 0; key <= 100; key++) {
+            ASSERT_EQ(gt.count(key) == 1, map.contains(key));
+        }
+    }
+
+    // Keys are copied into the table once, and every growth after that moves them
+    {
+        FlatUnorderedMap<copy_counted_key, int, copy_counted_hash> map;
+        copy_counted_key::n_copies = 0;
+        const int n = 2000;
+        for(int k = 0; k < n; k++) {
+            map[copy_counted_key(k)] = k;
+        }
+        ASSERT_EQ(static_cast<size_t>(n), copy_counted_key::n_copies);
+        map.reserve(4 * n);
+        ASSERT_EQ(static_cast<size_t>(n), copy_counted_key::n_copies);
+        ASSERT_EQ(7, map.find(copy_counted_key(7))->second);
+    }
+}
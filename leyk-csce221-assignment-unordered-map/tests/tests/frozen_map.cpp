@@ -0,0 +1,154 @@
+#include "executable.h"
+#include "FrozenMap.h"
+
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+// trivially copyable, with padding after tag whose bytes the key does not care about
+struct padded_key {
+    char tag;
+    int id;
+};
+
+struct padded_key_hash {
+    size_t operator()(const padded_key & key) const { return std::hash<int> {}(key.id) * 31 + key.tag; }
+};
+
+struct padded_key_equal {
+    bool operator()(const padded_key & a, const padded_key & b) const { return a.tag == b.tag && a.id == b.id; }
+};
+
+// a padded_key whose padding holds fill
+padded_key make_padded_key(char tag, int id, unsigned char fill) {
+    padded_key key;
+    std::memset(&key, fill, sizeof(key));
+    key.tag = tag;
+    key.id = id;
+    return key;
+}
+
+TEST(frozen_map) {
+    Typegen t;
+
+    // Strings to numbers, read from an in-memory copy of the file
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        UnorderedMap<std::string, int> map(t.range(1ull, 100ull));
+        size_t n_pairs = t.range(500ul);
+        for(size_t k = 0; k < n_pairs; k++) {
+            std::string key(t.range(0ul, 20ul), 'a');
+            for(char & c : key) {
+                c = static_cast<char>(t.range('a', static_cast<char>('z' + 1)));
+            }
+            map.insert({ key, t.get<int>() });
+        }
+
+        std::stringstream out;
+        ASSERT_TRUE(freeze(map, out));
+        std::string file = out.str();
+        // any copy of the bytes reads the same, wherever it lands
+        std::string copy = file;
+
+        FrozenMap<std::string, int> frozen(copy.data(), copy.size());
+        ASSERT_TRUE(frozen.is_open());
+        ASSERT_EQ(map.size(), frozen.size());
+        ASSERT_LE(map.size(), frozen.bucket_count());
+        for(auto it = map.cbegin(); it != map.cend(); ++it) {
+            std::optional<int> value = frozen.find(it->first);
+            ASSERT_TRUE(value.has_value());
+            ASSERT_EQ(it->second, *value);
+        }
+        for(size_t k = 0; k < 50; k++) {
+            std::string key(t.range(21ul, 30ul), 'q');
+            ASSERT_FALSE(frozen.contains(key));
+        }
+
+        size_t n_visited = 0;
+        size_t n_wrong = 0;
+        frozen.for_each([&](std::string_view key, int value) {
+            n_visited++;
+            auto it = map.find(std::string(key));
+            n_wrong += it == map.end() || it->second != value;
+        });
+        ASSERT_EQ(map.size(), n_visited);
+        ASSERT_EQ(0ULL, n_wrong);
+
+        // damaged files do not open
+        FrozenMap<std::string, int> truncated(copy.data(), copy.size() - 1);
+        ASSERT_FALSE(truncated.is_open());
+        ASSERT_TRUE(truncated.empty());
+        ASSERT_FALSE(truncated.contains("a"));
+        copy[0] = 'X';
+        FrozenMap<std::string, int> bad_magic(copy.data(), copy.size());
+        ASSERT_FALSE(bad_magic.is_open());
+    }
+
+    // Numbers to strings, through a mapped file
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "frozen_map_test.bin";
+    for(size_t i = 0; i < TEST_ITER / 10; i++) {
+        UnorderedMap<int, std::string> map(1);
+        std::unordered_map<int, std::string> gt;
+        size_t n_pairs = t.range(5000ul);
+        for(size_t k = 0; k < n_pairs; k++) {
+            int key = t.get<int>();
+            std::string value = std::to_string(key * 3);
+            map.insert({ key, value });
+            gt.insert({ key, value });
+        }
+        ASSERT_TRUE(freeze(map, path.string()));
+
+        FrozenMap<int, std::string> frozen(path.string());
+        ASSERT_TRUE(frozen.is_open());
+        ASSERT_EQ(gt.size(), frozen.size());
+        for(auto const & pair : gt) {
+            std::optional<std::string_view> value = frozen.find(pair.first);
+            ASSERT_TRUE(value.has_value());
+            ASSERT_TRUE(pair.second == *value);
+        }
+
+        // moving hands the mapping over
+        FrozenMap<int, std::string> moved(std::move(frozen));
+        ASSERT_FALSE(frozen.is_open());
+        ASSERT_EQ(gt.size(), moved.size());
+        frozen = std::move(moved);
+        ASSERT_EQ(gt.size(), frozen.size());
+    }
+    std::filesystem::remove(path);
+
+    // Keys whose bytes are not the whole value go through Hash and Pred, not memcmp
+    {
+        static_assert(!std::has_unique_object_representations_v<padded_key>);
+        UnorderedMap<padded_key, int, padded_key_hash, padded_key_equal> map(1);
+        for(int id = 0; id < 200; id++) {
+            map.insert({ make_padded_key('p', id, 0x00), id });
+        }
+        std::stringstream out;
+        ASSERT_TRUE(freeze(map, out));
+        std::string file = out.str();
+
+        FrozenMap<padded_key, int, padded_key_hash, padded_key_equal> frozen(file.data(), file.size());
+        ASSERT_TRUE(frozen.is_open());
+        for(int id = 0; id < 200; id++) {
+            std::optional<int> value = frozen.find(make_padded_key('p', id, 0xFF));
+            ASSERT_TRUE(value.has_value());
+            ASSERT_EQ(id, *value);
+            ASSERT_FALSE(frozen.contains(make_padded_key('q', id, 0x00)));
+        }
+
+        // 0.0 and -0.0 are equal keys with different bytes
+        UnorderedMap<double, int> doubles(1);
+        doubles.insert({ 0.0, 1 });
+        doubles.insert({ 2.5, 2 });
+        std::stringstream doubles_out;
+        ASSERT_TRUE(freeze(doubles, doubles_out));
+        std::string doubles_file = doubles_out.str();
+        FrozenMap<double, int> frozen_doubles(doubles_file.data(), doubles_file.size());
+        ASSERT_EQ(1, frozen_doubles.find(-0.0).value_or(0));
+        ASSERT_EQ(2, frozen_doubles.find(2.5).value_or(0));
+    }
+
+    FrozenMap<int, int> missing((std::filesystem::temp_directory_path() / "no_such_frozen_map.bin").string());
+    ASSERT_FALSE(missing.is_open());
+}
@@ -0,0 +1,89 @@
+#include "executable.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+// counts every hash computation so the test can check iteration doesn't hash
+struct counting_hash {
+    static size_t calls;
+
+    size_t operator()(int key) const {
+        calls++;
+        return std::hash<int> {}(key);
+    }
+};
+
+size_t counting_hash::calls = 0;
+
+TEST(global_chain) {
+    Typegen t;
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        using Map = UnorderedMap<int, int, counting_hash>;
+
+        size_t n = t.range(100ull);
+        size_t n_ops = t.range(2000ul);
+        Map map(n);
+        std::unordered_map<int, int> gt;
+
+        if(t.get<bool>()) {
+            map.max_load_factor(t.range(0.5f, 2.0f));
+        }
+
+        for(size_t op = 0; op < n_ops; op++) {
+            int key = t.range(-200, 200);
+            if(t.get<bool>(0.6)) {
+                ASSERT_EQ(gt.insert({ key, op }).second, map.insert({ key, op }).second);
+            } else if(t.get<bool>()) {
+                ASSERT_EQ(gt.erase(key), map.erase(key));
+            } else {
+                auto it = map.find(key);
+                if(it != map.end()) {
+                    auto next = std::next(it);
+                    ASSERT_TRUE(next == map.erase(it));
+                    gt.erase(key);
+                }
+            }
+        }
+
+        // Walking the whole map follows the chain without hashing anything
+        size_t calls = counting_hash::calls;
+        std::vector<int> keys;
+        for(auto it = map.begin(); it != map.end(); ++it) {
+            keys.push_back(it->first);
+        }
+        ASSERT_EQ(calls, counting_hash::calls);
+        ASSERT_EQ(gt.size(), keys.size());
+
+        // The chain visits each bucket's elements in one contiguous run
+        std::unordered_set<size_t> finished;
+        for(size_t k = 0; k < keys.size(); k++) {
+            size_t bucket = map.bucket(keys[k]);
+            ASSERT_TRUE(gt.count(keys[k]) == 1);
+            ASSERT_TRUE(finished.count(bucket) == 0);
+            if(k + 1 == keys.size() || map.bucket(keys[k + 1]) != bucket) {
+                finished.insert(bucket);
+            }
+        }
+
+        // and each local range is exactly that run
+        size_t n_local = 0;
+        for(size_t bucket = 0; bucket < map.bucket_count(); bucket++) {
+            for(auto it = map.begin(bucket); it != map.end(bucket); ++it) {
+                ASSERT_EQ(bucket, map.bucket(it->first));
+                n_local++;
+            }
+        }
+        ASSERT_EQ(gt.size(), n_local);
+
+        // Copies and moves keep the chain consistent
+        Map copy(map);
+        Map moved(std::move(copy));
+        ASSERT_EQ(gt.size(), moved.size());
+        for(auto const & pair : gt) {
+            auto it = moved.find(pair.first);
+            ASSERT_TRUE(it != moved.end());
+            ASSERT_EQ(pair.second, it->second);
+        }
+        ASSERT_TRUE(copy.begin() == copy.end());
+    }
+}
@@ -0,0 +1,96 @@
+#include "executable.h"
+
+#include <unordered_map>
+
+// counts hash computations; keys that differ only in the low two bits share a code
+struct counted_hash {
+    static size_t calls;
+
+    size_t operator()(int key) const {
+        calls++;
+        return std::hash<int> {}(key / 4);
+    }
+};
+
+size_t counted_hash::calls = 0;
+
+template <>
+struct cache_hash_code<counted_hash> : std::true_type { };
+
+TEST(hash_code_cache) {
+    Typegen t;
+
+    // string hashers opt in, everything else does not
+    ASSERT_TRUE(cache_hash_code<std::hash<std::string>>::value);
+    ASSERT_TRUE(cache_hash_code<fnv1a_hash>::value);
+    ASSERT_FALSE(cache_hash_code<std::hash<int>>::value);
+
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        using Map = UnorderedMap<int, int, counted_hash>;
+
+        size_t n = t.range(100ull);
+        size_t n_ops = t.range(1000ul);
+        Map map(n);
+        std::unordered_map<int, int> gt;
+
+        if(t.get<bool>()) {
+            map.max_load_factor(t.range(0.5f, 2.0f));
+        }
+
+        for(size_t op = 0; op < n_ops; op++) {
+            int key = t.range(-300, 300);
+            size_t calls = counted_hash::calls;
+
+            switch(t.range(0, 4)) {
+            case 0:
+                ASSERT_EQ(gt.insert({ key, key }).second, map.insert({ key, key }).second);
+                break;
+            case 1:
+                ASSERT_EQ(gt.count(key) == 1, map.find(key) != map.end());
+                break;
+            case 2:
+                ASSERT_EQ(gt.erase(key), map.erase(key));
+                break;
+            default: {
+                auto it = map.find(key);
+                if(it == map.end()) {
+                    continue;
+                }
+                // erasing through an iterator reads the cached codes only
+                calls = counted_hash::calls;
+                map.erase(it);
+                gt.erase(key);
+                ASSERT_EQ(calls, counted_hash::calls);
+                continue;
+            }
+            }
+
+            // every insert, find and erase by key hashes exactly once, even across a rehash
+            ASSERT_EQ(calls + 1, counted_hash::calls);
+            ASSERT_EQ(gt.size(), map.size());
+        }
+
+        // Rehashing, iterating and walking buckets never hash
+        size_t calls = counted_hash::calls;
+        map.rehash(t.range(2000ull));
+        size_t n_local = 0;
+        for(size_t bucket = 0; bucket < map.bucket_count(); bucket++) {
+            n_local += map.bucket_size(bucket);
+        }
+        size_t n_global = 0;
+        for(auto it = map.begin(); it != map.end(); ++it) {
+            n_global++;
+        }
+        ASSERT_EQ(calls, counted_hash::calls);
+        ASSERT_EQ(gt.size(), n_local);
+        ASSERT_EQ(gt.size(), n_global);
+
+        for(auto const & pair : gt) {
+            auto it = map.find(pair.first);
+            ASSERT_TRUE(it != map.end());
+            ASSERT_EQ(pair.first, it->first);
+            size_t bucket = std::hash<int> {}(pair.first / 4) % map.bucket_count();
+            ASSERT_EQ(bucket, map.bucket(pair.first));
+        }
+    }
+}
@@ -0,0 +1,145 @@
+#include "executable.h"
+
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+
+// counts hash computations of whatever key type it is given
+struct counting_string_hash {
+    using is_transparent = void;
+    static size_t calls;
+
+    size_t operator()(std::string_view str) const {
+        calls++;
+        return std::hash<std::string_view> {}(str);
+    }
+};
+
+size_t counting_string_hash::calls = 0;
+
+// so walking a bucket reads codes instead of hashing its neighbours
+template <>
+struct cache_hash_code<counting_string_hash> : std::true_type { };
+
+TEST(heterogeneous_lookup) {
+    Typegen t;
+
+    // std::hash<std::string> and string_hash agree, so buckets don't depend on the lookup type
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        std::string key = t.get<std::string>();
+        ASSERT_EQ(std::hash<std::string> {}(key), string_hash {}(key));
+        ASSERT_TRUE(is_transparent<string_hash>::value);
+        ASSERT_FALSE(is_transparent<std::hash<std::string>>::value);
+    }
+
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        using Map = UnorderedMap<std::string, int, counting_string_hash, std::equal_to<>>;
+
+        size_t n_keys = t.range(1ul, 200ul);
+        std::vector<std::string> keys(n_keys);
+        // long enough that building a std::string would allocate
+        for(auto & key : keys) {
+            key = std::string(32, 'k') + std::to_string(t.get<int>());
+        }
+        Map map(t.range(1ull, 100ull));
+        std::unordered_map<std::string, int> gt;
+
+        for(size_t k = 0; k < n_keys; k++) {
+            size_t calls = counting_string_hash::calls;
+            bool inserted = gt.try_emplace(keys[k], k).second;
+            // try_emplace hashes once and builds the pair in the node
+            auto result = map.try_emplace(keys[k], k);
+            ASSERT_EQ(inserted, result.second);
+            ASSERT_EQ(gt[keys[k]], result.first->second);
+            ASSERT_EQ(calls + 1, counting_string_hash::calls);
+        }
+
+        // Lookups by string_view and const char * build no std::string
+        {
+            Memhook mh;
+            for(auto const & key : keys) {
+                std::string_view view = key;
+                ASSERT_TRUE(map.find(view) != map.end());
+                ASSERT_TRUE(map.contains(key.c_str()));
+                ASSERT_FALSE(map.contains(view.substr(1)));
+                ASSERT_TRUE(map.find(view.substr(1)) == map.end());
+            }
+            ASSERT_EQ(0ULL, mh.n_allocs());
+        }
+
+        // and so do the const overloads, count and equal_range, each hashing once
+        {
+            Map const & reader = map;
+            Memhook mh;
+            for(auto const & key : keys) {
+                std::string_view view = key;
+                size_t calls = counting_string_hash::calls;
+                ASSERT_TRUE(reader.find(key.c_str()) != reader.cend());
+                ASSERT_TRUE(reader.find(view.substr(1)) == reader.cend());
+                ASSERT_EQ(1ULL, reader.count(view));
+                ASSERT_EQ(0ULL, reader.count(view.substr(1)));
+                auto range = reader.equal_range(view);
+                ASSERT_TRUE(range.first == reader.find(view) && range.second == std::next(range.first));
+                ASSERT_TRUE(map.equal_range(key.c_str()).first == map.find(view));
+                ASSERT_EQ(calls + 8, counting_string_hash::calls);
+            }
+            ASSERT_EQ(0ULL, mh.n_allocs());
+        }
+
+        // operator[] hashes once whether or not the key is present, and allocates only on insertion
+        for(auto const & key : keys) {
+            size_t calls = counting_string_hash::calls;
+            Memhook mh;
+            map[key]++;
+            ASSERT_EQ(0ULL, mh.n_allocs());
+            ASSERT_EQ(calls + 1, counting_string_hash::calls);
+        }
+        {
+            std::string key = keys[0] + "new";
+            size_t calls = counting_string_hash::calls;
+            Memhook mh;
+            ASSERT_EQ(0, map[std::move(key)]);
+            // the node only; the key's buffer was moved in
+            ASSERT_EQ(1ULL, mh.n_allocs());
+            ASSERT_EQ(calls + 1, counting_string_hash::calls);
+        }
+
+        // emplace builds the element first, then keeps it or destroys it
+        {
+            size_t calls = counting_string_hash::calls;
+            auto result = map.emplace(keys[0], -1);
+            ASSERT_FALSE(result.second);
+            ASSERT_TRUE(keys[0] == result.first->first);
+            result = map.emplace(std::piecewise_construct, std::forward_as_tuple(keys[0] + "emplaced"), std::forward_as_tuple(-1));
+            ASSERT_TRUE(result.second);
+            ASSERT_EQ(-1, result.first->second);
+            ASSERT_EQ(calls + 2, counting_string_hash::calls);
+        }
+
+        // Heterogeneous erase
+        size_t size = map.size();
+        for(auto const & key : keys) {
+            if(gt.erase(key)) {
+                ASSERT_EQ(1ULL, map.erase(std::string_view(key)));
+                size--;
+            } else {
+                ASSERT_EQ(0ULL, map.erase(key.c_str()));
+            }
+            ASSERT_EQ(size, map.size());
+        }
+    }
+
+    // try_emplace leaves its arguments alone when the key is present
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        UnorderedMap<int, std::unique_ptr<int>> map(t.range(1ull, 100ull));
+        int key = t.get<int>();
+        auto value = std::make_unique<int>(key);
+        ASSERT_TRUE(map.try_emplace(key, std::move(value)).second);
+        ASSERT_TRUE(value == nullptr);
+        value = std::make_unique<int>(key + 1);
+        ASSERT_FALSE(map.try_emplace(key, std::move(value)).second);
+        ASSERT_TRUE(value != nullptr);
+        ASSERT_EQ(key, *map.find(key)->second);
+        ASSERT_TRUE(map[key + 1] == nullptr);
+    }
+}
@@ -0,0 +1,189 @@
+#include "executable.h"
+
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+// collides a lot, so buckets hold several nodes to move at once
+struct coarse_hash {
+    size_t operator()(int key) const { return std::hash<int> {}(key / 4); }
+};
+
+TEST(incremental_rehash) {
+    Typegen t;
+
+    auto check_contents = [&](auto & map, std::unordered_map<int, int> const & gt) {
+        ASSERT_EQ(gt.size(), map.size());
+        size_t n_iterated = 0;
+        for(auto const & pair : map) {
+            ASSERT_EQ(1ULL, gt.count(pair.first));
+            ASSERT_EQ(gt.at(pair.first), pair.second);
+            n_iterated++;
+        }
+        ASSERT_EQ(gt.size(), n_iterated);
+        for(auto const & pair : gt) {
+            auto it = map.find(pair.first);
+            ASSERT_TRUE(it != map.end());
+            ASSERT_EQ(pair.second, it->second);
+        }
+    };
+
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        using Map = UnorderedMap<int, int, coarse_hash>;
+
+        Map map(t.range(1ull, 20ull));
+        map.max_load_factor(t.range(0.5f, 2.0f));
+        map.incremental_rehash(true);
+        ASSERT_TRUE(map.incremental_rehash());
+        std::unordered_map<int, int> gt;
+
+        size_t n_ops = t.range(3000ul);
+        int range = static_cast<int>(t.range(10ul, 2000ul));
+        for(size_t op = 0; op < n_ops; op++) {
+            int key = t.range(-range, range);
+            int value = t.get<int>();
+            switch(t.range(0, 5)) {
+            case 0:
+            case 1: {
+                size_t bucket_count = map.bucket_count();
+                auto gt_result = gt.insert({ key, value });
+                auto result = map.insert({ key, value });
+                ASSERT_EQ(gt_result.second, result.second);
+                ASSERT_EQ(key, result.first->first);
+                ASSERT_EQ(gt_result.first->second, result.first->second);
+                // a growing insert swaps in the new table and leaves the moving to later ones
+                if(map.bucket_count() != bucket_count && bucket_count > Map::INCREMENTAL_REHASH_STEP * 10) {
+                    ASSERT_TRUE(map.rehashing());
+                }
+                break;
+            }
+            case 2:
+                gt[key] += value;
+                map[key] += value;
+                break;
+            case 3:
+                ASSERT_EQ(gt.erase(key), map.erase(key));
+                break;
+            case 4: {
+                auto it = map.find(key);
+                if(it != map.end()) {
+                    auto next = std::next(it);
+                    ASSERT_TRUE(next == map.erase(it));
+                    gt.erase(key);
+                }
+                break;
+            }
+            default:
+                ASSERT_EQ(gt.count(key) == 1, map.contains(key));
+            }
+            ASSERT_EQ(gt.size(), map.size());
+            ASSERT_LE(map.load_factor(), map.max_load_factor());
+        }
+        check_contents(map, gt);
+
+        // copies and moves carry an unfinished rehash along
+        bool rehashing = map.rehashing();
+        Map copy(map);
+        ASSERT_EQ(rehashing, copy.rehashing());
+        check_contents(copy, gt);
+        Map assigned(1);
+        assigned = map;
+        ASSERT_EQ(rehashing, assigned.rehashing());
+        check_contents(assigned, gt);
+        Map moved(std::move(copy));
+        ASSERT_EQ(rehashing, moved.rehashing());
+        ASSERT_FALSE(copy.rehashing());
+        ASSERT_TRUE(copy.empty());
+        check_contents(moved, gt);
+        copy = std::move(moved);
+        check_contents(copy, gt);
+        for(int key = range + 1; key < range + 50; key++) {
+            copy.insert({ key, 0 });
+            assigned.insert({ key, 0 });
+        }
+        ASSERT_EQ(copy.size(), assigned.size());
+
+        // the bucket interface finishes the rehash, after which every key sits in its bucket
+        size_t n_bucketed = 0;
+        for(size_t bucket = 0; bucket < map.bucket_count(); bucket++) {
+            for(auto it = map.begin(bucket); it != map.end(bucket); ++it) {
+                ASSERT_EQ(bucket, map.bucket(it->first));
+                n_bucketed++;
+            }
+        }
+        ASSERT_FALSE(map.rehashing());
+        ASSERT_EQ(gt.size(), n_bucketed);
+
+        map.clear();
+        ASSERT_FALSE(map.rehashing());
+        ASSERT_TRUE(map.begin() == map.end());
+    }
+
+    // A growing insert relinks a bounded number of nodes: it only allocates
+    // the new bucket array, and the rehash finishes over the following inserts
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        UnorderedMap<int, int> map(1);
+        map.max_load_factor(1);
+        map.incremental_rehash(true);
+        int n = static_cast<int>(t.range(1000ul, 5000ul));
+        int key = 0;
+        size_t n_growths = 0;
+        while(key < n) {
+            size_t bucket_count = map.bucket_count();
+            bool was_rehashing = map.rehashing();
+            Memhook mh;
+            map.insert({ key, key });
+            key++;
+            if(map.bucket_count() != bucket_count) {
+                n_growths++;
+                // the node and the new bucket array, plus freeing the old table of a rehash still in progress
+                ASSERT_EQ(2ULL, mh.n_allocs());
+                ASSERT_EQ(was_rehashing ? 1ULL : 0ULL, mh.n_frees());
+            }
+        }
+        ASSERT_LE(2ULL, n_growths);
+        while(map.rehashing()) {
+            map.insert({ key, key });
+            key++;
+        }
+        for(int k = 0; k < key; k++) {
+            ASSERT_EQ(k, map.find(k)->second);
+        }
+
+        // turning it off finishes the rehash
+        size_t bucket_count = map.bucket_count();
+        while(map.bucket_count() == bucket_count) {
+            map.insert({ key, key });
+            key++;
+        }
+        ASSERT_TRUE(map.rehashing());
+        map.incremental_rehash(false);
+        ASSERT_FALSE(map.rehashing());
+        ASSERT_EQ(static_cast<size_t>(key), map.size());
+    }
+
+    // print_map shows the pairs the rehash has yet to move too
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        UnorderedMap<int, int> map(t.range(1ull, 20ull));
+        map.max_load_factor(1);
+        map.incremental_rehash(true);
+        int key = 0;
+        while(key < 60 || !map.rehashing()) {
+            map.insert({ key, -key });
+            key++;
+        }
+        std::ostringstream os;
+        print_map(map, os);
+        ASSERT_TRUE(map.rehashing());
+        std::string printed = os.str();
+        size_t n_printed = 0;
+        for(char c : printed) {
+            n_printed += c == '(';
+        }
+        ASSERT_EQ(map.size(), n_printed);
+        for(int k = 0; k < key; k++) {
+            std::string pair = "(" + std::to_string(k) + ", " + std::to_string(-k) + ")";
+            ASSERT_TRUE(printed.find(pair) != std::string::npos);
+        }
+    }
+}
@@ -0,0 +1,186 @@
+#include "executable.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+// every key in one bucket
+struct constant_hash {
+    size_t operator()(int) const { return 0; }
+};
+
+// the counters are kept only on request
+template <typename Key, typename T, typename Hash = std::hash<Key>>
+using CountedMap = UnorderedMap<Key, T, Hash, std::equal_to<Key>, std::allocator<std::pair<const Key, T>>,
+                                prime_buckets, counted_stats>;
+
+TEST(map_stats) {
+    Typegen t;
+
+    // The shape matches what the bucket interface shows, and lookups count every node they look at
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        size_t n_pairs = t.range(1000ul);
+        std::vector<std::pair<int, int>> pairs(n_pairs);
+        t.fill_unique(pairs.begin(), pairs.end());
+
+        CountedMap<int, int> map(t.range(1ull, 200ull));
+        for(auto const & pair : pairs) {
+            map.insert(pair);
+        }
+
+        size_t n_empty = 0;
+        size_t max_chain = 0;
+        double sum_squares = 0;
+        std::vector<size_t> probe_histogram;
+        for(size_t bucket = 0; bucket < map.bucket_count(); bucket++) {
+            size_t length = map.bucket_size(bucket);
+            n_empty += length == 0;
+            max_chain = std::max(max_chain, length);
+            sum_squares += static_cast<double>(length) * length;
+            // the k-th key of a chain sits behind k others
+            probe_histogram.resize(std::max(probe_histogram.size(), length));
+            for(size_t k = 0; k < length; k++) {
+                probe_histogram[k]++;
+            }
+        }
+
+        map_stats stats = map.stats();
+        ASSERT_TRUE(stats.counted);
+        ASSERT_EQ(map.size(), stats.size);
+        ASSERT_EQ(map.bucket_count(), stats.bucket_count);
+        ASSERT_EQ(n_empty, stats.empty_buckets);
+        ASSERT_EQ(max_chain, stats.max_chain);
+        ASSERT_NEAR(static_cast<double>(n_empty) / map.bucket_count(), stats.empty_bucket_ratio, 1e-9);
+        ASSERT_TRUE(probe_histogram == stats.probe_histogram);
+        double mean_bucket = static_cast<double>(n_pairs) / map.bucket_count();
+        ASSERT_NEAR(sum_squares / map.bucket_count() - mean_bucket * mean_bucket, stats.bucket_variance, 1e-6);
+        if(n_pairs) {
+            size_t n_chains = map.bucket_count() - n_empty;
+            double mean = static_cast<double>(n_pairs) / n_chains;
+            ASSERT_NEAR(mean, stats.mean_chain, 1e-9);
+            ASSERT_NEAR(sum_squares / n_chains - mean * mean, stats.chain_variance, 1e-6);
+        }
+
+        // a chain of length l takes 1 + 2 + ... + l comparisons to look up each of its keys once
+        map.reset_stats();
+        ASSERT_EQ(0ULL, map.stats().lookups);
+        for(auto const & pair : pairs) {
+            ASSERT_TRUE(map.contains(pair.first));
+        }
+        stats = map.stats();
+        ASSERT_EQ(n_pairs, stats.lookups);
+        size_t comparisons = static_cast<size_t>((sum_squares + n_pairs) / 2);
+        ASSERT_EQ(comparisons, stats.comparisons);
+    }
+
+    // Growing the table counts each rehash, whether done at once or over later inserts
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        CountedMap<int, int> map(t.range(1ull, 20ull));
+        map.max_load_factor(1);
+        map.incremental_rehash(t.get<bool>());
+        map.reset_stats();
+
+        size_t n_growths = 0;
+        size_t n_pairs = t.range(2000ul);
+        for(size_t k = 0; k < n_pairs; k++) {
+            size_t bucket_count = map.bucket_count();
+            map.insert({ static_cast<int>(k), 0 });
+            n_growths += bucket_count != map.bucket_count();
+
+            // buckets still to be moved count too, so every node is in one of the chains
+            map_stats stats = map.stats();
+            ASSERT_LE(stats.max_chain, map.size());
+            ASSERT_LE(1.0, stats.mean_chain);
+        }
+        map_stats stats = map.stats();
+        ASSERT_EQ(n_growths, stats.rehashes);
+        ASSERT_LE(0.0, stats.rehash_seconds);
+        ASSERT_EQ(n_pairs, stats.lookups);
+    }
+
+    // Lookups on several threads at once, as behind a shared lock, count every one of them
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        const size_t n_threads = 4;
+        size_t n_pairs = t.range(1ul, 500ul);
+        CountedMap<int, int> map(t.range(1ull, 200ull));
+        for(size_t k = 0; k < n_pairs; k++) {
+            map.insert({ static_cast<int>(k), 0 });
+        }
+        map.reset_stats();
+
+        const CountedMap<int, int> & reader = map;
+        std::vector<std::thread> threads;
+        std::vector<size_t> n_found(n_threads, 0);
+        for(size_t tid = 0; tid < n_threads; tid++) {
+            threads.emplace_back([&, tid]() {
+                for(size_t k = 0; k < n_pairs; k++) {
+                    n_found[tid] += reader.contains(static_cast<int>(k));
+                }
+            });
+        }
+        for(std::thread & thread : threads) {
+            thread.join();
+        }
+        for(size_t found : n_found) {
+            ASSERT_EQ(n_pairs, found);
+        }
+        ASSERT_EQ(n_threads * n_pairs, map.stats().lookups);
+    }
+
+    // A hash that sends every key to one bucket stands out, a good one does not
+    {
+        CountedMap<int, int, constant_hash> bad(101);
+        CountedMap<std::string, int, fnv1a_hash> good(101);
+        for(int k = 0; k < 500; k++) {
+            bad.insert({ k, k });
+            good.insert({ std::to_string(k), k });
+        }
+        map_stats bad_stats = bad.stats();
+        ASSERT_EQ(500ULL, bad_stats.max_chain);
+        ASSERT_EQ(bad.bucket_count() - 1, bad_stats.empty_buckets);
+        ASSERT_LT(50.0, bad_stats.hash_quality);
+
+        map_stats good_stats = good.stats();
+        ASSERT_LT(0.8, good_stats.hash_quality);
+        ASSERT_LT(good_stats.hash_quality, 1.3);
+        ASSERT_LT(good_stats.max_chain, 20ULL);
+    }
+
+    // An empty map, and the JSON export
+    {
+        CountedMap<int, int> map(7);
+        map_stats stats = map.stats();
+        ASSERT_EQ(0ULL, stats.size);
+        ASSERT_EQ(0ULL, stats.max_chain);
+        ASSERT_EQ(map.bucket_count(), stats.empty_buckets);
+        ASSERT_EQ(1.0, stats.hash_quality);
+        ASSERT_TRUE(stats.probe_histogram.empty());
+        ASSERT_EQ(0.0, stats.bucket_variance);
+
+        map.insert({ 1, 2 });
+        map.find(3);
+        std::string json = map.stats().json();
+        ASSERT_EQ('{', json.front());
+        ASSERT_EQ('}', json.back());
+        ASSERT_TRUE(json.find("\"size\": 1,") != std::string::npos);
+        ASSERT_TRUE(json.find("\"probe_histogram\": [1],") != std::string::npos);
+        ASSERT_TRUE(json.find("\"lookups\": 2,") != std::string::npos);
+        ASSERT_TRUE(json.find("\"counted\": true,") != std::string::npos);
+        ASSERT_TRUE(json.find("\"rehash_seconds\": ") != std::string::npos);
+    }
+
+    // By default nothing is counted, and the map carries no counters
+    {
+        static_assert(sizeof(UnorderedMap<int, int>) < sizeof(CountedMap<int, int>));
+        UnorderedMap<int, int> map(7);
+        map.insert({ 1, 2 });
+        map.find(1);
+        map.rehash(100);
+        map_stats stats = map.stats();
+        ASSERT_FALSE(stats.counted);
+        ASSERT_EQ(1ULL, stats.size);
+        ASSERT_EQ(0ULL, stats.lookups);
+        ASSERT_EQ(0ULL, stats.comparisons);
+        ASSERT_EQ(0ULL, stats.rehashes);
+    }
+}
@@ -38,12 +38,19 @@ TEST(operator_copy) {
         ASSERT_PAIRS_FOUND_IN_CORRECT_BUCKETS(dst_shad_map, dst_map);
 
         {
+            size_t n_dst_nodes = dst_map.size();
+            size_t n_src_nodes = src_map.size();
+            bool same_buckets = dst_map.bucket_count() == src_map.bucket_count();
+
             Memhook mh;
 
             dst_map = src_map;
 
-            ASSERT_EQ(dst_shad_map.size() + 1, mh.n_frees());
-            ASSERT_EQ(src_shad_map.size() + 1, mh.n_allocs());
+            // dst's nodes are reused, and its bucket array too when the sizes match
+            size_t n_new_nodes = n_src_nodes > n_dst_nodes ? n_src_nodes - n_dst_nodes : 0;
+            size_t n_freed_nodes = n_dst_nodes > n_src_nodes ? n_dst_nodes - n_src_nodes : 0;
+            ASSERT_EQ(n_freed_nodes + !same_buckets, mh.n_frees());
+            ASSERT_EQ(n_new_nodes + !same_buckets, mh.n_allocs());
             ASSERT_EQ(src_shad_map.size(), dst_map.size());
             ASSERT_EQ(src_shad_map.bucket_count(), dst_map.bucket_count());
         }
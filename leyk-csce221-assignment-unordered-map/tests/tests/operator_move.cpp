@@ -43,6 +43,7 @@ TEST(operator_move) {
             dst_map = std::move(src_map);
 
             ASSERT_EQ(dst_shad_map.size() + 1, mh.n_frees());
+            ASSERT_EQ(0ULL, mh.n_allocs());
             ASSERT_EQ(src_shad_map.size(), dst_map.size());
             ASSERT_EQ(src_shad_map.bucket_count(), dst_map.bucket_count());
         }
@@ -65,7 +66,9 @@ TEST(operator_move) {
 
         ASSERT_PAIRS_FOUND_IN_CORRECT_BUCKETS(src_shad_map, dst_map);
 
-        shadow_map<double, double> new_src_shad(n_src);
+        // the moved-from map starts over from the smallest table
+        ASSERT_TRUE(src_map.empty());
+        shadow_map<double, double> new_src_shad(src_map.bucket_count());
 
         for(auto const & pair : new_src_pairs) {
             new_src_shad.insert(pair);
@@ -75,4 +78,49 @@ TEST(operator_move) {
         ASSERT_EQ(new_src_shad.size(), src_map.size());
         ASSERT_PAIRS_FOUND_IN_CORRECT_BUCKETS(new_src_shad, src_map);
     }
-}
\ No newline at end of file
+
+    // A moved-from map works as any empty map: it can be cleared, copied, assigned to and moved again
+    {
+        using Map = UnorderedMap<int, int>;
+        Map a(11);
+        a.max_load_factor(1);
+        a.incremental_rehash(true);
+        for(int k = 0; k < 100; k++) {
+            a.insert({ k, k });
+        }
+        Map b(std::move(a));
+        ASSERT_EQ(100ULL, b.size());
+        for(int k = 0; k < 100; k++) {
+            ASSERT_EQ(k, b.find(k)->second);
+        }
+
+        a.clear();
+        ASSERT_TRUE(a.empty());
+        ASSERT_FALSE(a.contains(1));
+        ASSERT_EQ(0ULL, a.erase(1));
+        ASSERT_EQ(0ULL, a.bucket_size(0));
+
+        Map c(a);
+        ASSERT_TRUE(c.empty());
+        a = b;
+        ASSERT_EQ(100ULL, a.size());
+        for(int k = 0; k < 100; k++) {
+            ASSERT_EQ(k, a.find(k)->second);
+        }
+
+        Map d(std::move(c));
+        d = std::move(c);
+        ASSERT_TRUE(d.empty());
+        d.insert({ 1, 1 });
+        c.insert({ 2, 2 });
+        c.rehash(50);
+        c.insert({ 3, 3 });
+        ASSERT_EQ(1ULL, d.size());
+        ASSERT_EQ(2ULL, c.size());
+        ASSERT_TRUE(d.contains(1));
+        ASSERT_TRUE(c.contains(2) && c.contains(3));
+
+        b = std::move(b);
+        ASSERT_EQ(100ULL, b.size());
+    }
+}
@@ -0,0 +1,108 @@
+#include "executable.h"
+#include "PerfectHashMap.h"
+#include "hash_functions.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+TEST(perfect_hash_map) {
+    Typegen t;
+
+    // Every built key gets its own slot below size() and maps to its value
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        UnorderedMap<int, int> map(t.range(1ull, 100ull));
+        size_t n_pairs = t.range(2000ul);
+        for(size_t k = 0; k < n_pairs; k++) {
+            map.insert({ t.get<int>(), t.get<int>() });
+        }
+
+        PerfectHashMap<int, int> perfect;
+        ASSERT_TRUE(perfect.build(map.cbegin(), map.cend()));
+        ASSERT_EQ(map.size(), perfect.size());
+
+        std::vector<bool> seen(map.size(), false);
+        size_t n_collisions = 0;
+        for(auto it = map.cbegin(); it != map.cend(); ++it) {
+            const int * value = perfect.find(it->first);
+            ASSERT_TRUE(value != nullptr);
+            ASSERT_EQ(it->second, *value);
+
+            size_t slot = perfect.index(it->first);
+            ASSERT_LT(slot, map.size());
+            n_collisions += seen[slot];
+            seen[slot] = true;
+        }
+        ASSERT_EQ(0ULL, n_collisions);
+
+        for(size_t k = 0; k < 50; k++) {
+            int key = t.get<int>();
+            ASSERT_EQ(map.contains(key), perfect.contains(key));
+        }
+
+        size_t n_iterated = 0;
+        for(const auto & pair : perfect) {
+            ASSERT_TRUE(map.contains(pair.first));
+            n_iterated++;
+        }
+        ASSERT_EQ(map.size(), n_iterated);
+    }
+
+    // The hash function itself stays a few bits per key
+    {
+        std::vector<std::pair<unsigned, unsigned>> pairs;
+        for(unsigned k = 0; k < 100000; k++) {
+            pairs.emplace_back(k, k * 3);
+        }
+        PerfectHashMap<unsigned, unsigned> perfect;
+        ASSERT_TRUE(perfect.build(pairs.begin(), pairs.end()));
+        ASSERT_LT(perfect.bits_per_key(), 4.0);
+        for(const auto & pair : pairs) {
+            ASSERT_EQ(pair.second, *perfect.find(pair.first));
+        }
+        ASSERT_FALSE(perfect.contains(100000u));
+    }
+
+    // Strings through the repo's own hashers
+    {
+        std::vector<std::pair<std::string, size_t>> pairs;
+        for(size_t k = 0; k < 5000; k++) {
+            pairs.emplace_back("key" + std::to_string(k), k);
+        }
+        PerfectHashMap<std::string, size_t, fnv1a_hash> perfect;
+        ASSERT_TRUE(perfect.build(pairs.begin(), pairs.end()));
+        for(const auto & pair : pairs) {
+            const size_t * value = perfect.find(pair.first);
+            ASSERT_TRUE(value != nullptr);
+            ASSERT_EQ(pair.second, *value);
+        }
+        ASSERT_FALSE(perfect.contains("key5000"));
+        ASSERT_FALSE(perfect.contains(""));
+    }
+
+    // Empty and single key sets
+    {
+        std::vector<std::pair<int, int>> pairs;
+        PerfectHashMap<int, int> perfect;
+        ASSERT_TRUE(perfect.build(pairs.begin(), pairs.end()));
+        ASSERT_TRUE(perfect.empty());
+        ASSERT_FALSE(perfect.contains(0));
+        ASSERT_EQ(0.0, perfect.bits_per_key());
+
+        pairs.emplace_back(7, 49);
+        ASSERT_TRUE(perfect.build(pairs.begin(), pairs.end()));
+        ASSERT_EQ(1ULL, perfect.size());
+        ASSERT_EQ(0ULL, perfect.index(7));
+        ASSERT_EQ(49, *perfect.find(7));
+        ASSERT_FALSE(perfect.contains(8));
+    }
+
+    // Repeated keys cannot get a slot each, so the build fails and leaves the map empty
+    {
+        std::vector<std::pair<int, int>> pairs = { { 1, 1 }, { 2, 2 }, { 1, 3 } };
+        PerfectHashMap<int, int> perfect;
+        ASSERT_FALSE(perfect.build(pairs.begin(), pairs.end()));
+        ASSERT_TRUE(perfect.empty());
+        ASSERT_FALSE(perfect.contains(2));
+    }
+}
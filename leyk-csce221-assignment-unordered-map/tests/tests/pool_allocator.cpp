@@ -0,0 +1,100 @@
+#include "executable.h"
+
+#include "PoolAllocator.h"
+
+#include <unordered_map>
+
+TEST(pool_allocator) {
+    Typegen t;
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        using Allocator = PoolAllocator<std::pair<const int, int>>;
+        using Map = UnorderedMap<int, int, std::hash<int>, std::equal_to<int>, Allocator>;
+
+        size_t n = t.range(1ull, 100ull);
+        size_t n_pairs = t.range(2000ul);
+        Map map(n);
+        map.max_load_factor(t.range(0.5f, 2.0f));
+        std::unordered_map<int, int> gt;
+
+        // Filling the map takes a slab now and then, not one allocation per node
+        for(size_t k = 0; k < n_pairs; k++) {
+            gt.insert({ static_cast<int>(k), static_cast<int>(k) });
+        }
+        {
+            Memhook mh;
+            size_t n_rehashes = 0;
+            for(size_t k = 0; k < n_pairs; k++) {
+                size_t bucket_count = map.bucket_count();
+                map.insert({ static_cast<int>(k), static_cast<int>(k) });
+                n_rehashes += bucket_count != map.bucket_count();
+            }
+            ASSERT_EQ(map.get_allocator().arena().n_slabs() + n_rehashes, mh.n_allocs());
+            ASSERT_LT(map.get_allocator().arena().n_slabs(), 16ULL);
+        }
+
+        // Erased nodes are recycled by later inserts without touching operator new
+        map.reserve(n_pairs);
+        std::vector<std::pair<int, bool>> ops(2 * n_pairs);
+        for(auto & op : ops) {
+            op = { t.range(0, static_cast<int>(n_pairs) + 1), t.get<bool>() };
+        }
+        {
+            Memhook mh;
+            for(auto const & [key, erase] : ops) {
+                if(erase) {
+                    map.erase(key);
+                } else {
+                    map.insert({ key, key });
+                }
+            }
+            ASSERT_LE(mh.n_allocs(), 1ULL);
+            ASSERT_EQ(0ULL, mh.n_frees());
+        }
+        for(auto const & [key, erase] : ops) {
+            if(erase) {
+                gt.erase(key);
+            } else {
+                gt.insert({ key, key });
+            }
+        }
+        ASSERT_EQ(gt.size(), map.size());
+        for(auto const & pair : gt) {
+            auto it = map.find(pair.first);
+            ASSERT_TRUE(it != map.end());
+            ASSERT_EQ(pair.second, it->second);
+        }
+
+        // Copies share the arena, so a copy's nodes come from the same slabs
+        Map copy(map);
+        ASSERT_TRUE(copy.get_allocator() == map.get_allocator());
+        ASSERT_TRUE(Map(1).get_allocator() != map.get_allocator());
+        Map moved(std::move(copy));
+        ASSERT_EQ(gt.size(), moved.size());
+        copy = std::move(moved);
+        ASSERT_EQ(gt.size(), copy.size());
+    }
+
+    // clear frees every node with one walk and no lookups; the default allocator frees each node
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        size_t n_pairs = t.range(1000ul);
+        UnorderedMap<int, int> map(t.range(1ull, 100ull));
+        for(size_t k = 0; k < n_pairs; k++) {
+            map.insert({ static_cast<int>(k), 0 });
+        }
+        size_t bucket_count = map.bucket_count();
+        {
+            Memhook mh;
+            map.clear();
+            ASSERT_EQ(n_pairs, mh.n_frees());
+            ASSERT_EQ(0ULL, mh.n_allocs());
+        }
+        ASSERT_TRUE(map.empty());
+        ASSERT_TRUE(map.begin() == map.end());
+        ASSERT_EQ(bucket_count, map.bucket_count());
+        for(size_t bucket = 0; bucket < bucket_count; bucket++) {
+            ASSERT_EQ(0ULL, map.bucket_size(bucket));
+        }
+        map.insert({ 1, 1 });
+        ASSERT_EQ(1ULL, map.size());
+    }
+}
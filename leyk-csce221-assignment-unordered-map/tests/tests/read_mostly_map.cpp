@@ -0,0 +1,183 @@
+#include "executable.h"
+#include "ReadMostlyMap.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+TEST(read_mostly_map) {
+    Typegen t;
+
+    // Batches publish exactly what an unordered_map would hold
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        ReadMostlyMap<int, int> map(t.range(20ull));
+        std::unordered_map<int, int> gt;
+        auto reader = map.reader();
+
+        size_t n_batches = t.range(50ul);
+        int range = static_cast<int>(t.range(10ul, 500ul));
+        for(size_t batch_i = 0; batch_i < n_batches; batch_i++) {
+            size_t n_ops = t.range(20ul);
+            std::unordered_map<int, int> before = gt;
+            map.update([&](ReadMostlyMap<int, int>::Batch & batch) {
+                for(size_t op = 0; op < n_ops; op++) {
+                    int key = t.range(-range, range);
+                    if(t.get<bool>(0.7)) {
+                        int value = t.get<int>();
+                        ASSERT_EQ(gt.insert_or_assign(key, value).second, batch.insert_or_assign(key, value));
+                    } else {
+                        ASSERT_EQ(gt.erase(key), batch.erase(key));
+                    }
+                    const int * value = batch.find(key);
+                    ASSERT_EQ(gt.count(key) == 1, value != nullptr);
+                    ASSERT_EQ(gt.size(), batch.size());
+
+                    // readers keep seeing the last published snapshot until the batch is done
+                    ASSERT_EQ(before.size(), reader.size());
+                    ASSERT_EQ(before.count(key) == 1, reader.contains(key));
+                }
+            });
+
+            ASSERT_EQ(gt.size(), reader.size());
+            for(int key = -range; key <= range; key++) {
+                std::optional<int> value = reader.find(key);
+                ASSERT_EQ(gt.count(key) == 1, value.has_value());
+                if(value) {
+                    ASSERT_EQ(gt.at(key), *value);
+                }
+            }
+            ASSERT_LE(gt.size(), map.bucket_count());
+        }
+
+        size_t n_visited = 0;
+        size_t n_wrong = 0;
+        reader.for_each([&](int key, int value) {
+            n_visited++;
+            n_wrong += gt.count(key) == 0 || gt.at(key) != value;
+        });
+        ASSERT_EQ(gt.size(), n_visited);
+        ASSERT_EQ(0ULL, n_wrong);
+
+        // with no reader inside a snapshot, publishing frees every old one
+        ASSERT_EQ(0ULL, map.retired_count());
+        ASSERT_EQ(true, map.insert_or_assign(range + 1, 1));
+        ASSERT_EQ(1ULL, map.erase(range + 1));
+        ASSERT_EQ(0ULL, map.retired_count());
+    }
+
+    // Unchanged buckets are shared: a one-key batch copies the bucket array and one chain
+    {
+        ReadMostlyMap<int, int> map;
+        map.update([](ReadMostlyMap<int, int>::Batch & batch) {
+            for(int key = 0; key < 10000; key++) {
+                batch.insert_or_assign(key, key);
+            }
+        });
+        Memhook mh;
+        map.insert_or_assign(42, 0);
+        // the snapshot, its bucket array, the chain and the chain's entries
+        ASSERT_EQ(4ULL, mh.n_allocs());
+    }
+
+    // A batch that throws publishes nothing, and its chains can still all be freed
+    {
+        Memhook mh;
+        {
+            ReadMostlyMap<int, int> map;
+            for(int key = 0; key < 100; key++) {
+                map.insert_or_assign(key, key);
+            }
+            bool threw = false;
+            try {
+                map.update([](ReadMostlyMap<int, int>::Batch & batch) {
+                    batch.insert_or_assign(1, -1);
+                    batch.insert_or_assign(1000, 0);
+                    throw std::runtime_error("update failed");
+                });
+            } catch(const std::runtime_error &) {
+                threw = true;
+            }
+            ASSERT_TRUE(threw);
+            auto reader = map.reader();
+            ASSERT_EQ(100ULL, reader.size());
+            ASSERT_EQ(1, *reader.find(1));
+            ASSERT_FALSE(reader.find(1000).has_value());
+            map.insert_or_assign(2, -2);
+            ASSERT_EQ(-2, *reader.find(2));
+        }
+        ASSERT_EQ(mh.n_allocs(), mh.n_frees());
+    }
+
+    // A snapshot being read is kept until its reader is done with it
+    {
+        ReadMostlyMap<int, int> map;
+        auto reader = map.reader();
+        map.insert_or_assign(1, 1);
+        size_t n_retired = 0;
+        reader.for_each([&](int, int) {
+            map.insert_or_assign(2, 2);
+            map.insert_or_assign(3, 3);
+            n_retired = map.retired_count();
+        });
+        ASSERT_EQ(2ULL, n_retired);
+        map.reclaim();
+        ASSERT_EQ(0ULL, map.retired_count());
+        ASSERT_EQ(3ULL, reader.size());
+    }
+
+    // Concurrent readers always see a value some batch wrote, and every batch whole
+    for(size_t i = 0; i < 4; i++) {
+        const size_t n_readers = 3;
+        const size_t n_reads = 0x4000;
+        const int n_keys = 256;
+
+        ReadMostlyMap<int, int> map;
+        std::atomic<size_t> bad_reads { 0 };
+        std::atomic<bool> done { false };
+
+        std::vector<std::thread> threads;
+        for(size_t tid = 0; tid < n_readers; tid++) {
+            threads.emplace_back([&, tid]() {
+                Typegen tt(tid + 1);
+                auto reader = map.reader();
+                for(size_t op = 0; op < n_reads; op++) {
+                    int key = tt.range(0, n_keys);
+                    std::optional<int> value = reader.find(key);
+                    if(value && *value % n_keys != key) {
+                        bad_reads++;
+                    }
+                }
+                // each batch writes every key with the same generation
+                int generation = -1;
+                reader.for_each([&](int key, int value) {
+                    if(generation == -1) {
+                        generation = value / n_keys;
+                    }
+                    bad_reads += value != generation * n_keys + key;
+                });
+            });
+        }
+
+        std::thread writer([&]() {
+            for(int generation = 0; !done; generation++) {
+                map.update([&](ReadMostlyMap<int, int>::Batch & batch) {
+                    for(int key = 0; key < n_keys; key++) {
+                        batch.insert_or_assign(key, generation * n_keys + key);
+                    }
+                });
+            }
+        });
+
+        for(std::thread & thread : threads) {
+            thread.join();
+        }
+        done = true;
+        writer.join();
+
+        ASSERT_EQ(0ULL, bad_reads.load());
+        map.reclaim();
+        ASSERT_EQ(0ULL, map.retired_count());
+    }
+}
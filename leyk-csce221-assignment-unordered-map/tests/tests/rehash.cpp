@@ -0,0 +1,93 @@
+#include "executable.h"
+
+#include <cmath>
+#include <unordered_map>
+
+TEST(rehash) {
+    Typegen t;
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        using Map = UnorderedMap<double, double>;
+
+        size_t n_pairs = t.range(1000ul);
+        std::vector<std::pair<double, double>> pairs(n_pairs);
+        t.fill_unique(pairs.begin(), pairs.end());
+
+        size_t n = t.range(100ull);
+        float ml = t.range(0.25f, 4.0f);
+
+        // Without a max load factor the bucket count never changes
+        {
+            Map map(n);
+            ASSERT_TRUE(std::isinf(map.max_load_factor()));
+            for(auto const & pair : pairs) {
+                map.insert(pair);
+            }
+            ASSERT_EQ(next_greater_prime(n), map.bucket_count());
+        }
+
+        Map map(n);
+        map.max_load_factor(ml);
+        ASSERT_EQ(ml, map.max_load_factor());
+
+        std::unordered_map<double, const std::pair<const double, double> *> addresses;
+        for(auto const & pair : pairs) {
+            size_t bucket_count = map.bucket_count();
+            {
+                Memhook mh;
+                auto result = map.insert(pair);
+                ASSERT_TRUE(result.second);
+
+                // one node, plus one bucket array swapped in if the table grew
+                if(map.bucket_count() == bucket_count) {
+                    ASSERT_EQ(1ULL, mh.n_allocs());
+                    ASSERT_EQ(0ULL, mh.n_frees());
+                } else {
+                    ASSERT_LT(bucket_count, map.bucket_count());
+                    ASSERT_EQ(2ULL, mh.n_allocs());
+                    ASSERT_EQ(1ULL, mh.n_frees());
+                }
+            }
+            ASSERT_LE(map.load_factor(), ml);
+            addresses[pair.first] = &(*map.find(pair.first));
+        }
+
+        // Nodes were relinked, not reallocated, and sit in their new buckets
+        size_t n_iterated = 0;
+        for(auto it = map.begin(); it != map.end(); ++it, ++n_iterated) {
+            ASSERT_EQ(addresses[it->first], &(*it));
+            ASSERT_EQ(correct_bucket<Map>(it->first, map.bucket_count()), map.bucket(it->first));
+        }
+        ASSERT_EQ(n_pairs, n_iterated);
+
+        // rehash never goes below what the max load factor needs
+        size_t count = t.range(2000ull);
+        map.rehash(count);
+        size_t needed = static_cast<size_t>(std::ceil(n_pairs / ml));
+        ASSERT_EQ(next_greater_prime(std::max(count, needed)), map.bucket_count());
+        ASSERT_LE(map.load_factor(), ml);
+        for(auto const & pair : pairs) {
+            auto it = map.find(pair.first);
+            ASSERT_TRUE(it != map.end());
+            ASSERT_EQ(addresses[pair.first], &(*it));
+            ASSERT_EQ(pair.second, it->second);
+        }
+
+        // Lowering the max load factor grows the table immediately
+        map.max_load_factor(ml / 2);
+        ASSERT_LE(map.load_factor(), ml / 2);
+
+        // After reserve, inserting that many elements doesn't rehash
+        Map reserved(n);
+        reserved.max_load_factor(ml);
+        reserved.reserve(n_pairs);
+        size_t bucket_count = reserved.bucket_count();
+        {
+            Memhook mh;
+            for(auto const & pair : pairs) {
+                reserved.insert(pair);
+            }
+            ASSERT_EQ(n_pairs, mh.n_allocs());
+        }
+        ASSERT_EQ(bucket_count, reserved.bucket_count());
+    }
+}
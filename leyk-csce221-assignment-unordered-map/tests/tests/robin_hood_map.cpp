@@ -0,0 +1,171 @@
+#include "executable.h"
+
+#include "RobinHoodMap.h"
+
+#include <numeric>
+#include <unordered_map>
+
+// keys that differ only in the low three bits share a home bucket
+struct clustering_hash {
+    size_t operator()(int key) const { return std::hash<int> {}(key / 8); }
+};
+
+// counts its copies, so shifting and rehashing can be checked to move keys
+struct copy_counted_key {
+    static size_t n_copies;
+    int value;
+
+    explicit copy_counted_key(int v) : value(v) { }
+    copy_counted_key(const copy_counted_key & other) : value(other.value) { n_copies++; }
+    copy_counted_key(copy_counted_key && other) noexcept : value(other.value) { }
+    copy_counted_key & operator=(const copy_counted_key & other) {
+        value = other.value;
+        n_copies++;
+        return *this;
+    }
+    copy_counted_key & operator=(copy_counted_key && other) noexcept {
+        value = other.value;
+        return *this;
+    }
+    bool operator==(const copy_counted_key & other) const { return value == other.value; }
+};
+size_t copy_counted_key::n_copies = 0;
+
+struct copy_counted_hash {
+    size_t operator()(const copy_counted_key & key) const { return clustering_hash {}(key.value); }
+};
+
+TEST(robin_hood_map) {
+    Typegen t;
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        using Map = RobinHoodMap<int, int, clustering_hash>;
+
+        size_t n = t.range(100ull);
+        size_t n_ops = t.range(3000ul);
+        Map map(n);
+        std::unordered_map<int, int> gt;
+
+        ASSERT_EQ(next_greater_prime(n), map.bucket_count());
+        ASSERT_EQ(0.9f, map.max_load_factor());
+        if(t.get<bool>()) {
+            map.max_load_factor(t.range(0.5f, 0.95f));
+        }
+
+        int range = static_cast<int>(t.range(10ul, 1000ul));
+        for(size_t op = 0; op < n_ops; op++) {
+            int key = t.range(-range, range);
+            int value = t.get<int>();
+            switch(t.range(0, 5)) {
+            case 0:
+            case 1: {
+                auto gt_result = gt.insert({ key, value });
+                auto result = map.insert({ key, value });
+                ASSERT_EQ(gt_result.second, result.second);
+                ASSERT_EQ(key, result.first->first);
+                ASSERT_EQ(gt_result.first->second, result.first->second);
+                break;
+            }
+            case 2:
+                gt[key] += value;
+                map[key] += value;
+                break;
+            case 3:
+                ASSERT_EQ(gt.erase(key), map.erase(key));
+                break;
+            case 4: {
+                auto it = map.find(key);
+                if(it != map.end()) {
+                    ASSERT_EQ(gt.at(key), it->second);
+                }
+                ASSERT_EQ(gt.count(key) == 1, it != map.end());
+                ASSERT_EQ(gt.count(key) == 1, map.contains(key));
+                break;
+            }
+            default:
+                // backward-shift deletion leaves nothing behind that a lookup must skip
+                if(!map.empty() && map.find(key) != map.end()) {
+                    map.erase(map.find(key));
+                    gt.erase(key);
+                    ASSERT_FALSE(map.contains(key));
+                }
+            }
+            ASSERT_EQ(gt.size(), map.size());
+            ASSERT_LE(map.load_factor(), map.max_load_factor());
+        }
+
+        // Every element is counted once by the buckets and once by the histogram
+        size_t n_bucketed = 0;
+        for(size_t bucket = 0; bucket < map.bucket_count(); bucket++) {
+            n_bucketed += map.bucket_size(bucket);
+        }
+        ASSERT_EQ(gt.size(), n_bucketed);
+        std::vector<size_t> histogram = map.probe_histogram();
+        ASSERT_EQ(gt.size(), std::accumulate(histogram.begin(), histogram.end(), size_t(0)));
+        if(!histogram.empty()) {
+            ASSERT_NE(0ULL, histogram.back());
+        }
+        for(auto const & pair : gt) {
+            size_t home = clustering_hash {}(pair.first) % map.bucket_count();
+            ASSERT_EQ(home, map.bucket(pair.first));
+        }
+
+        // Copies are independent, moves leave the source empty
+        Map copy(map);
+        copy[range + 1] = 1;
+        ASSERT_FALSE(map.contains(range + 1));
+        Map moved(std::move(copy));
+        ASSERT_EQ(gt.size() + 1, moved.size());
+        ASSERT_TRUE(copy.empty());
+        ASSERT_TRUE(copy.begin() == copy.end());
+        copy[range + 2] = 2;
+        ASSERT_EQ(1ULL, copy.size());
+        moved = map;
+        copy = std::move(moved);
+        for(auto const & pair : gt) {
+            auto it = copy.find(pair.first);
+            ASSERT_TRUE(it != copy.end());
+            ASSERT_EQ(pair.second, it->second);
+        }
+
+        // Erasing while iterating visits each element once, even as runs shift back
+        size_t n_before = map.size();
+        size_t n_visited = 0;
+        for(auto it = map.begin(); it != map.end(); n_visited++) {
+            ASSERT_EQ(1ULL, gt.count(it->first));
+            if(it->first % 2) {
+                gt.erase(it->first);
+                it = map.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        ASSERT_EQ(n_before, n_visited);
+        ASSERT_EQ(gt.size(), map.size());
+        for(auto const & pair : map) {
+            ASSERT_EQ(gt.at(pair.first), pair.second);
+        }
+
+        map.clear();
+        ASSERT_TRUE(map.empty());
+        ASSERT_TRUE(map.begin() == map.end());
+        ASSERT_TRUE(map.probe_histogram().empty());
+    }
+
+    // Keys are copied into the table once; shifts on insert and erase, and rehashes, move them
+    {
+        RobinHoodMap<copy_counted_key, int, copy_counted_hash> map(1);
+        copy_counted_key::n_copies = 0;
+        const int n = 2000;
+        for(int k = 0; k < n; k++) {
+            map[copy_counted_key(k)] = k;
+        }
+        ASSERT_EQ(static_cast<size_t>(n), copy_counted_key::n_copies);
+        for(int k = 0; k < n; k += 2) {
+            ASSERT_EQ(1ULL, map.erase(copy_counted_key(k)));
+        }
+        map.rehash(4 * n);
+        ASSERT_EQ(static_cast<size_t>(n), copy_counted_key::n_copies);
+        ASSERT_EQ(static_cast<size_t>(n / 2), map.size());
+        ASSERT_EQ(1, map.find(copy_counted_key(1))->second);
+    }
+}
@@ -0,0 +1,96 @@
+#include "executable.h"
+
+#include <iterator>
+#include <unordered_map>
+
+// counts hash computations, with or without cached codes
+template <bool Cached>
+struct copy_counting_hash {
+    static size_t calls;
+
+    size_t operator()(int key) const {
+        calls++;
+        return std::hash<int> {}(key);
+    }
+};
+
+template <bool Cached>
+size_t copy_counting_hash<Cached>::calls = 0;
+
+template <>
+struct cache_hash_code<copy_counting_hash<true>> : std::true_type { };
+
+TEST(structural_copy) {
+    Typegen t;
+
+    auto check_copies = [&](auto cached) {
+        constexpr bool Cached = decltype(cached)::value;
+        using Hash = copy_counting_hash<Cached>;
+        using Map = UnorderedMap<int, int, Hash>;
+
+        size_t n_pairs = t.range(1000ul);
+        Map map(t.range(1ull, 100ull));
+        if(t.get<bool>()) {
+            map.max_load_factor(t.range(0.5f, 2.0f));
+        }
+        for(size_t k = 0; k < n_pairs; k++) {
+            int key = t.range(-2000, 2000);
+            map.insert({ key, key });
+        }
+
+        // A copy has the same chain order and buckets, hashing nothing with cached codes
+        // and each key at most once otherwise
+        size_t calls = Hash::calls;
+        Map copy(map);
+        if(Cached) {
+            ASSERT_EQ(calls, Hash::calls);
+        } else {
+            ASSERT_LE(Hash::calls, calls + map.size());
+        }
+        ASSERT_EQ(map.size(), copy.size());
+        ASSERT_EQ(map.bucket_count(), copy.bucket_count());
+        for(auto it = map.begin(), cit = copy.begin(); it != map.end(); ++it, ++cit) {
+            ASSERT_TRUE(cit != copy.end());
+            ASSERT_EQ(it->first, cit->first);
+            ASSERT_EQ(it->second, cit->second);
+            ASSERT_NE(&(*it), &(*cit));
+        }
+        for(size_t bucket = 0; bucket < map.bucket_count(); bucket++) {
+            ASSERT_EQ(map.bucket_size(bucket), copy.bucket_size(bucket));
+            for(auto it = copy.begin(bucket); it != copy.end(bucket); ++it) {
+                ASSERT_EQ(bucket, copy.bucket(it->first));
+            }
+        }
+
+        // Copy-assigning over a map rewrites its nodes in place
+        Map dst(map.bucket_count());
+        size_t n_dst = t.range(2 * n_pairs + 1);
+        for(size_t k = 0; k < n_dst; k++) {
+            dst.insert({ static_cast<int>(k) + 5000, 0 });
+        }
+        std::unordered_map<const void *, bool> dst_nodes;
+        for(auto const & pair : dst) {
+            dst_nodes[&pair] = true;
+        }
+        dst = map;
+        size_t n_reused = 0;
+        for(auto const & pair : dst) {
+            n_reused += dst_nodes.count(&pair);
+            ASSERT_EQ(pair.second, map.find(pair.first)->second);
+        }
+        ASSERT_EQ(std::min(n_dst, map.size()), n_reused);
+        ASSERT_EQ(map.size(), dst.size());
+
+        // and both maps stay independent afterwards
+        dst.insert({ 9000, 1 });
+        copy.clear();
+        ASSERT_FALSE(map.contains(9000));
+        ASSERT_EQ(map.size() + 1, dst.size());
+        ASSERT_EQ(map.size(), static_cast<size_t>(std::distance(map.begin(), map.end())));
+    };
+
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        check_copies(std::true_type {});
+        check_copies(std::false_type {});
+    }
+}
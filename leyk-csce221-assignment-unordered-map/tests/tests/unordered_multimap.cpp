@@ -0,0 +1,138 @@
+#include "executable.h"
+
+#include "UnorderedMultiMap.h"
+
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+// collides a lot, so runs of equal keys share their buckets with other keys
+struct coarse_multi_hash {
+    size_t operator()(int key) const { return std::hash<int> {}(key / 4); }
+};
+
+TEST(unordered_multimap) {
+    Typegen t;
+
+    using Map = UnorderedMultiMap<int, int, coarse_multi_hash>;
+
+    auto check_contents = [&](Map const & map, std::unordered_multimap<int, int> const & gt) {
+        ASSERT_EQ(gt.size(), map.size());
+        // equal keys form one run: a key whose run has ended never comes back
+        std::set<int> finished;
+        size_t n_iterated = 0;
+        for(auto it = map.cbegin(); it != map.cend(); ++it) {
+            ASSERT_EQ(0ULL, finished.count(it->first));
+            auto next = std::next(it);
+            if(next == map.cend() || next->first != it->first) {
+                finished.insert(it->first);
+            }
+            n_iterated++;
+        }
+        ASSERT_EQ(gt.size(), n_iterated);
+        for(int key : finished) {
+            auto range = map.equal_range(key);
+            auto gt_range = gt.equal_range(key);
+            std::vector<int> values, gt_values;
+            for(auto it = range.first; it != range.second; ++it) {
+                ASSERT_EQ(key, it->first);
+                values.push_back(it->second);
+            }
+            for(auto it = gt_range.first; it != gt_range.second; ++it) {
+                gt_values.push_back(it->second);
+            }
+            std::sort(values.begin(), values.end());
+            std::sort(gt_values.begin(), gt_values.end());
+            ASSERT_TRUE(values == gt_values);
+            ASSERT_EQ(gt.count(key), map.count(key));
+        }
+    };
+
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        Map map(t.range(1ull, 20ull));
+        map.max_load_factor(t.range(0.5f, 2.0f));
+        map.incremental_rehash(t.get<bool>());
+        std::unordered_multimap<int, int> gt;
+
+        size_t n_ops = t.range(2000ul);
+        int range = static_cast<int>(t.range(5ul, 200ul));
+        for(size_t op = 0; op < n_ops; op++) {
+            int key = t.range(-range, range);
+            int value = t.get<int>();
+            switch(t.range(0, 7)) {
+            case 0:
+            case 1:
+            case 2: {
+                // a present key is always inserted again
+                auto it = map.insert({ key, value });
+                gt.insert({ key, value });
+                ASSERT_EQ(key, it->first);
+                ASSERT_EQ(value, it->second);
+                break;
+            }
+            case 3: {
+                auto it = map.emplace(key, value);
+                gt.emplace(key, value);
+                ASSERT_EQ(key, it->first);
+                break;
+            }
+            case 4:
+                // every element with the key goes at once
+                ASSERT_EQ(gt.erase(key), map.erase(key));
+                ASSERT_EQ(0ULL, map.count(key));
+                break;
+            case 5: {
+                auto it = map.find(key);
+                ASSERT_EQ(gt.count(key) > 0, it != map.end());
+                if(it != map.end()) {
+                    auto gt_it = gt.equal_range(key).first;
+                    while(gt_it->second != it->second) {
+                        ++gt_it;
+                    }
+                    gt.erase(gt_it);
+                    ASSERT_TRUE(std::next(it) == map.erase(it));
+                }
+                break;
+            }
+            case 6: {
+                // a node taken out and put back joins its key's run again
+                auto nh = map.extract(key);
+                ASSERT_EQ(gt.count(key) == 0, nh.empty());
+                if(!nh.empty()) {
+                    ASSERT_EQ(key, nh.key());
+                    auto it = map.insert(std::move(nh));
+                    ASSERT_TRUE(nh.empty());
+                    ASSERT_EQ(key, it->first);
+                }
+                break;
+            }
+            }
+        }
+        check_contents(map, gt);
+
+        map.rehash(t.range(1ull, 500ull));
+        check_contents(map, gt);
+        map.incremental_rehash(false);
+        check_contents(map, gt);
+
+        Map copy(map);
+        check_contents(copy, gt);
+
+        // merging moves every node over, equal keys included
+        Map source(t.range(1ull, 20ull));
+        for(size_t j = 0, n = t.range(200ul); j < n; j++) {
+            int key = t.range(-range, range);
+            int value = t.get<int>();
+            source.insert({ key, value });
+            gt.insert({ key, value });
+        }
+        map.merge(source);
+        ASSERT_TRUE(source.empty());
+        check_contents(map, gt);
+
+        Map moved(std::move(map));
+        check_contents(moved, gt);
+    }
+}
@@ -0,0 +1,94 @@
+#include "executable.h"
+
+#include "UnorderedSet.h"
+
+#include <type_traits>
+#include <unordered_set>
+
+TEST(unordered_set) {
+    Typegen t;
+
+    // elements are the keys alone, and cannot be changed through an iterator
+    static_assert(std::is_same<UnorderedSet<int>::value_type, int>::value);
+    static_assert(std::is_same<UnorderedSet<int>::iterator, UnorderedSet<int>::const_iterator>::value);
+    static_assert(std::is_const<std::remove_reference_t<decltype(*std::declval<UnorderedSet<int>::iterator>())>>::value);
+
+    for(size_t i = 0; i < TEST_ITER; i++) {
+        UnorderedSet<int> set(t.range(1ull, 50ull));
+        set.max_load_factor(t.range(0.5f, 2.0f));
+        set.incremental_rehash(t.get<bool>());
+        std::unordered_set<int> gt;
+
+        size_t n_ops = t.range(2000ul);
+        int range = static_cast<int>(t.range(10ul, 1000ul));
+        for(size_t op = 0; op < n_ops; op++) {
+            int key = t.range(-range, range);
+            switch(t.range(0, 5)) {
+            case 0:
+            case 1: {
+                auto gt_result = gt.insert(key);
+                auto result = set.insert(key);
+                ASSERT_EQ(gt_result.second, result.second);
+                ASSERT_EQ(key, *result.first);
+                break;
+            }
+            case 2: {
+                auto result = set.emplace(key);
+                ASSERT_EQ(gt.insert(key).second, result.second);
+                ASSERT_EQ(key, *result.first);
+                break;
+            }
+            case 3:
+                ASSERT_EQ(gt.erase(key), set.erase(key));
+                break;
+            case 4: {
+                auto it = set.find(key);
+                ASSERT_EQ(gt.count(key) == 1, it != set.end());
+                ASSERT_EQ(gt.count(key), set.count(key));
+                auto range = set.equal_range(key);
+                ASSERT_TRUE(range.first == it);
+                if(it != set.end()) {
+                    ASSERT_TRUE(range.second == std::next(it));
+                    ASSERT_TRUE(std::next(it) == set.erase(it));
+                    gt.erase(key);
+                } else {
+                    ASSERT_TRUE(range.second == set.end());
+                }
+                break;
+            }
+            }
+        }
+
+        ASSERT_EQ(gt.size(), set.size());
+        size_t n_iterated = 0;
+        for(int key : set) {
+            ASSERT_EQ(1ULL, gt.count(key));
+            n_iterated++;
+        }
+        ASSERT_EQ(gt.size(), n_iterated);
+
+        // copies, moves and merges go through the same engine as the map's
+        UnorderedSet<int> copy(set);
+        ASSERT_EQ(set.size(), copy.size());
+        UnorderedSet<int> other(t.range(1ull, 50ull));
+        for(int key = -range; key <= range; key += 3) {
+            other.insert(key);
+        }
+        size_t n_other = other.size();
+        size_t n_shared = 0;
+        for(int key : other) {
+            n_shared += set.contains(key);
+        }
+        set.merge(other);
+        ASSERT_EQ(n_shared, other.size());
+        ASSERT_EQ(gt.size() + n_other - n_shared, set.size());
+        for(int key : other) {
+            ASSERT_TRUE(set.contains(key));
+        }
+        UnorderedSet<int> moved(std::move(copy));
+        ASSERT_EQ(gt.size(), moved.size());
+        for(int key : gt) {
+            ASSERT_TRUE(moved.contains(key));
+        }
+    }
+}